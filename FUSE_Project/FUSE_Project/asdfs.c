@@ -1,17 +1,302 @@
 #include "asdfs.h"
 #include "asdfs_internal.h"
+#include "asdfs_copy.h"
+#include "asdfs_journal.h"
+#include "asdfs_ioctl.h"
+#include <limits.h>
+
+#define JOURNAL_COMPACT_MIN 65536 // 이미지 파일 없이 journal을 현재 상태로 다시 쓰기 시작하는 최소 기록 개수
+
+static struct asdfs_config config; // fuse_main에서 전달된 설정
+static int read_splice;             // 읽기 응답을 splice로 보낼 수 있는지 여부
+static int image_volume;            // 이미지 파일을 볼륨으로 사용하는지 여부
+static unsigned long journal_growth; // 마지막으로 journal을 다시 쓴 뒤 추가한 기록 개수
+static pthread_mutex_t compact_lock = PTHREAD_MUTEX_INITIALIZER; // journal 다시 쓰기 한 번에 하나만
+
+// dir 아래 (path는 dir의 path, length는 그 길이) inode를 다시 만드는 기록을 journal에 추가
+// 디렉터리의 시간은 자식을 만든 뒤에 복원
+static void snapshot_dir(inode *dir, char *path, size_t length) {
+    for (inode *child = get_inode(dir->firstChild); child; child = get_inode(child->rightSibling)) {
+        size_t end = length + 1 + child->nameLength;
+        if (end >= PATH_MAX) {
+            fprintf(stderr, "asdfs_snapshot: path too long under %s\n", path);
+            continue;
+        }
+        path[length] = '/';
+        memcpy(path + length + 1, get_name(child), child->nameLength);
+        path[end] = '\0';
+
+        inode_cold *cold = get_cold(child);
+        journal_record rec = { .mode = child->mode, .uid = child->uid, .gid = child->gid, .rdev = cold->rdev,
+                               .size = cold->size, .atime = cold->atime, .mtime = cold->mtime, .path = path };
+        if (child->mode & S_IFDIR) {
+            rec.op = JOURNAL_MKDIR;
+            journal_append(&rec);
+            snapshot_dir(child, path, end);
+            path[end] = '\0';
+        }
+        else {
+            rec.op = JOURNAL_MKNOD;
+            journal_append(&rec);
+            if (cold->size > 0) {
+                rec.op = JOURNAL_TRUNCATE;
+                journal_append(&rec);
+            }
+        }
+        rec.op = JOURNAL_UTIMENS;
+        journal_append(&rec);
+    }
+    path[length] = '\0';
+}
+
+// 이미지 파일 없이 journal만 사용하면 기록이 계속 늘어나므로
+// 추가한 기록이 파일 개수의 2배 (최소 JOURNAL_COMPACT_MIN)를 넘으면 현재 이름 공간을 다시 만드는 기록을 추가하고
+// 그 앞의 기록을 journal에서 제거 (이미지 파일을 사용하면 checkpoint와 unmount에서 제거)
+static void compact_journal() {
+    unsigned long limit = 2 * (unsigned long)get_superblock().f_files;
+    if (image_volume || journal_growth < (limit > JOURNAL_COMPACT_MIN ? limit : JOURNAL_COMPACT_MIN)
+        || pthread_mutex_trylock(&compact_lock) != 0) {
+        return;
+    }
+
+    // 기록하는 동안 이름 공간 변경 대기
+    CHECKPOINT_HOLD();
+    NAMESPACE_WRITE();
+    uint64_t last = journal_last();
+    inode *root = get_root();
+    inode_cold *cold = get_cold(root);
+    static char path[PATH_MAX];
+    strcpy(path, "/");
+    journal_record rec = { .op = JOURNAL_CHMOD, .mode = root->mode, .uid = root->uid, .gid = root->gid,
+                           .atime = cold->atime, .mtime = cold->mtime, .path = path };
+    journal_append(&rec);
+    rec.op = JOURNAL_CHOWN;
+    journal_append(&rec);
+    snapshot_dir(root, path, 0);
+    strcpy(path, "/");
+    rec.op = JOURNAL_UTIMENS;
+    uint64_t end = journal_append(&rec);
+    journal_growth = 0;
+    namespace_release(&namespace_held);
+
+    // 다시 만드는 기록이 디스크에 기록된 뒤 그 앞의 기록 제거
+    if (journal_commit(end) == 0) {
+        journal_trim(last);
+        fprintf(stderr, "asdfs_journal compacted at %lu\n", (unsigned long)end);
+    }
+    pthread_mutex_unlock(&compact_lock);
+}
 
-// max: a, b 중 최댓값 반환하는 매크로
-#define max(a,b) ((a)>(b)?(a):(b))
+// 메타데이터 변경 rec를 journal에 추가하고, 이름 공간 잠금 held를 푼 뒤 디스크에 기록될 때까지 대기
+// 기록 번호는 변경을 적용한 잠금 안에서 정해지므로 journal 순서는 적용 순서와 같음
+// 동시에 요청된 변경은 fdatasync 한 번으로 함께 기록
+// 변경은 이미 적용되었으므로 디스크 기록에 실패해도 0 반환 (이후 fsync가 -EIO 반환)
+// journal을 사용하지 않으면 바로 0 반환
+static int log_change(journal_record rec, int *held) {
+    if (!journal_active()) {
+        return 0;
+    }
+    uint64_t lsn = journal_append(&rec);
+    set_applied_lsn(lsn);
+    namespace_release(held);
+    if (journal_commit(lsn) != 0) {
+        fprintf(stderr, "asdfs_journal_commit %lu %s: not durable\n", (unsigned long)lsn, rec.path);
+    }
+    __sync_fetch_and_add(&journal_growth, 1);
+    compact_journal();
+    return 0;
+}
+
+// 쓰기로 before보다 늘어난 node의 크기를 journal에 추가 (디스크에는 fsync나 다음 변경과 함께 기록)
+static void log_extend(const char *path, inode *node, off_t before) {
+    off_t size = get_cold(node)->size;
+    if (!journal_active() || size <= before) {
+        return;
+    }
+    journal_record rec = { .op = JOURNAL_EXTEND, .size = size, .path = path };
+    set_applied_lsn(journal_append(&rec));
+    __sync_fetch_and_add(&journal_growth, 1);
+}
+
+// journal 기록 rec를 볼륨에 다시 적용 (asdfs_init)
+static void replay_change(const journal_record *rec) {
+    struct timespec tv[2] = { { rec->atime, 0 }, { rec->mtime, 0 } };
+    struct stat attr;
+    int result;
+
+    switch (rec->op) {
+        case JOURNAL_MKDIR:      // 디렉터리 생성 후 소유자, 생성 시간 복원
+            result = asdfs_mkdir(rec->path, rec->mode);
+            if (result == 0) {
+                asdfs_chown(rec->path, rec->uid, rec->gid);
+                asdfs_utimens(rec->path, tv);
+            }
+            break;
+
+        case JOURNAL_MKNOD:      // 파일 생성 후 소유자, 생성 시간 복원
+            result = asdfs_mknod(rec->path, rec->mode, (dev_t)rec->rdev);
+            if (result == 0) {
+                asdfs_chown(rec->path, rec->uid, rec->gid);
+                asdfs_utimens(rec->path, tv);
+            }
+            break;
+
+        case JOURNAL_UNLINK:     // 파일 삭제
+            result = asdfs_unlink(rec->path);
+            break;
+
+        case JOURNAL_RMDIR:      // 디렉터리 삭제
+            result = asdfs_rmdir(rec->path);
+            break;
+
+        case JOURNAL_RENAME:     // 파일 이동
+            result = asdfs_rename(rec->path, rec->newpath);
+            break;
+
+        case JOURNAL_CHMOD:      // 파일 권한 변경
+            result = asdfs_chmod(rec->path, rec->mode);
+            break;
+
+        case JOURNAL_CHOWN:      // 파일 소유자 변경
+            result = asdfs_chown(rec->path, rec->uid, rec->gid);
+            break;
+
+        case JOURNAL_TRUNCATE:   // 파일 크기 변경
+            result = asdfs_truncate(rec->path, rec->size);
+            break;
+
+        case JOURNAL_UTIMENS:    // 시간 변경
+            result = asdfs_utimens(rec->path, tv);
+            break;
+
+        case JOURNAL_EXTEND:     // 쓰기로 늘어난 파일 크기 (이미 더 크면 그대로)
+            result = asdfs_getattr(rec->path, &attr);
+            if (result == 0 && attr.st_size < rec->size) {
+                result = asdfs_truncate(rec->path, rec->size);
+            }
+            break;
+
+        default:                 // 알 수 없는 기록
+            result = -EINVAL;
+            break;
+    }
+
+    if (result != 0) {
+        fprintf(stderr, "asdfs_replay %lu op %d %s: %d\n", (unsigned long)rec->lsn, rec->op, rec->path, result);
+    }
+    set_applied_lsn(rec->lsn);
+}
+
+// 디스크에 기록되지 않은 메타데이터 변경을 기록
+// journal을 사용하면 journal, 아니면 이미지 파일의 메타데이터 영역
+static int sync_changes() {
+    if (journal_active()) {
+        return journal_commit(journal_last()) == 0 ? 0 : -EIO;
+    }
+    return sync_volume() == NO_ERROR ? 0 : -EIO;
+}
+
+// 이미지 파일을 볼륨으로 사용 (마운트 전에 호출)
+// checkpoint가 0이 아니면 checkpoint초마다 바뀐 부분만 이미지 파일에 기록
+int asdfs_open_image (const char *path, unsigned checkpoint) {
+    fprintf(stderr, "asdfs_open_image %s %u\n", path, checkpoint);
+
+    // 이미지 파일 mapping, 없으면 생성
+    asdfs_errno code = open_volume(path, checkpoint);
+    if (code != NO_ERROR) {
+        return -1;
+    }
+    image_volume = 1;
+    return 0;
+}
+
+// 블록 전체를 쓸 때 같은 내용의 블록을 공유 (이미지 파일을 열기 전에 호출), 실패하면 -1 반환
+int asdfs_enable_dedup () {
+    fprintf(stderr, "asdfs_enable_dedup\n");
+
+    // 내용 hash 색인 생성, 이미지 파일은 열 때 이전 색인을 다시 생성
+    return enable_dedup() == NO_ERROR ? 0 : -1;
+}
+
+// interval초 동안 읽거나 쓰지 않은 블록을 백그라운드에서 압축 (이미지 파일을 열기 전에 호출), 실패하면 -1 반환
+int asdfs_enable_compress (unsigned interval) {
+    fprintf(stderr, "asdfs_enable_compress %u\n", interval);
+
+    // 블록별 마지막 사용 시간 배열 생성, 압축 스레드는 asdfs_init에서 시작
+    return enable_compress(interval) == NO_ERROR ? 0 : -1;
+}
+
+// 블록 메모리가 budget MB를 넘으면 오래 쓰지 않은 블록을 dir의 파일 (dir이 NULL이면 이미지 파일)로 내림
+// 이미지 파일을 열기 전에 호출, 실패하면 -1 반환
+int asdfs_enable_spill (const char *dir, unsigned budget) {
+    fprintf(stderr, "asdfs_enable_spill %s %u\n", dir ? dir : "(image)", budget);
+
+    // 블록별 상태 배열 생성, 블록을 내리는 스레드는 asdfs_init에서 시작
+    return enable_spill(dir, budget) == NO_ERROR ? 0 : -1;
+}
+
+// 메타데이터 변경을 journal 파일에 기록 (마운트 전에 호출), 실패하면 -1 반환
+int asdfs_open_journal (const char *path) {
+    fprintf(stderr, "asdfs_open_journal %s\n", path);
+
+    // journal 파일 열기, 기록은 asdfs_init에서 다시 적용
+    return journal_open(path);
+}
 
 // 파일 시스템 초기화
 void *asdfs_init (struct fuse_conn_info *conn) {
     fprintf(stderr, "asdfs_init\n");
 
     // 내부 root/superblock 초기화 함수 호출
-    init_root_superblock();
+    struct fuse_context *context = fuse_get_context();
+    init_root_superblock(context->uid, context->gid, context->umask);
+
+    // journal에서 볼륨에 반영되지 않은 변경을 다시 적용
+    // 권한은 기록할 때 확인했으므로 생략하고, 소유자 변경을 위해 superuser로 호출
+    struct fuse_context caller = *context;
+    context->uid = 0;
+    context->gid = 0;
+    set_replay(1);
+    unsigned long replayed = journal_replay(get_applied_lsn(), replay_change);
+    set_replay(0);
+    *context = caller;
+    if (replayed > 0) {
+        fprintf(stderr, "asdfs_init journal replayed %lu\n", replayed);
+    }
+
+    // 주기적으로 바뀐 부분만 이미지 파일에 기록, 기록된 변경은 journal에서 제거
+    start_checkpoint(journal_trim);
+
+    // 오래 사용하지 않은 블록을 주기적으로 압축
+    start_compress();
+
+    // 블록 메모리가 예산을 넘으면 오래 사용하지 않은 블록을 파일로 내림
+    start_spill();
+
+    // fuse_main에서 전달된 설정 복사
+    if (context->private_data) {
+        config = *(struct asdfs_config *)context->private_data;
+    }
+
+    // 쓰기 요청의 데이터를 /dev/fuse에서 pipe로 splice하여 write_buf로 전달
+    // 읽기 응답은 read_buf가 가리키는 블록 영역 fd에서 /dev/fuse로 splice
+    conn->want |= conn->capable & (FUSE_CAP_SPLICE_READ | FUSE_CAP_SPLICE_MOVE | FUSE_CAP_SPLICE_WRITE);
+    read_splice = (conn->want & FUSE_CAP_SPLICE_WRITE) != 0;
 
-    return NULL;
+    return context->private_data;
+}
+
+// 파일 시스템 해제
+void asdfs_destroy (void *private_data) {
+    fprintf(stderr, "asdfs_destroy\n");
+
+    // 이미지 파일을 사용하면 디스크에 기록
+    close_volume();
+
+    // 이미지 파일에 모든 변경이 기록되었으므로 journal 비우기
+    if (image_volume) {
+        journal_reset();
+    }
 }
 
 // 파일 시스템 정보 조회
@@ -21,6 +306,48 @@ int asdfs_statfs (const char *path, struct statvfs *buf) {
     // 내부 superblock 메타데이터 반환
     *buf = get_superblock();
 
+    // dentry cache 통계 출력
+    dcache_stats stats = get_dcache_stats();
+    fprintf(stderr, "asdfs_statfs dcache hit %lu negative %lu miss %lu held %lu\n", stats.hit, stats.negative, stats.miss, stats.held);
+
+    // supplementary groups cache 통계 출력
+    cred_stats cstats = get_cred_stats();
+    fprintf(stderr, "asdfs_statfs groups hit %lu miss %lu\n", cstats.hit, cstats.miss);
+
+    // 데이터 복사, hash 방식 출력
+    fprintf(stderr, "asdfs_statfs copy %s hash %s\n", copy_engine_name(), hash_engine_name());
+
+    // 블록 사용량 출력: 파일 기준 (logical)과 볼륨 기준 (physical), 공유와 중복 제거로 줄어든 비율
+    dedup_stats dstats = get_dedup_stats();
+    fprintf(stderr, "asdfs_statfs blocks logical %lu physical %lu ratio %.2f dedup hashed %lu hit %lu indexed %lu\n",
+            (unsigned long)dstats.logical, (unsigned long)dstats.physical, dstats.ratio,
+            dstats.hashed, dstats.hit, dstats.indexed);
+
+    // 블록 압축 통계 출력
+    zip_stats zstats = get_zip_stats();
+    fprintf(stderr, "asdfs_statfs compress blocks %lu bytes %lu packs %lu cache hit %lu miss %lu expanded %lu moved %lu\n",
+            zstats.blocks, (unsigned long)zstats.bytes, zstats.packs, zstats.hit, zstats.miss, zstats.expanded, zstats.moved);
+
+    // 블록 내보내기 통계 출력
+    spill_stats sstats = get_spill_stats();
+    fprintf(stderr, "asdfs_statfs spill budget %lu resident %lu out %lu spilled %lu fetched %lu passes %lu\n",
+            (unsigned long)sstats.budget, (unsigned long)sstats.resident, sstats.out, sstats.spilled, sstats.fetched, sstats.passes);
+
+    // journal 통계 출력
+    journal_stats jstats = get_journal_stats();
+    fprintf(stderr, "asdfs_statfs journal records %lu commits %lu syncs %lu\n", jstats.records, jstats.commits, jstats.syncs);
+
+    // checkpoint 통계 출력
+    checkpoint_stats kstats = get_checkpoint_stats();
+    fprintf(stderr, "asdfs_statfs checkpoint cycles %lu bytes %lu last %lu B %.3f ms stall %.3f ms max stall %.3f ms\n",
+            kstats.cycles, (unsigned long)kstats.bytes, (unsigned long)kstats.lastBytes,
+            kstats.lastMs, kstats.lastStallMs, kstats.maxStallMs);
+
+    // inode 할당 통계 출력
+    inode_stats istats = get_inode_stats();
+    fprintf(stderr, "asdfs_statfs inodes live %lu cached %lu free %lu slabs %lu released %lu\n",
+            istats.live, istats.cached, istats.free, istats.slabs, istats.released);
+
     return 0;
 }
 
@@ -28,6 +355,9 @@ int asdfs_statfs (const char *path, struct statvfs *buf) {
 int asdfs_getattr (const char *path, struct stat *buf) {
     fprintf(stderr, "asdfs_getattr %s\n", path);
 
+    // path 검색이 끝날 때까지 이름 공간 변경 대기
+    NAMESPACE_READ();
+
     // path에 해당하는 inode 검색
     search_result res;
     asdfs_errno code = find_inode(path, &res);
@@ -53,7 +383,7 @@ int asdfs_getattr (const char *path, struct stat *buf) {
     }
 
     // exact의 attr 구조체 반환
-    *buf = res.exact->attr;
+    *buf = get_attr(res.exact);
     return 0;
 }
 
@@ -61,6 +391,10 @@ int asdfs_getattr (const char *path, struct stat *buf) {
 int asdfs_mkdir (const char *path, mode_t mode) {
     fprintf(stderr, "asdfs_mkdir %s %X\n", path, mode);
 
+    // 변경이 끝날 때까지 checkpoint, 다른 요청의 이름 검색과 변경 대기
+    CHECKPOINT_HOLD();
+    NAMESPACE_WRITE();
+
     // 현재 fuse context 가져오기. 호출 프로세스의 uid, gid.
     struct fuse_context *context = fuse_get_context();
 
@@ -112,7 +446,7 @@ int asdfs_mkdir (const char *path, mode_t mode) {
 
     // 새로운 inode 생성
     inode *node = NULL;
-    code = create_inode(path, attr, &node);
+    code = create_inode(&res, attr, &node);
 
     // code 주요 오류 번호 검사
     switch (code & 0xFFFF) {
@@ -128,13 +462,21 @@ int asdfs_mkdir (const char *path, mode_t mode) {
 
     // 새로운 inode를 res 위치에 삽입
     insert_inode(res, node);
-    return 0;
+
+    // journal에 기록
+    journal_record rec = { .op = JOURNAL_MKDIR, .mode = mode, .uid = attr.st_uid, .gid = attr.st_gid,
+                           .atime = now.tv_sec, .mtime = now.tv_sec, .path = path };
+    return log_change(rec, &namespace_held);
 }
 
 // 디렉터리 삭제
 int asdfs_rmdir (const char *path) {
     fprintf(stderr, "asdfs_rmdir %s\n", path);
 
+    // 변경이 끝날 때까지 checkpoint, 다른 요청의 이름 검색과 변경 대기
+    CHECKPOINT_HOLD();
+    NAMESPACE_WRITE();
+
     // path에 해당하는 inode 검색
     search_result res;
     asdfs_errno code = find_inode(path, &res);
@@ -167,7 +509,7 @@ int asdfs_rmdir (const char *path) {
     // inode 상태 검사
     inode *exact = res.exact;
 
-    if (!(exact->attr.st_mode & S_IFDIR)) { // exact가 디렉터리가 아닌 경우
+    if (!(exact->mode & S_IFDIR)) { // exact가 디렉터리가 아닌 경우
         return -ENOTDIR;                    // Not a directory
     }
 
@@ -175,15 +517,22 @@ int asdfs_rmdir (const char *path) {
         return -ENOTEMPTY;              // Directory not empty
     }
 
-    // inode 삭제
+    // dentry cache 항목 무효화 후 inode 삭제
+    dcache_invalidate(path);
     destroy_inode(exact);
-    return 0;
+
+    // journal에 기록
+    journal_record rec = { .op = JOURNAL_RMDIR, .path = path };
+    return log_change(rec, &namespace_held);
 }
 
 // 디렉터리 열기
 int asdfs_opendir (const char *path, struct fuse_file_info *fi) {
     fprintf(stderr, "asdfs_opendir %s\n", path);
 
+    // path 검색이 끝날 때까지 이름 공간 변경 대기
+    NAMESPACE_READ();
+
     // path에 해당하는 inode 검색
     search_result res;
     asdfs_errno code = find_inode(path, &res);
@@ -211,7 +560,7 @@ int asdfs_opendir (const char *path, struct fuse_file_info *fi) {
     // inode 상태 검사
     inode *exact = res.exact;
 
-    if (!(exact->attr.st_mode & S_IFDIR)) { // exact가 디렉터리가 아닌 경우
+    if (!(exact->mode & S_IFDIR)) { // exact가 디렉터리가 아닌 경우
         return -ENOTDIR;                    // Not a directory
     }
 
@@ -229,22 +578,43 @@ int asdfs_opendir (const char *path, struct fuse_file_info *fi) {
 int asdfs_readdir (const char *path, void *buf, fuse_fill_dir_t filer, off_t off, struct fuse_file_info *fi) {
     fprintf(stderr, "asdfs_readdir %s\n", path);
 
+    // 목록을 다 읽을 때까지 이름 공간 변경 대기
+    NAMESPACE_READ();
+
     // asdfs_opendir에서 전달된 file handle 확인
     inode *node = (inode *)fi->fh;
     if (node == NULL) {
         return -EIO;
     }
 
+    // off 다음 항목부터 filer의 buf가 찰 때까지 전달
+    // 각 항목의 offset은 다음 readdir에서 이어서 읽을 위치 (cookie)
+
+    // 이어지는 child 정보 조회 시 tree 탐색을 생략하도록 디렉터리 고정
+    if (config.listing_cache) {
+        dcache_hold(path, node);
+    }
+
     // ".", ".."
-    filer(buf, ".", NULL, 0);
-    filer(buf, "..", NULL, 0);
+    struct stat attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.st_mode = S_IFDIR;
+    if (off < 1 && filer(buf, ".", &attr, 1)) {
+        return 0;
+    }
+    if (off < 2 && filer(buf, "..", &attr, 2)) {
+        return 0;
+    }
     
-    // node의 firstChild부터 rightSibling을 child로 따라가며 반복
-    inode *child = node->firstChild;
+    // off 다음 child부터 rightSibling을 따라가며 반복
+    inode *child = seek_child(node, off);
     while (child) {
-        // child name 전달
-        filer(buf, child->name, NULL, 0);
-        child = child->rightSibling;
+        // child name 및 attr 구조체 전달, buf가 가득 차면 중단
+        attr = get_attr(child);
+        if (filer(buf, get_name(child), &attr, child_cookie(child))) {
+            break;
+        }
+        child = get_inode(child->rightSibling);
     }
     
     return 0;
@@ -254,6 +624,10 @@ int asdfs_readdir (const char *path, void *buf, fuse_fill_dir_t filer, off_t off
 int asdfs_mknod (const char *path, mode_t mode, dev_t rdev) {
     fprintf(stderr, "asdfs_mknod %s %X\n", path, mode);
 
+    // 변경이 끝날 때까지 checkpoint, 다른 요청의 이름 검색과 변경 대기
+    CHECKPOINT_HOLD();
+    NAMESPACE_WRITE();
+
     // 요청 상태 검사
     if (!(mode & S_IFREG)) { // 요청된 파일 mode가 일반 파일이 아닌 경우
         return -ENOSYS;      // Function not implemented
@@ -310,7 +684,7 @@ int asdfs_mknod (const char *path, mode_t mode, dev_t rdev) {
 
     // 새로운 inode 생성
     inode *node = NULL;
-    code = create_inode(path, attr, &node);
+    code = create_inode(&res, attr, &node);
 
     // code 주요 오류 번호 검사
     switch (code & 0xFFFF) {
@@ -343,13 +717,21 @@ int asdfs_mknod (const char *path, mode_t mode, dev_t rdev) {
     
     // 새로운 inode를 res 위치에 삽입
     insert_inode(res, node);
-    return 0;
+
+    // journal에 기록
+    journal_record rec = { .op = JOURNAL_MKNOD, .mode = mode, .uid = attr.st_uid, .gid = attr.st_gid, .rdev = rdev,
+                           .atime = now.tv_sec, .mtime = now.tv_sec, .path = path };
+    return log_change(rec, &namespace_held);
 }
 
 // 생성 및 수정 시간 변경
 int asdfs_utimens (const char *path, const struct timespec tv[2]) {
     fprintf(stderr, "asdfs_utimens %s\n", path);
 
+    // 변경이 끝날 때까지 checkpoint 대기, 같은 파일의 다른 변경과 journal 순서를 맞추도록 이름 공간 잠금
+    CHECKPOINT_HOLD();
+    NAMESPACE_WRITE();
+
     // path에 해당하는 inode 검색
     search_result res;
     asdfs_errno code = find_inode(path, &res);
@@ -376,15 +758,23 @@ int asdfs_utimens (const char *path, const struct timespec tv[2]) {
 
     // inode에 주어진 시간 값 저장
     inode *exact = res.exact;
-    exact->attr.st_atime = tv[0].tv_sec; // 파일 최근 사용 시간
-    exact->attr.st_mtime = tv[1].tv_sec; // 파일 최근 수정 시간
-    return 0;
+    get_cold(exact)->atime = tv[0].tv_sec; // 파일 최근 사용 시간
+    get_cold(exact)->mtime = tv[1].tv_sec; // 파일 최근 수정 시간
+    dirty_inode(exact);
+
+    // journal에 기록
+    journal_record rec = { .op = JOURNAL_UTIMENS, .atime = tv[0].tv_sec, .mtime = tv[1].tv_sec, .path = path };
+    return log_change(rec, &namespace_held);
 }
 
 // 파일 삭제
 int asdfs_unlink (const char *path) {
     fprintf(stderr, "asdfs_unlink %s\n", path);
 
+    // 변경이 끝날 때까지 checkpoint, 다른 요청의 이름 검색과 변경 대기
+    CHECKPOINT_HOLD();
+    NAMESPACE_WRITE();
+
     // path에 해당하는 inode 검색
     search_result res;
     asdfs_errno code = find_inode(path, &res);
@@ -414,15 +804,22 @@ int asdfs_unlink (const char *path) {
         return -EACCES;                 // Permission denied
     }
 
-    // inode 삭제
+    // dentry cache 항목 무효화 후 inode 삭제
+    dcache_invalidate(path);
     destroy_inode(res.exact);
-    return 0;
+
+    // journal에 기록
+    journal_record rec = { .op = JOURNAL_UNLINK, .path = path };
+    return log_change(rec, &namespace_held);
 }
 
 // 파일 열기
 int asdfs_open (const char *path, struct fuse_file_info *fi) {
     fprintf(stderr, "asdfs_open %s\n", path);
 
+    // path 검색이 끝날 때까지 이름 공간 변경 대기
+    NAMESPACE_READ();
+
     // path에 해당하는 inode 검색
     search_result res;
     asdfs_errno code = find_inode(path, &res);
@@ -450,7 +847,7 @@ int asdfs_open (const char *path, struct fuse_file_info *fi) {
     // inode 상태 검사
     inode *exact = res.exact;
 
-    if (exact->attr.st_mode & S_IFDIR) { // exact가 디렉터리인 경우
+    if (exact->mode & S_IFDIR) { // exact가 디렉터리인 경우
         return -EISDIR;                  // Is a directory
     }
 
@@ -482,29 +879,109 @@ int asdfs_read (const char *path, char *mem, size_t size, off_t off, struct fuse
         return -EIO;
     }
 
-    if (node->attr.st_mode & S_IFDIR) { // node가 디렉터리인 경우
+    if (node->mode & S_IFDIR) { // node가 디렉터리인 경우
         return -EISDIR;                 // Is a directory
     }
 
-    void *data = node->data;
-    if (data == NULL) { // 할당된 data가 없을 경우
-        return -EIO;    // Input/output error
+    // data의 offset부터 (offset + size)까지 mem으로 복사
+    // 파일 크기를 넘는 부분은 읽지 않음
+    size_t length = read_data_inode(node, mem, size, off);
+
+    // 읽은 바이트 수 반환
+    return (int)length;
+}
+
+// node data의 off부터 size 바이트를 버퍼 하나로 복사한 fuse_bufvec을 *bufp에 전달
+static int read_buf_copy(inode *node, struct fuse_bufvec **bufp, size_t size, off_t off) {
+    struct fuse_bufvec *vec = (struct fuse_bufvec *)malloc(sizeof(struct fuse_bufvec));
+    char *mem = (char *)malloc(size ? size : 1);
+    if (vec == NULL || mem == NULL) {
+        free(vec);
+        free(mem);
+        return -ENOMEM;          // Out of memory
     }
+    *vec = (struct fuse_bufvec)FUSE_BUFVEC_INIT(read_data_inode(node, mem, size, off));
+    vec->buf[0].mem = mem;
+    *bufp = vec;
+    return 0;
+}
 
-    // data의 offset부터 (offset + size)까지 mem으로 복사
-    char *ptr = (char *)data + off;
-    for (size_t i=0; i<size; i++) {
-        mem[i] = ptr[i];
+// 파일 읽기 (fuse_bufvec)
+int asdfs_read_buf (const char *path, struct fuse_bufvec **bufp, size_t size, off_t off, struct fuse_file_info *fi) {
+    fprintf(stderr, "asdfs_read_buf %s %zu %zu\n", path, size, off);
+
+    // asdfs_open에서 전달된 file handle 확인
+    inode *node = (inode *)fi->fh;
+    if (node == NULL) {
+        return -EIO;
     }
 
-    // 읽은 바이트 수 반환
-    return (int)size;
+    if (node->mode & S_IFDIR) { // node가 디렉터리인 경우
+        return -EISDIR;                 // Is a directory
+    }
+
+    // 파일 크기를 넘는 부분은 읽지 않음
+    off_t file_size = get_cold(node)->size;
+    if (off >= file_size) {
+        size = 0;
+    }
+    else if ((off_t)size > file_size - off) {
+        size = (size_t)(file_size - off);
+    }
+
+    // splice할 수 없으면 버퍼 하나로 복사
+    if (!read_splice) {
+        return read_buf_copy(node, bufp, size, off);
+    }
+
+    // data의 offset부터 (offset + size)까지 블록 영역의 (fd, 위치)를 복사하지 않고 전달
+    int count = (int)(size / DATA_BLOCK_SIZE) + 2;
+    struct fuse_bufvec *vec = (struct fuse_bufvec *)malloc(sizeof(struct fuse_bufvec) + sizeof(struct fuse_buf) * (count - 1));
+    if (vec == NULL) {
+        return -ENOMEM;              // Out of memory
+    }
+    *vec = (struct fuse_bufvec)FUSE_BUFVEC_INIT(0);
+    struct fuse_buf *bufs = vec->buf;
+    count = map_buf_data_inode(node, off, size, bufs, count);
+    vec->count = count;
+
+    // 압축된 블록은 가리킬 수 없으므로 버퍼 하나로 복사
+    if (fuse_buf_size(vec) < size) {
+        free(vec);
+        return read_buf_copy(node, bufp, size, off);
+    }
+
+    // libfuse가 응답 후 메모리 버퍼를 free하므로 메모리를 가리키는 부분 (hole 등)은 복사본으로 교체
+    for (int i=0; i<count; i++) {
+        if (!(bufs[i].flags & FUSE_BUF_IS_FD)) {
+            void *mem = malloc(bufs[i].size);
+            if (mem == NULL) {
+                vec->count = i;
+                for (int j=0; j<i; j++) {
+                    if (!(bufs[j].flags & FUSE_BUF_IS_FD)) {
+                        free(bufs[j].mem);
+                    }
+                }
+                free(vec);
+                return -ENOMEM;      // Out of memory
+            }
+            memcpy(mem, bufs[i].mem, bufs[i].size);
+            bufs[i].mem = mem;
+        }
+    }
+
+    *bufp = vec;
+    return 0;
 }
 
 // 이미 있는 파일 크기 변경
 int asdfs_truncate (const char *path, off_t size) {
     fprintf(stderr, "asdfs_truncate %s %zu\n", path, size);
 
+    // 변경이 끝날 때까지 checkpoint 대기, 같은 파일의 다른 변경과 journal 순서를 맞추도록 이름 공간 잠금
+    CHECKPOINT_HOLD();
+    NAMESPACE_WRITE();
+
     // path에 해당하는 inode 검색
     search_result res;
     asdfs_errno code = find_inode(path, &res);
@@ -540,7 +1017,7 @@ int asdfs_truncate (const char *path, off_t size) {
     // code 주요 오류 번호 검사
     switch (code & 0xFFFF) {
         case NO_ERROR:           // 오류 없음
-            return 0;            // 완료
+            break;               // 계속 진행 ->
 
         case NO_FREE_SPACE:      // 남은 용량 없음
             return -ENOSPC;      // No space left on device
@@ -548,21 +1025,37 @@ int asdfs_truncate (const char *path, off_t size) {
         default:                 // 그 외
             return -EIO;         // Input/output error
     }
+
+    // journal에 기록
+    journal_record rec = { .op = JOURNAL_TRUNCATE, .size = size, .path = path };
+    return log_change(rec, &namespace_held);
 }
 
 // 파일 쓰기
 int asdfs_write (const char *path, const char *mem, size_t size, off_t off, struct fuse_file_info *fi) {
     fprintf(stderr, "asdfs_write %s %zu %zu\n", path, size, off);
 
+    // 변경이 끝날 때까지 checkpoint 대기, 늘어난 크기를 기록할 때까지 크기를 바꾸는 다른 요청 대기
+    CHECKPOINT_HOLD();
+    NAMESPACE_READ();
+
     // asdfs_open에서 전달된 file handle 확인
     inode *node = (inode *)fi->fh;
     if (node == NULL) {
         return -EIO;
     }
     
-    // node에 data 공간 할당
-    // 쓰기에서 요청한 (off + size)와 파일 크기 중 큰 것 선택
-    asdfs_errno code = alloc_data_inode(node, max(node->attr.st_size, off + size));
+    // data의 offset부터 (offset + size)까지 data로 복사
+    // 쓰기에서 요청한 (off + size)가 파일 크기보다 크면 크기 증가
+    size_t written;
+    off_t before = get_cold(node)->size;
+    asdfs_errno code = write_data_inode(node, mem, size, off, &written);
+    log_extend(path, node, before);
+
+    // 일부라도 썼으면 쓴 바이트 수 반환 (남은 부분을 다시 요청하면 오류 반환)
+    if (written > 0) {
+        return (int)written;
+    }
 
     // code 주요 오류 번호 검사
     switch (code & 0xFFFF) {
@@ -576,20 +1069,260 @@ int asdfs_write (const char *path, const char *mem, size_t size, off_t off, stru
             return -EIO;         // Input/output error
     }
 
-    // data의 offset부터 (offset + size)까지 data로 복사
-    char *ptr = (char *)(node->data) + off;
-    for (size_t i=0; i<size; i++) {
-        ptr[i] = mem[i];
+    // 쓴 바이트 수 반환
+    return (int)written;
+}
+
+// 파일 쓰기 (fuse_bufvec)
+int asdfs_write_buf (const char *path, struct fuse_bufvec *buf, off_t off, struct fuse_file_info *fi) {
+    fprintf(stderr, "asdfs_write_buf %s %zu %zu\n", path, fuse_buf_size(buf), off);
+
+    // 변경이 끝날 때까지 checkpoint 대기, 늘어난 크기를 기록할 때까지 크기를 바꾸는 다른 요청 대기
+    CHECKPOINT_HOLD();
+    NAMESPACE_READ();
+
+    // asdfs_open에서 전달된 file handle 확인
+    inode *node = (inode *)fi->fh;
+    if (node == NULL) {
+        return -EIO;
+    }
+
+    // buf의 내용을 data의 offset부터 블록으로 바로 복사
+    // 쓰기에서 요청한 (off + size)가 파일 크기보다 크면 크기 증가
+    size_t written;
+    off_t before = get_cold(node)->size;
+    asdfs_errno code = write_buf_data_inode(node, buf, off, &written);
+    log_extend(path, node, before);
+
+    // 일부라도 썼으면 쓴 바이트 수 반환 (남은 부분을 다시 요청하면 오류 반환)
+    if (written > 0) {
+        return (int)written;
+    }
+
+    // code 주요 오류 번호 검사
+    switch (code & 0xFFFF) {
+        case NO_ERROR:           // 오류 없음
+            break;               // 계속 진행 ->
+
+        case NO_FREE_SPACE:      // 남은 용량 없음
+            return -ENOSPC;      // No space left on device
+
+        default:                 // 그 외
+            return -EIO;         // Input/output error
     }
 
     // 쓴 바이트 수 반환
-    return (int)size;
+    return (int)written;
+}
+
+// 파일 공간 할당 또는 hole 생성
+int asdfs_fallocate (const char *path, int mode, off_t off, off_t length, struct fuse_file_info *fi) {
+    fprintf(stderr, "asdfs_fallocate %s %X %zu %zu\n", path, mode, off, length);
+
+    // 변경이 끝날 때까지 checkpoint 대기, 늘어난 크기를 기록할 때까지 크기를 바꾸는 다른 요청 대기
+    CHECKPOINT_HOLD();
+    NAMESPACE_READ();
+
+    // asdfs_open에서 전달된 file handle 확인
+    inode *node = (inode *)fi->fh;
+    if (node == NULL) {
+        return -EIO;
+    }
+
+    // 요청 상태 검사
+    if (node->mode & S_IFDIR) {          // node가 디렉터리인 경우
+        return -EISDIR;                  // Is a directory
+    }
+    if (off < 0 || length <= 0) {        // 범위가 잘못된 경우
+        return -EINVAL;                  // Invalid argument
+    }
+    if (mode & ~(FALLOC_FL_KEEP_SIZE | FALLOC_FL_PUNCH_HOLE)) { // 지원하지 않는 모드인 경우
+        return -EOPNOTSUPP;              // Operation not supported
+    }
+
+    asdfs_errno code;
+    if (mode & FALLOC_FL_PUNCH_HOLE) {
+        // hole 생성은 파일 크기를 유지하는 경우만 가능
+        if (!(mode & FALLOC_FL_KEEP_SIZE)) {
+            return -EOPNOTSUPP;          // Operation not supported
+        }
+        code = punch_data_inode(node, off, length);
+    }
+    else {
+        // 범위의 블록 할당 후 파일 크기 유지 요청이 아니면 크기 증가
+        off_t before = get_cold(node)->size;
+        code = fill_data_inode(node, off, length);
+        if (code == NO_ERROR && !(mode & FALLOC_FL_KEEP_SIZE) && off + length > before) {
+            code = alloc_data_inode(node, off + length);
+            log_extend(path, node, before);
+        }
+    }
+
+    // code 주요 오류 번호 검사
+    switch (code & 0xFFFF) {
+        case NO_ERROR:           // 오류 없음
+            return 0;            // 완료
+
+        case NO_FREE_SPACE:      // 남은 용량 없음
+            return -ENOSPC;      // No space left on device
+
+        default:                 // 그 외
+            return -EIO;         // Input/output error
+    }
+}
+
+// 블록 공유로 src의 src_off부터 *length 바이트를 dst의 dst_off 위치에 복제할 수 있는지 검사
+// *length가 0이면 src 끝까지로 바꿈, 가능하면 0, 아니면 -errno 반환 (FICLONERANGE와 같은 조건)
+static int clone_check (inode *dst, off_t dst_off, inode *src, off_t src_off, off_t *length) {
+    off_t src_size = get_cold(src)->size;
+    off_t dst_size = get_cold(dst)->size;
+
+    if ((src->mode & S_IFDIR) || (dst->mode & S_IFDIR)) { // 디렉터리인 경우
+        return -EISDIR;                  // Is a directory
+    }
+    if (src_off < 0 || dst_off < 0 || *length < 0 || src_off > src_size) { // 범위가 잘못된 경우
+        return -EINVAL;                  // Invalid argument
+    }
+    if (*length == 0) {
+        *length = src_size - src_off;
+    }
+    if (*length > src_size - src_off) {  // 원본 끝을 넘는 경우
+        return -EINVAL;                  // Invalid argument
+    }
+
+    // 시작 위치는 블록 단위, 끝은 블록 단위이거나 원본 끝이면서 대상 끝 이후여야 함
+    if (src_off % DATA_BLOCK_SIZE || dst_off % DATA_BLOCK_SIZE
+        || (*length % DATA_BLOCK_SIZE && (src_off + *length != src_size || dst_off + *length < dst_size))) {
+        return -EINVAL;                  // Invalid argument
+    }
+
+    // 같은 파일에서 범위가 겹치는 경우
+    if (src == dst && src_off < dst_off + *length && dst_off < src_off + *length) {
+        return -EINVAL;                  // Invalid argument
+    }
+    return 0;
+}
+
+// 블록 사용량과 중복 제거 통계를 ASDFS_IOC_BLOCK_STATS 응답 형식으로 반환
+static struct asdfs_block_stats block_stats () {
+    dedup_stats dstats = get_dedup_stats();
+    struct asdfs_block_stats stats = { .logical = dstats.logical, .physical = dstats.physical, .ratio = dstats.ratio,
+                                       .hashed = dstats.hashed, .hit = dstats.hit, .indexed = dstats.indexed };
+    return stats;
+}
+
+// 파일 제어 요청: ASDFS_IOC_CLONE_RANGE (블록을 공유하는 파일 복제), ASDFS_IOC_BLOCK_STATS (블록 사용량 조회)
+int asdfs_ioctl (const char *path, int cmd, void *arg, struct fuse_file_info *fi, unsigned int flags, void *data) {
+    fprintf(stderr, "asdfs_ioctl %s %X\n", path, (unsigned)cmd);
+
+    if ((unsigned)cmd == ASDFS_IOC_BLOCK_STATS) { // 블록 사용량 조회
+        if (data == NULL) {
+            return -EIO;                 // Input/output error
+        }
+        *(struct asdfs_block_stats *)data = block_stats();
+        return 0;
+    }
+    if ((unsigned)cmd != ASDFS_IOC_CLONE_RANGE) { // 지원하지 않는 요청인 경우
+        return -ENOTTY;                  // Inappropriate ioctl for device
+    }
+
+    // 변경이 끝날 때까지 checkpoint 대기, path 검색 중에는 이름 공간 변경 대기
+    CHECKPOINT_HOLD();
+    NAMESPACE_READ();
+
+    // asdfs_open에서 전달된 file handle 확인
+    inode *node = (inode *)fi->fh;
+    if (node == NULL || data == NULL) {
+        return -EIO;
+    }
+
+    // 대상 파일 쓰기 권한 확인
+    search_result res;
+    if (!(access_inode(node, &res) & CAN_WRITE_EXACT)) {
+        return -EACCES;                  // Permission denied
+    }
+
+    // 원본 path에 해당하는 inode 검색
+    struct asdfs_clone_range *range = (struct asdfs_clone_range *)data;
+    range->src_path[sizeof(range->src_path) - 1] = '\0';
+    asdfs_errno code = find_inode(range->src_path, &res);
+
+    // code 주요 오류 번호 검사
+    switch (code & 0xFFFF) {
+        case EXACT_FOUND:        // path 위치에 inode 있음
+            break;               // 계속 진행 ->
+
+        case EXACT_NOT_FOUND:    // path 위치에 inode 없음
+        case HEAD_NOT_FOUND:     // path의 head 없음
+            return -ENOENT;      // No such file or directory
+
+        case HEAD_NOT_DIRECTORY: // path의 head가 디렉터리가 아님
+            return -ENOTDIR;     // Not a directory
+
+        case HEAD_NO_PERMISSION: // path의 head를 탐색할 권한이 없음
+            return -EACCES;      // Permission denied
+
+        case GENERAL_ERROR:      // 그 외
+        default:
+            return -EIO;         // Input/output error
+    }
+
+    // code 보조 비트 마스크 검사
+    if (!(code & CAN_READ_EXACT)) { // 원본 읽기 권한이 없는 경우
+        return -EACCES;             // Permission denied
+    }
+
+    // 범위 검사
+    off_t length = (off_t)range->src_length;
+    int err = clone_check(node, (off_t)range->dest_offset, res.exact, (off_t)range->src_offset, &length);
+    if (err != 0) {
+        return err;
+    }
+
+    // 원본 블록을 대상 위치에서 공유
+    off_t before = get_cold(node)->size;
+    code = clone_data_inode(node, (off_t)range->dest_offset, res.exact, (off_t)range->src_offset, length);
+    log_extend(path, node, before);
+
+    // code 주요 오류 번호 검사
+    switch (code & 0xFFFF) {
+        case NO_ERROR:           // 오류 없음
+            return 0;            // 완료
+
+        case NO_FREE_SPACE:      // 남은 용량 없음
+            return -ENOSPC;      // No space left on device
+
+        default:                 // 그 외
+            return -EIO;         // Input/output error
+    }
+}
+
+// 파일 닫기 (파일을 연 마지막 file handle)
+int asdfs_release (const char *path, struct fuse_file_info *fi) {
+    fprintf(stderr, "asdfs_release %s\n", path);
+
+    // 변경이 끝날 때까지 checkpoint 대기
+    CHECKPOINT_HOLD();
+
+    // asdfs_open에서 전달된 file handle 확인
+    inode *node = (inode *)fi->fh;
+    if (node == NULL) {
+        return -EIO;
+    }
+
+    // 이어 쓰기용으로 예약하고 쓰지 않은 블록 반환
+    release_data_inode(node);
+    return 0;
 }
 
 // 파일 권한 변경
 int asdfs_chmod (const char *path, mode_t mode) {
     fprintf(stderr, "asdfs_chmod %s %X\n", path, mode);
 
+    // 변경이 끝날 때까지 checkpoint 대기, 같은 파일의 다른 변경과 journal 순서를 맞추도록 이름 공간 잠금
+    CHECKPOINT_HOLD();
+    NAMESPACE_WRITE();
+
     // path에 해당하는 inode 검색
     search_result res;
     asdfs_errno code = find_inode(path, &res);
@@ -620,14 +1353,27 @@ int asdfs_chmod (const char *path, mode_t mode) {
     }
 
     // exact의 권한 정보 변경
-    res.exact->attr.st_mode = mode;
-    return 0;
+    res.exact->mode = mode;
+    dirty_inode(res.exact);
+
+    // 디렉터리 탐색 권한이 바뀌므로 하위 path의 dentry cache 무효화
+    if (res.exact->mode & S_IFDIR) {
+        dcache_invalidate_all();
+    }
+
+    // journal에 기록
+    journal_record rec = { .op = JOURNAL_CHMOD, .mode = mode, .path = path };
+    return log_change(rec, &namespace_held);
 }
 
 // 파일 소유자 변경
 int asdfs_chown (const char *path, uid_t uid, gid_t gid) {
     fprintf(stderr, "asdfs_chown %s %u %u\n", path, uid, gid);
 
+    // 변경이 끝날 때까지 checkpoint 대기, 같은 파일의 다른 변경과 journal 순서를 맞추도록 이름 공간 잠금
+    CHECKPOINT_HOLD();
+    NAMESPACE_WRITE();
+
     // path에 해당하는 inode 검색
     search_result res;
     asdfs_errno code = find_inode(path, &res);
@@ -660,15 +1406,28 @@ int asdfs_chown (const char *path, uid_t uid, gid_t gid) {
     }
 
     // exact의 소유자 정보 변경
-    res.exact->attr.st_uid = uid;
-    res.exact->attr.st_gid = gid;
-    return 0;
+    res.exact->uid = uid;
+    res.exact->gid = gid;
+    dirty_inode(res.exact);
+
+    // 디렉터리 탐색 권한이 바뀌므로 하위 path의 dentry cache 무효화
+    if (res.exact->mode & S_IFDIR) {
+        dcache_invalidate_all();
+    }
+
+    // journal에 기록
+    journal_record rec = { .op = JOURNAL_CHOWN, .uid = uid, .gid = gid, .path = path };
+    return log_change(rec, &namespace_held);
 }
 
 // 파일 이동
 int asdfs_rename (const char *oldpath, const char *newpath) {
     fprintf(stderr, "asdfs_rename %s %s\n", oldpath, newpath);
 
+    // 변경이 끝날 때까지 checkpoint, 다른 요청의 이름 검색과 변경 대기
+    CHECKPOINT_HOLD();
+    NAMESPACE_WRITE();
+
     // oldpath에 해당하는 inode 검색
     search_result oldres;
     asdfs_errno oldcode = find_inode(oldpath, &oldres);
@@ -729,10 +1488,55 @@ int asdfs_rename (const char *oldpath, const char *newpath) {
         return -EACCES;                  // Permission denied
     }
 
+    // 디렉터리는 하위 path 전부, 파일은 oldpath의 dentry cache 무효화
+    if (oldres.exact->mode & S_IFDIR) {
+        dcache_invalidate_all();
+    }
+    else {
+        dcache_invalidate(oldpath);
+    }
+
     // oldres.exact를 inode tree에서 분리
     extract_inode(oldres.exact);
 
+    // newpath의 마지막 path component로 이름 변경
+    // 이름 공간이 없으면 이전 이름 그대로 원래 위치에 다시 삽입
+    if (rename_inode(oldres.exact, newres.tail) != NO_ERROR) {
+        insert_inode(oldres, oldres.exact);
+        return -ENOSPC;          // No space left on device
+    }
+
     // oldres.exact를 newres 위치에 삽입
     insert_inode(newres, oldres.exact);
-    return 0;
+
+    // journal에 기록
+    journal_record rec = { .op = JOURNAL_RENAME, .path = oldpath, .newpath = newpath };
+    return log_change(rec, &namespace_held);
+}
+
+// 파일 내용과 메타데이터를 디스크에 기록
+int asdfs_fsync (const char *path, int datasync, struct fuse_file_info *fi) {
+    fprintf(stderr, "asdfs_fsync %s %d\n", path, datasync);
+
+    // asdfs_open에서 전달된 file handle 확인
+    inode *node = (inode *)fi->fh;
+    if (node == NULL) {
+        return -EIO;
+    }
+
+    // 이미지 파일을 사용하면 파일 블록 기록
+    if (sync_data_inode(node) != NO_ERROR) {
+        return -EIO;
+    }
+
+    // 파일 크기, 이름 등 메타데이터 기록
+    return sync_changes();
+}
+
+// 디렉터리 메타데이터를 디스크에 기록
+int asdfs_fsyncdir (const char *path, int datasync, struct fuse_file_info *fi) {
+    fprintf(stderr, "asdfs_fsyncdir %s %d\n", path, datasync);
+
+    // 디렉터리 아래 이름 변경 기록
+    return sync_changes();
 }
@@ -10,9 +10,34 @@
 #include <stdlib.h>
 #include <errno.h>
 
+// high-level FUSE 설정 (fuse_main의 user_data로 전달)
+struct asdfs_config {
+    int listing_cache; // 목록을 읽은 디렉터리를 고정하여 바로 아래 path 검색 시 tree 탐색 생략
+};
+
+// 이미지 파일을 볼륨으로 사용 (마운트 전에 호출), 실패하면 -1 반환
+// checkpoint가 0이 아니면 checkpoint초마다 바뀐 부분만 이미지 파일에 기록
+int asdfs_open_image (const char *path, unsigned checkpoint);
+
+// 블록 전체를 쓸 때 같은 내용의 블록을 공유 (이미지 파일을 열기 전에 호출), 실패하면 -1 반환
+int asdfs_enable_dedup ();
+
+// interval초 동안 읽거나 쓰지 않은 블록을 백그라운드에서 압축 (이미지 파일을 열기 전에 호출), 실패하면 -1 반환
+int asdfs_enable_compress (unsigned interval);
+
+// 블록 메모리가 budget MB를 넘으면 오래 쓰지 않은 블록을 dir의 파일 (dir이 NULL이면 이미지 파일)로 내림
+// 이미지 파일을 열기 전에 호출, 실패하면 -1 반환
+int asdfs_enable_spill (const char *dir, unsigned budget);
+
+// 메타데이터 변경을 journal 파일에 기록 (마운트 전에 호출), 실패하면 -1 반환
+int asdfs_open_journal (const char *path);
+
 // 파일 시스템 초기화
 void *asdfs_init (struct fuse_conn_info *conn);
 
+// 파일 시스템 해제
+void asdfs_destroy (void *private_data);
+
 // 파일 시스템 정보 조회
 int asdfs_statfs (const char *path, struct statvfs *buf);
 
@@ -46,12 +71,27 @@ int asdfs_open (const char *path, struct fuse_file_info *fi);
 // 파일 읽기
 int asdfs_read (const char *path, char *mem, size_t size, off_t off, struct fuse_file_info *fi);
 
+// 파일 읽기 (fuse_bufvec)
+int asdfs_read_buf (const char *path, struct fuse_bufvec **bufp, size_t size, off_t off, struct fuse_file_info *fi);
+
 // 이미 있는 파일 크기 변경
 int asdfs_truncate (const char *path, off_t size);
 
 // 파일 쓰기
 int asdfs_write (const char *path, const char *mem, size_t size, off_t off, struct fuse_file_info *fi);
 
+// 파일 쓰기 (fuse_bufvec)
+int asdfs_write_buf (const char *path, struct fuse_bufvec *buf, off_t off, struct fuse_file_info *fi);
+
+// 파일 공간 할당 또는 hole 생성
+int asdfs_fallocate (const char *path, int mode, off_t off, off_t length, struct fuse_file_info *fi);
+
+// 파일 제어 요청 (블록을 공유하는 파일 복제)
+int asdfs_ioctl (const char *path, int cmd, void *arg, struct fuse_file_info *fi, unsigned int flags, void *data);
+
+// 파일 닫기 (파일을 연 마지막 file handle)
+int asdfs_release (const char *path, struct fuse_file_info *fi);
+
 // 파일 권한 변경
 int asdfs_chmod (const char *path, mode_t mode);
 
@@ -61,4 +101,10 @@ int asdfs_chown (const char *path, uid_t uid, gid_t gid);
 // 파일 이동
 int asdfs_rename (const char *oldpath, const char *newpath);
 
+// 파일 내용과 메타데이터를 디스크에 기록
+int asdfs_fsync (const char *path, int datasync, struct fuse_file_info *fi);
+
+// 디렉터리 메타데이터를 디스크에 기록
+int asdfs_fsyncdir (const char *path, int datasync, struct fuse_file_info *fi);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include "asdfs_compress.h"
+#include <string.h>
+#include <stdint.h>
+
+// 압축 형식: LZ4 블록과 같은 순서의 sequence 목록
+// sequence: token (상위 4비트 literal 길이, 하위 4비트 일치 길이 - 4), literal 길이 추가 바이트,
+//           literal, 일치 위치까지의 거리 (2 B, little endian), 일치 길이 추가 바이트
+// 길이가 15 이상이면 255 미만인 바이트가 나올 때까지 추가 바이트를 더함
+// 마지막 sequence는 literal만 있고 거리와 일치 길이가 없음
+#define COMPRESS_MIN_MATCH 4 // 최소 일치 길이 (B)
+
+// 길이 추가 바이트를 out의 *pos 위치에 기록 (length는 15를 뺀 값)
+static void compress_length(uint8_t *out, size_t *pos, size_t length) {
+    while (length >= 255) {
+        out[(*pos)++] = 255;
+        length -= 255;
+    }
+    out[(*pos)++] = (uint8_t)length;
+}
+
+// literal length 바이트와 거리 distance, 길이 match인 일치를 out의 *pos 위치에 기록
+// match가 0이면 마지막 sequence, capacity를 넘으면 -1 반환
+static int compress_sequence(uint8_t *out, size_t *pos, size_t capacity,
+                             const uint8_t *literal, size_t length, size_t distance, size_t match) {
+    size_t need = 1 + length + length / 255 + 1 + (match ? 2 + match / 255 + 1 : 0);
+    if (*pos + need > capacity) {
+        return -1;
+    }
+
+    // token
+    size_t code = match ? match - COMPRESS_MIN_MATCH : 0;
+    out[*pos] = (uint8_t)(((length < 15 ? length : 15) << 4) | (code < 15 ? code : 15));
+    (*pos)++;
+
+    // literal
+    if (length >= 15) {
+        compress_length(out, pos, length - 15);
+    }
+    memcpy(out + *pos, literal, length);
+    *pos += length;
+    if (match == 0) {
+        return 0;
+    }
+
+    // 일치 위치까지의 거리와 일치 길이
+    out[(*pos)++] = (uint8_t)distance;
+    out[(*pos)++] = (uint8_t)(distance >> 8);
+    if (code >= 15) {
+        compress_length(out, pos, code - 15);
+    }
+    return 0;
+}
+
+// src의 size 바이트를 압축하여 dst에 기록, 압축한 크기 반환 (capacity를 넘으면 0)
+// 4 B 값의 hash로 가장 최근 같은 값의 위치를 찾아 일치를 앞으로 늘림
+// 일치를 찾지 못할수록 검색 간격을 넓혀 압축되지 않는 내용은 빨리 넘김
+size_t compress_data(const void *src, size_t size, void *dst, size_t capacity) {
+    const uint8_t *in = (const uint8_t *)src;
+    uint8_t *out = (uint8_t *)dst;
+    if (size > COMPRESS_INPUT_MAX) {
+        return 0;
+    }
+
+    // 위치 + 1, 0이면 없음
+    uint16_t table[1 << COMPRESS_HASH_BITS];
+    memset(table, 0, sizeof(table));
+
+    size_t pos = 0;    // out에 기록한 크기
+    size_t anchor = 0; // 아직 기록하지 않은 literal 시작 위치
+    size_t ip = 0;     // 검색 위치
+    while (ip + COMPRESS_MIN_MATCH <= size) {
+        uint32_t value;
+        memcpy(&value, in + ip, sizeof(value));
+        uint32_t hash = (value * 2654435761u) >> (32 - COMPRESS_HASH_BITS);
+        size_t candidate = table[hash];
+        table[hash] = (uint16_t)(ip + 1);
+
+        // 같은 4 B가 없으면 다음 위치
+        uint32_t other = 0;
+        if (candidate != 0) {
+            memcpy(&other, in + candidate - 1, sizeof(other));
+        }
+        if (candidate == 0 || other != value) {
+            ip += 1 + ((ip - anchor) >> 5);
+            continue;
+        }
+        candidate--;
+
+        // 일치 길이 연장: 8 B씩 비교하고 처음 다른 바이트 위치까지
+        size_t match = COMPRESS_MIN_MATCH;
+        while (ip + match + sizeof(uint64_t) <= size) {
+            uint64_t a, b;
+            memcpy(&a, in + candidate + match, sizeof(a));
+            memcpy(&b, in + ip + match, sizeof(b));
+            if (a != b) {
+                break;
+            }
+            match += sizeof(uint64_t);
+        }
+        while (ip + match < size && in[candidate + match] == in[ip + match]) {
+            match++;
+        }
+        if (compress_sequence(out, &pos, capacity, in + anchor, ip - anchor, ip - candidate, match) != 0) {
+            return 0;
+        }
+        ip += match;
+        anchor = ip;
+    }
+
+    // 남은 literal
+    if (compress_sequence(out, &pos, capacity, in + anchor, size - anchor, 0, 0) != 0) {
+        return 0;
+    }
+    return pos;
+}
+
+// in의 *pos 위치의 길이 추가 바이트를 length에 더함, 내용이 끝나면 -1 반환
+static int decompress_length(const uint8_t *in, size_t size, size_t *pos, size_t *length) {
+    uint8_t byte;
+    do {
+        if (*pos >= size) {
+            return -1;
+        }
+        byte = in[(*pos)++];
+        *length += byte;
+    } while (byte == 255);
+    return 0;
+}
+
+// compress_data로 압축한 src의 size 바이트를 풀어 dst에 기록
+// 정확히 capacity 바이트로 풀리면 0, 아니면 -1 반환 (dst 범위 밖에는 쓰지 않음)
+int decompress_data(const void *src, size_t size, void *dst, size_t capacity) {
+    const uint8_t *in = (const uint8_t *)src;
+    uint8_t *out = (uint8_t *)dst;
+    size_t ip = 0;
+    size_t op = 0;
+
+    while (ip < size) {
+        uint8_t token = in[ip++];
+
+        // literal
+        size_t length = token >> 4;
+        if (length == 15 && decompress_length(in, size, &ip, &length) != 0) {
+            return -1;
+        }
+        if (length > size - ip || length > capacity - op) {
+            return -1;
+        }
+        memcpy(out + op, in + ip, length);
+        ip += length;
+        op += length;
+
+        // 마지막 sequence
+        if (ip == size) {
+            break;
+        }
+
+        // 일치: 이미 푼 내용에서 복사
+        if (size - ip < 2) {
+            return -1;
+        }
+        size_t distance = (size_t)in[ip] | ((size_t)in[ip + 1] << 8);
+        ip += 2;
+        size_t match = token & 15;
+        if (match == 15 && decompress_length(in, size, &ip, &match) != 0) {
+            return -1;
+        }
+        match += COMPRESS_MIN_MATCH;
+        if (distance == 0 || distance > op || match > capacity - op) {
+            return -1;
+        }
+
+        // 거리가 일치 길이보다 짧으면 반복되는 내용이므로 거리의 배수 단위로 겹치지 않게 늘려가며 복사
+        const uint8_t *from = out + op - distance;
+        size_t done = 0;
+        while (done < match) {
+            size_t count = distance + done < match - done ? distance + done : match - done;
+            memcpy(out + op + done, from, count);
+            done += count;
+        }
+        op += match;
+    }
+    return op == capacity ? 0 : -1;
+}
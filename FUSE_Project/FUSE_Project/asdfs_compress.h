@@ -0,0 +1,19 @@
+#ifndef __ASDFS_COMPRESS_H__
+#define __ASDFS_COMPRESS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define COMPRESS_INPUT_MAX 65535 // 한 번에 압축하는 최대 크기 (B), 위치를 16비트로 저장
+#define COMPRESS_HASH_BITS 12    // 일치 위치 검색 table 크기 (2^12 항목)
+
+// src의 size 바이트를 압축하여 dst에 기록, 압축한 크기 반환
+// 압축한 크기가 capacity를 넘거나 size가 COMPRESS_INPUT_MAX보다 크면 0 반환
+// 압축 도중 src가 바뀌어도 범위 밖을 읽거나 쓰지 않음 (결과 내용은 의미 없음)
+size_t compress_data(const void *src, size_t size, void *dst, size_t capacity);
+
+// compress_data로 압축한 src의 size 바이트를 풀어 dst에 기록
+// 정확히 capacity 바이트로 풀리면 0, 손상된 내용이면 -1 반환
+int decompress_data(const void *src, size_t size, void *dst, size_t capacity);
+
+#endif
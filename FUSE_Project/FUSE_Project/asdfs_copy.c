@@ -0,0 +1,363 @@
+#include "asdfs_copy.h"
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#define COPY_SSE2 1
+// gcc 4.9 이상에서만 target 속성 함수 안에서 AVX intrinsic 사용 가능
+#if defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#include <immintrin.h>
+#define COPY_AVX 1
+#endif
+#endif
+
+// 복사 함수: size는 COPY_SMALL_MAX보다 큼
+typedef void (*copy_func)(void *dst, const void *src, size_t size);
+
+// CPU 기능에 관계없이 사용 가능한 복사
+static void copy_generic(void *dst, const void *src, size_t size) {
+    memcpy(dst, src, size);
+}
+
+#ifdef COPY_SSE2
+// 16 B 단위 복사
+// 첫 16 B를 복사한 뒤 dst를 16 B 경계에 맞추고, 마지막 16 B는 겹쳐서 복사
+static void copy_sse2(void *dst, const void *src, size_t size) {
+    char *d = (char *)dst;
+    const char *s = (const char *)src;
+
+    // head: dst를 16 B 경계에 맞춤
+    _mm_storeu_si128((__m128i *)d, _mm_loadu_si128((const __m128i *)s));
+    size_t head = 16 - ((uintptr_t)d & 15);
+    d += head;
+    s += head;
+    size -= head;
+
+    // body: 64 B 단위
+    while (size >= 64) {
+        __m128i a = _mm_loadu_si128((const __m128i *)s);
+        __m128i b = _mm_loadu_si128((const __m128i *)(s + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *)(s + 32));
+        __m128i e = _mm_loadu_si128((const __m128i *)(s + 48));
+        _mm_store_si128((__m128i *)d, a);
+        _mm_store_si128((__m128i *)(d + 16), b);
+        _mm_store_si128((__m128i *)(d + 32), c);
+        _mm_store_si128((__m128i *)(d + 48), e);
+        d += 64;
+        s += 64;
+        size -= 64;
+    }
+    while (size >= 16) {
+        _mm_store_si128((__m128i *)d, _mm_loadu_si128((const __m128i *)s));
+        d += 16;
+        s += 16;
+        size -= 16;
+    }
+
+    // tail: 마지막 16 B
+    if (size) {
+        _mm_storeu_si128((__m128i *)(d + size - 16), _mm_loadu_si128((const __m128i *)(s + size - 16)));
+    }
+}
+
+// 16 B 단위 non-temporal store 복사, dst를 cache에 올리지 않음
+static void copy_sse2_stream(void *dst, const void *src, size_t size) {
+    char *d = (char *)dst;
+    const char *s = (const char *)src;
+
+    // head: dst를 16 B 경계에 맞춤
+    _mm_storeu_si128((__m128i *)d, _mm_loadu_si128((const __m128i *)s));
+    size_t head = 16 - ((uintptr_t)d & 15);
+    d += head;
+    s += head;
+    size -= head;
+
+    // body: 64 B 단위
+    while (size >= 64) {
+        __m128i a = _mm_loadu_si128((const __m128i *)s);
+        __m128i b = _mm_loadu_si128((const __m128i *)(s + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *)(s + 32));
+        __m128i e = _mm_loadu_si128((const __m128i *)(s + 48));
+        _mm_stream_si128((__m128i *)d, a);
+        _mm_stream_si128((__m128i *)(d + 16), b);
+        _mm_stream_si128((__m128i *)(d + 32), c);
+        _mm_stream_si128((__m128i *)(d + 48), e);
+        d += 64;
+        s += 64;
+        size -= 64;
+    }
+    while (size >= 16) {
+        _mm_stream_si128((__m128i *)d, _mm_loadu_si128((const __m128i *)s));
+        d += 16;
+        s += 16;
+        size -= 16;
+    }
+
+    // tail: 마지막 16 B
+    if (size) {
+        _mm_storeu_si128((__m128i *)(d + size - 16), _mm_loadu_si128((const __m128i *)(s + size - 16)));
+    }
+
+    // 다른 스레드가 읽기 전에 non-temporal store 완료
+    _mm_sfence();
+}
+#endif
+
+#ifdef COPY_AVX
+// 32 B 단위 복사
+// 첫 32 B를 복사한 뒤 dst를 32 B 경계에 맞추고, 마지막 32 B는 겹쳐서 복사
+__attribute__((target("avx")))
+static void copy_avx(void *dst, const void *src, size_t size) {
+    char *d = (char *)dst;
+    const char *s = (const char *)src;
+
+    // head: dst를 32 B 경계에 맞춤
+    _mm256_storeu_si256((__m256i *)d, _mm256_loadu_si256((const __m256i *)s));
+    size_t head = 32 - ((uintptr_t)d & 31);
+    d += head;
+    s += head;
+    size -= head;
+
+    // body: 128 B 단위
+    while (size >= 128) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)s);
+        __m256i b = _mm256_loadu_si256((const __m256i *)(s + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i *)(s + 64));
+        __m256i e = _mm256_loadu_si256((const __m256i *)(s + 96));
+        _mm256_store_si256((__m256i *)d, a);
+        _mm256_store_si256((__m256i *)(d + 32), b);
+        _mm256_store_si256((__m256i *)(d + 64), c);
+        _mm256_store_si256((__m256i *)(d + 96), e);
+        d += 128;
+        s += 128;
+        size -= 128;
+    }
+    while (size >= 32) {
+        _mm256_store_si256((__m256i *)d, _mm256_loadu_si256((const __m256i *)s));
+        d += 32;
+        s += 32;
+        size -= 32;
+    }
+
+    // tail: 마지막 32 B
+    if (size) {
+        _mm256_storeu_si256((__m256i *)(d + size - 32), _mm256_loadu_si256((const __m256i *)(s + size - 32)));
+    }
+    _mm256_zeroupper();
+}
+
+// 32 B 단위 non-temporal store 복사, dst를 cache에 올리지 않음
+__attribute__((target("avx")))
+static void copy_avx_stream(void *dst, const void *src, size_t size) {
+    char *d = (char *)dst;
+    const char *s = (const char *)src;
+
+    // head: dst를 32 B 경계에 맞춤
+    _mm256_storeu_si256((__m256i *)d, _mm256_loadu_si256((const __m256i *)s));
+    size_t head = 32 - ((uintptr_t)d & 31);
+    d += head;
+    s += head;
+    size -= head;
+
+    // body: 128 B 단위
+    while (size >= 128) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)s);
+        __m256i b = _mm256_loadu_si256((const __m256i *)(s + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i *)(s + 64));
+        __m256i e = _mm256_loadu_si256((const __m256i *)(s + 96));
+        _mm256_stream_si256((__m256i *)d, a);
+        _mm256_stream_si256((__m256i *)(d + 32), b);
+        _mm256_stream_si256((__m256i *)(d + 64), c);
+        _mm256_stream_si256((__m256i *)(d + 96), e);
+        d += 128;
+        s += 128;
+        size -= 128;
+    }
+    while (size >= 32) {
+        _mm256_stream_si256((__m256i *)d, _mm256_loadu_si256((const __m256i *)s));
+        d += 32;
+        s += 32;
+        size -= 32;
+    }
+
+    // tail: 마지막 32 B
+    if (size) {
+        _mm256_storeu_si256((__m256i *)(d + size - 32), _mm256_loadu_si256((const __m256i *)(s + size - 32)));
+    }
+    _mm256_zeroupper();
+
+    // 다른 스레드가 읽기 전에 non-temporal store 완료
+    _mm_sfence();
+}
+#endif
+
+// hash: 64 B (HASH_STRIPE) 단위로 8개의 64비트 누적 값에 더하고 마지막에 섞음
+// 각 8 B 단어 d에 대해 acc += (d의 상하위 32비트 교환) + lo32(d ^ key) * hi32(d ^ key)
+// key는 단어 위치별 값에 stripe마다 HASH_STEP을 더해 같은 단어가 다른 위치에 있으면 다른 값
+// 곱셈과 덧셈만 쓰므로 SIMD에서 64비트 lane별로 그대로 계산 가능
+#define HASH_STEP   0x9E3779B97F4A7C15ULL
+#define HASH_PRIME1 0x9FB21C651E98DF25ULL
+#define HASH_PRIME2 0xC2B2AE3D27D4EB4FULL
+
+static const uint64_t hash_key[8] = {
+    0xBE4BA423396CFEB8ULL, 0x1CAD21F72C81017CULL, 0xDB979083E96DD4DEULL, 0x1F67B3B7A4A44072ULL,
+    0x78E5C0CC4EE679CBULL, 0x2172FFCC7DD05A82ULL, 0x8E2443F7744608B8ULL, 0x4C263A81E69035E0ULL,
+};
+
+// hash 함수: first번째 stripe부터 stripes개의 stripe를 acc에 누적
+typedef void (*hash_func)(uint64_t acc[8], const char *src, size_t stripes, uint64_t first);
+
+// CPU 기능에 관계없이 사용 가능한 hash
+static void hash_generic(uint64_t acc[8], const char *src, size_t stripes, uint64_t first) {
+    for (size_t i=0; i<stripes; i++) {
+        uint64_t step = (first + i) * HASH_STEP;
+        for (int j=0; j<8; j++) {
+            uint64_t d;
+            memcpy(&d, src + i * HASH_STRIPE + j * 8, 8);
+            uint64_t dk = d ^ (hash_key[j] + step);
+            acc[j] += ((d << 32) | (d >> 32)) + (dk & 0xFFFFFFFFu) * (dk >> 32);
+        }
+    }
+}
+
+#ifdef COPY_SSE2
+// 16 B (lane 2개) 단위 hash
+static void hash_sse2(uint64_t acc[8], const char *src, size_t stripes, uint64_t first) {
+    __m128i a[4], k[4];
+    __m128i step = _mm_set1_epi64x((long long)HASH_STEP);
+    for (int j=0; j<4; j++) {
+        a[j] = _mm_loadu_si128((const __m128i *)(acc + j * 2));
+        k[j] = _mm_add_epi64(_mm_loadu_si128((const __m128i *)(hash_key + j * 2)), _mm_set1_epi64x((long long)(first * HASH_STEP)));
+    }
+    for (size_t i=0; i<stripes; i++) {
+        const char *s = src + i * HASH_STRIPE;
+        for (int j=0; j<4; j++) {
+            __m128i d = _mm_loadu_si128((const __m128i *)(s + j * 16));
+            __m128i dk = _mm_xor_si128(d, k[j]);
+            __m128i product = _mm_mul_epu32(dk, _mm_srli_epi64(dk, 32));
+            __m128i swapped = _mm_shuffle_epi32(d, _MM_SHUFFLE(2, 3, 0, 1));
+            a[j] = _mm_add_epi64(a[j], _mm_add_epi64(product, swapped));
+            k[j] = _mm_add_epi64(k[j], step);
+        }
+    }
+    for (int j=0; j<4; j++) {
+        _mm_storeu_si128((__m128i *)(acc + j * 2), a[j]);
+    }
+}
+#endif
+
+#ifdef COPY_AVX
+// 32 B (lane 4개) 단위 hash
+__attribute__((target("avx2")))
+static void hash_avx2(uint64_t acc[8], const char *src, size_t stripes, uint64_t first) {
+    __m256i a[2], k[2];
+    __m256i step = _mm256_set1_epi64x((long long)HASH_STEP);
+    for (int j=0; j<2; j++) {
+        a[j] = _mm256_loadu_si256((const __m256i *)(acc + j * 4));
+        k[j] = _mm256_add_epi64(_mm256_loadu_si256((const __m256i *)(hash_key + j * 4)), _mm256_set1_epi64x((long long)(first * HASH_STEP)));
+    }
+    for (size_t i=0; i<stripes; i++) {
+        const char *s = src + i * HASH_STRIPE;
+        for (int j=0; j<2; j++) {
+            __m256i d = _mm256_loadu_si256((const __m256i *)(s + j * 32));
+            __m256i dk = _mm256_xor_si256(d, k[j]);
+            __m256i product = _mm256_mul_epu32(dk, _mm256_srli_epi64(dk, 32));
+            __m256i swapped = _mm256_shuffle_epi32(d, _MM_SHUFFLE(2, 3, 0, 1));
+            a[j] = _mm256_add_epi64(a[j], _mm256_add_epi64(product, swapped));
+            k[j] = _mm256_add_epi64(k[j], step);
+        }
+    }
+    for (int j=0; j<2; j++) {
+        _mm256_storeu_si256((__m256i *)(acc + j * 4), a[j]);
+    }
+    _mm256_zeroupper();
+}
+#endif
+
+// 선택된 복사 방식, copy_init 전에는 memcpy
+static copy_func copy_cached = copy_generic;  // cache를 거치는 복사
+static copy_func copy_stream = copy_generic;  // cache를 거치지 않는 복사
+static const char *copy_name = "generic";
+static hash_func hash_stripes = hash_generic; // 선택된 hash 방식
+static const char *hash_name = "generic";
+
+// CPU 기능을 확인하여 복사 방식과 hash 방식 선택
+void copy_init() {
+#ifdef COPY_SSE2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        copy_cached = copy_sse2;
+        copy_stream = copy_sse2_stream;
+        copy_name = "sse2";
+        hash_stripes = hash_sse2;
+        hash_name = "sse2";
+    }
+#ifdef COPY_AVX
+    if (__builtin_cpu_supports("avx")) {
+        copy_cached = copy_avx;
+        copy_stream = copy_avx_stream;
+        copy_name = "avx";
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        hash_stripes = hash_avx2;
+        hash_name = "avx2";
+    }
+#endif
+#endif
+}
+
+// dst로 src의 size 바이트 복사
+void copy_data(void *dst, const void *src, size_t size, int stream) {
+    // 작은 복사는 컴파일러의 memcpy가 가장 빠름
+    if (size <= COPY_SMALL_MAX) {
+        memcpy(dst, src, size);
+        return;
+    }
+    if (stream) {
+        copy_stream(dst, src, size);
+    }
+    else {
+        copy_cached(dst, src, size);
+    }
+}
+
+// 선택된 복사 방식 이름 반환
+const char *copy_engine_name() {
+    return copy_name;
+}
+
+// src의 size 바이트에 대한 64비트 hash 반환
+uint64_t hash_data(const void *src, size_t size) {
+    uint64_t acc[8];
+    memcpy(acc, hash_key, sizeof(acc));
+
+    // stripe 단위 누적, 마지막 stripe에 못 미치는 부분은 0을 채워 누적
+    size_t stripes = size / HASH_STRIPE;
+    hash_stripes(acc, (const char *)src, stripes, 0);
+    if (size % HASH_STRIPE) {
+        char tail[HASH_STRIPE] = { 0 };
+        memcpy(tail, (const char *)src + stripes * HASH_STRIPE, size % HASH_STRIPE);
+        hash_generic(acc, tail, 1, stripes);
+    }
+
+    // 누적 값을 섞어서 하나로
+    uint64_t h = (uint64_t)size * HASH_PRIME1;
+    for (int j=0; j<8; j++) {
+        uint64_t a = acc[j];
+        a ^= a >> 29;
+        a *= HASH_PRIME2;
+        a ^= a >> 32;
+        h = (h ^ a) * HASH_PRIME1;
+        h = (h << 27) | (h >> 37);
+    }
+    h ^= h >> 33;
+    h *= HASH_PRIME2;
+    h ^= h >> 29;
+    return h;
+}
+
+// 선택된 hash 방식 이름 반환
+const char *hash_engine_name() {
+    return hash_name;
+}
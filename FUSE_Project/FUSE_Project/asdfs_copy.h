@@ -0,0 +1,29 @@
+#ifndef __ASDFS_COPY_H__
+#define __ASDFS_COPY_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define COPY_SMALL_MAX  64           // 이 크기 이하는 memcpy로 복사 (B)
+#define COPY_STREAM_MIN (256 * 1024) // 이 크기 이상의 쓰기 요청은 cache를 거치지 않고 저장 (B)
+
+#define HASH_STRIPE 64 // hash를 계산하는 단위 (B)
+
+// CPU 기능을 확인하여 복사 방식과 hash 방식 선택
+void copy_init();
+
+// dst로 src의 size 바이트 복사
+// stream이 0이 아니면 dst를 cache에 올리지 않는 non-temporal store 사용
+void copy_data(void *dst, const void *src, size_t size, int stream);
+
+// 선택된 복사 방식 이름 반환
+const char *copy_engine_name();
+
+// src의 size 바이트에 대한 64비트 hash 반환 (블록 내용 비교용, 암호학적 hash 아님)
+// 선택된 방식에 관계없이 같은 내용이면 같은 값
+uint64_t hash_data(const void *src, size_t size);
+
+// 선택된 hash 방식 이름 반환
+const char *hash_engine_name();
+
+#endif
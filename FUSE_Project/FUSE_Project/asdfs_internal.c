@@ -1,530 +1,4465 @@
 #include "asdfs_internal.h"
+#include "asdfs_copy.h"
+#include "asdfs_compress.h"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
 
-static struct statvfs superblock; // 파일 시스템 메타데이터
-static inode root;                // 최초 root inode
+#define NAME_PAGE_SIZE (1u << NAME_PAGE_SHIFT)
+#define NAME_PAGE_MAX  (1u << (32 - NAME_PAGE_SHIFT)) // 이미지 파일을 쓰지 않을 때 최대 이름 page 개수 (이름 번호 32비트)
+#define NAME_CLASSES 5                    // slot 크기 종류: 16, 32, 64, 128, 256 B
 
-// 호출 프로세스가 superuser인지 반환
-int is_root() {
-    struct fuse_context *context = fuse_get_context();
-    return context->uid == 0;
+// 볼륨 정보: 다시 마운트해도 유지해야 하는 파일 시스템 메타데이터와 할당 상태
+// 이미지 파일을 사용하면 파일 맨 앞에 두고, 나머지 영역은 파일 안의 위치 (offset)로 참조
+// inode, 이름, 블록은 모두 번호로 서로를 가리키므로 이미지를 어느 주소에 mapping해도 그대로 사용
+#define VOLUME_MAGIC  "ASDFSVOL" // 이미지 파일 식별자
+#define VOLUME_LAYOUT 6          // 이미지 파일 배치 버전
+
+typedef struct volume_header volume_header;
+struct volume_header {
+    char magic[8];                    // VOLUME_MAGIC
+    uint32_t layout;                  // VOLUME_LAYOUT
+    uint32_t clean;                   // 마지막 마운트가 정상적으로 해제되었는지 여부
+    uint32_t mounts;                  // 마운트 횟수, 이전 마운트의 커널 lookup 횟수 무효화에 사용
+    uint32_t formatted;               // root inode가 초기화되었는지 여부
+
+    // 이미지를 만든 설정: 다른 설정으로 빌드한 asdfs에서 열지 않도록 검사
+    uint32_t blockSize;               // DATA_BLOCK_SIZE
+    uint32_t inodeSize;               // sizeof(inode)
+    uint32_t coldSize;                // sizeof(inode_cold)
+    uint32_t slabMax;                 // 최대 slab 개수
+    uint32_t namePageMax;             // 최대 이름 page 개수
+    uint64_t blocks;                  // 데이터 블록 개수 (f_blocks)
+
+    // 이미지 안의 영역 위치 (B)
+    uint64_t slabOffset;              // slab 정보 배열
+    uint64_t hotOffset;               // inode chunk
+    uint64_t coldOffset;              // inode_cold chunk
+    uint64_t nameOffset;              // 이름 page
+    uint64_t freeOffset;              // 반환된 블록 번호 stack
+    uint64_t refsOffset;              // 블록 공유 횟수 배열
+    uint64_t zipOffset;               // 블록 압축 상태 배열
+    uint64_t ownerOffset;             // 블록 소유 파일 배열
+    uint64_t dataOffset;              // 데이터 블록
+    uint64_t size;                    // 이미지 전체 크기
+
+    struct statvfs superblock;        // 파일 시스템 메타데이터
+    fsfilcnt_t inodeCapacity;         // root를 제외한 전체 파일 시리얼 넘버 (inode) 개수
+
+    uint32_t slabCount;               // 할당된 slab 개수
+    uint32_t slabPartial;             // 빈 자리가 있는 첫 slab 번호 + 1, 0이면 없음
+    uint32_t slabEmpty;               // 메모리를 반환하지 않고 남겨둔 빈 slab 개수
+    unsigned long slabOut;            // slab 밖으로 나간 inode 개수
+
+    uint32_t namePageCount;           // 할당된 이름 page 개수
+    name_ref nameTop;                 // 아직 자르지 않은 가장 앞 위치
+    name_ref nameFree[NAME_CLASSES];  // slot 크기별 반환된 slot 목록 (slot 앞 4 B로 연결)
+
+    uint32_t dataNext;                // 한 번도 쓰지 않은 첫 블록 번호 (0번은 없음을 의미)
+    uint32_t dataFreeCount;           // 반환된 블록 개수
+
+    uint64_t dirVersion;              // 디렉터리 version 발급용 카운터
+    inode_id orphans;                 // 삭제되었지만 커널이 참조하는 inode 목록 (cold->orphan으로 연결)
+    uint64_t appliedLsn;              // 볼륨에 반영된 마지막 journal 기록 번호
+    uint64_t logicalBlocks;           // 파일들이 가리키는 데이터 블록 개수 합계 (st_blocks 합계, 블록 단위)
+    block_ref zipPack;                // 압축된 블록을 채워 넣는 중인 pack 블록 번호, 0이면 없음
+    uint32_t zipPackUsed;             // zipPack에서 사용한 크기 (B)
+};
+
+static volume_header memory_volume;             // 이미지 파일을 쓰지 않는 경우의 볼륨 정보
+static volume_header *volume = &memory_volume;  // 현재 볼륨 정보
+static char *volume_image;                      // 이미지 파일 mapping 시작 주소, 없으면 NULL
+static int volume_fd = -1;                      // 이미지 파일 fd
+
+// 블록 영역: 볼륨 전체 블록 번호 수만큼 한 번에 예약한 메모리, 데이터 블록과 radix tree 노드를 번호로 할당
+// 블록 번호는 전체 블록 개수의 DATA_REF_FACTOR배 (압축된 블록은 메모리 없이 번호만 차지)
+// 이미지 파일을 사용하면 이미지의 데이터 영역, 아니면 Linux에서는 memfd를 공유 mapping
+// fd가 있으면 블록을 (fd, 위치)로도 참조 가능 (read_buf의 splice)
+static char *data_arena;                    // 블록 영역 시작 주소 (0번 블록 위치)
+static int data_arena_fd = -1;              // 블록 영역 fd, 없으면 -1
+static off_t data_arena_pos;                // fd 안에서 블록 영역 시작 위치
+static uint32_t *data_arena_free;           // 반환된 블록 번호 stack
+static uint32_t *data_arena_refs;           // 블록 번호별 공유 횟수 (자신 외에 블록을 가리키는 파일 위치 수, DEDUP_INDEXED 비트 제외)
+static uint64_t *data_arena_zip;            // 블록 번호별 압축 상태 (ZIP_PACKED, ZIP_PACK), 0이면 압축하지 않은 블록
+static inode_id *data_arena_owner;          // 블록 번호별 다른 위치와 공유하지 않는 데이터 블록의 파일 inode 번호, 0이면 모름
+static uint32_t *data_arena_touch;          // 블록 번호별 마지막으로 읽거나 쓴 시간 (zip_now, 압축을 사용할 때 메모리에만)
+static int data_arena_zeroed = 1;           // dataNext부터의 블록이 0인지 여부 (비정상 종료된 이미지에서 비우지 못하면 모름)
+static pthread_mutex_t data_arena_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// 이어 쓰기 예약: 파일 끝에 블록을 이어 쓰면 블록 번호를 여러 개 미리 가져와 파일 전용으로 두고 차례로 사용
+// 여러 파일에 번갈아 이어 써도 한 파일의 블록이 블록 영역에서 이어지므로 읽기 요청이 블록 위치를 합쳐서 전달
+// 예약 개수는 2개부터 다시 채울 때마다 두 배 (DATA_EXTENT_MAX까지), 잔여 블록 수에는 실제로 쓴 블록만 반영
+// 예약은 메모리에만 두며 (inode 번호 % DATA_EXTENT_SLOTS 자리), 파일을 닫거나 지우거나 다른 파일이 자리를 쓰면 반환
+typedef struct data_extent data_extent;
+struct data_extent {
+    pthread_mutex_t lock;
+    inode_id id;                     // 예약한 파일 inode 번호, 0이면 빈 자리
+    uint64_t next;                   // 예약한 번호로 이어 쓸 다음 블록 index
+    uint32_t size;                   // 마지막으로 예약한 개수
+    uint32_t used;                   // refs 중 사용한 개수
+    uint32_t count;                  // refs에 예약한 개수
+    block_ref zero;                  // 이 번호부터의 refs는 한 번도 쓰지 않은 0인 블록
+    block_ref refs[DATA_EXTENT_MAX]; // 예약한 블록 번호 (오름차순으로 사용)
+};
+
+static data_extent data_extents[DATA_EXTENT_SLOTS];
+static pthread_once_t data_extent_once = PTHREAD_ONCE_INIT;
+
+// 중복 제거: 블록 전체를 쓴 데이터 블록을 내용 hash로 색인하고, 같은 내용을 쓰면 새로 쓴 블록 대신 색인의 블록을 공유
+// 색인된 블록은 공유 횟수에 DEDUP_INDEXED 비트를 표시하며, 언제든 다른 위치가 공유할 수 있으므로 내용을 바꾸지 않음
+// 블록에 쓰기 전에 (data_unshare) 다른 위치가 공유하지 않았으면 색인에서 빼고, 공유했으면 복사
+// 색인은 블록 번호로 연결한 hash chain으로 메모리에만 두고, 이미지 파일은 열 때 표시된 블록으로 다시 생성
+#define DEDUP_INDEXED 0x80000000u // 블록 공유 횟수 중 색인 여부 비트
+
+static int dedup_enabled;                        // 중복 제거 사용 여부
+static uint32_t dedup_mask;                      // 색인 bucket 개수 - 1
+static block_ref *dedup_buckets;                 // bucket별 첫 블록 번호
+static block_ref *dedup_next;                    // 블록 번호별 같은 bucket의 다음 블록 번호
+static uint64_t *dedup_hashes;                   // 블록 번호별 내용 hash
+static pthread_mutex_t dedup_locks[DEDUP_LOCKS]; // bucket lock (bucket 번호 % DEDUP_LOCKS)
+static dedup_stats dedup_counter;                // 중복 제거 통계
+
+// 블록 압축: interval초 동안 읽거나 쓰지 않은 데이터 블록을 압축하여 pack 블록에 모아 저장하고 블록 메모리 반환
+// 압축된 블록도 번호를 유지하므로 radix tree와 공유 횟수는 그대로, 잔여 블록 수는 pack 블록 기준
+// 압축된 블록을 읽으면 압축을 푼 블록 cache에서 복사하고, 쓰기 전에는 블록 메모리에 다시 풀어서 사용
+// 압축 스레드는 변경 요청을 막은 동안 (cut) 반영하며, 읽기 요청이 아직 가리킬 수 있는
+// 블록 메모리와 비워진 pack은 다음 주기에 반환
+#define ZIP_PACKED  (1ULL << 63) // 압축된 블록: 하위 32비트 pack 번호, 다음 16비트 pack 안의 위치, 다음 13비트 크기
+#define ZIP_PACK    (1ULL << 62) // pack 블록: 하위 32비트 사용 중인 크기 (B)
+#define ZIP_RETIRED (1ULL << 61) // 반환을 기다리는 빈 pack 블록 (ZIP_PACK과 함께): 하위 32비트 다음 pack 번호
+#define ZIP_MAX_SIZE (DATA_BLOCK_SIZE * 3 / 4) // 이보다 크게 압축되는 블록은 압축하지 않음 (B)
+
+// 압축을 푼 블록 cache 항목 (블록 번호 위치)
+typedef struct zip_entry zip_entry;
+struct zip_entry {
+    pthread_mutex_t lock;
+    block_ref ref;               // 압축을 푼 블록 번호, 0이면 빈 항목
+    uint64_t desc;               // 압축을 풀 당시 블록 압축 상태
+    char data[DATA_BLOCK_SIZE];  // 압축을 푼 내용
+};
+
+static unsigned zip_interval;                    // 압축 대상이 되는 시간 (초), 0이면 압축하지 않음
+static volatile uint32_t zip_now;                // 압축 스레드가 시작된 뒤 지난 시간 (초)
+static zip_entry zip_cache[ZIP_CACHE_SIZE];      // 압축을 푼 블록 cache
+static pthread_once_t zip_once = PTHREAD_ONCE_INIT;
+static zip_stats zip_counter;                    // 블록 압축 통계
+static block_ref zip_retiring;                   // 이번 주기에 비워진 pack 목록 (ZIP_RETIRED 하위 비트로 연결)
+static block_ref zip_retired;                    // 이전 주기에 비워진 pack 목록, 이번 주기에 반환
+static block_ref zip_pending[ZIP_PASS_BLOCKS];   // 이번 주기에 압축한 블록 번호, 다음 주기에 블록 메모리 반환
+static uint64_t zip_pending_desc[ZIP_PASS_BLOCKS]; // 압축한 블록의 압축 상태
+static unsigned zip_pending_count;               // zip_pending 개수
+
+static pthread_t zip_thread;                     // 주기적으로 블록을 압축하는 스레드
+static int zip_started;                          // zip_thread 실행 여부
+static int zip_stop;                             // zip_thread 종료 요청
+static pthread_mutex_t zip_lock = PTHREAD_MUTEX_INITIALIZER; // 비워진 pack 목록, 스레드 종료 요청 보호
+static pthread_cond_t zip_wake = PTHREAD_COND_INITIALIZER;
+
+// 블록 내보내기 (spill): 사용 중인 블록 메모리가 예산을 넘으면 오래 쓰지 않은 데이터 블록 (CLOCK)을
+// 파일에 기록하고 메모리에서 내림, 내린 블록은 다시 접근하면 커널이 파일에서 읽어 옴
+// 블록 영역은 spill 디렉터리의 이름 없는 파일 (또는 이미지 파일)을 공유 mapping하므로 내려도 내용은 유지
+// 메타데이터 (inode, 이름, radix tree 노드, pack)는 내리지 않음
+// 블록 번호별 상태는 메모리에만 두고, 읽거나 쓰면 (data_touch) 사용 비트를 표시하고 내린 블록이면 다시 읽은 것으로 셈
+#define SPILL_USED 1 // 마지막 CLOCK 확인 이후 읽거나 쓴 블록
+#define SPILL_OUT  2 // 메모리에서 내린 블록
+
+static char *spill_dir;                          // 블록 영역 파일을 만들 디렉터리, 없으면 NULL
+static uint64_t spill_budget;                    // 블록 메모리 예산 (블록 단위), 0이면 내리지 않음
+static uint8_t *spill_state;                     // 블록 번호별 상태 (SPILL_USED, SPILL_OUT)
+static block_ref spill_hand;                     // CLOCK 위치 (다음에 확인할 블록 번호)
+static spill_stats spill_counter;                // 블록 내보내기 통계
+static int spill_wanted;                         // 예산을 넘어 스레드를 깨웠는지 여부
+
+static pthread_t spill_thread;                   // 예산을 넘으면 블록을 내리는 스레드
+static int spill_started;                        // spill_thread 실행 여부
+static int spill_stop;                           // spill_thread 종료 요청
+static pthread_mutex_t spill_lock = PTHREAD_MUTEX_INITIALIZER; // 스레드 종료 요청 보호
+static pthread_cond_t spill_wake = PTHREAD_COND_INITIALIZER;
+
+// checkpoint: 이미지를 private mapping하여 커널이 임의로 파일에 쓰지 않게 하고,
+// 마지막 checkpoint 이후 바뀐 page만 주기적으로 이미지 파일에 기록
+// 요청 도중의 볼륨을 기록하지 않도록 변경 요청이 모두 끝난 시점 (cut)의 page를 기록
+#define CHECKPOINT_PAGE_SHIFT 12  // 바뀐 부분을 기록하는 단위 (2^12 = 4 KB)
+#define CHECKPOINT_PAGE (1u << CHECKPOINT_PAGE_SHIFT)
+#define CHECKPOINT_MAGIC "ASDFSCKP"
+
+// 이중 기록 파일 header: 이미지에 덮어쓰기 전에 page 전체를 먼저 기록
+// header 다음 page부터 page 번호 배열, 그 다음부터 page 내용
+typedef struct checkpoint_header checkpoint_header;
+struct checkpoint_header {
+    char magic[8];     // CHECKPOINT_MAGIC
+    uint32_t complete; // page 내용이 모두 디스크에 기록되었는지 여부
+    uint32_t reserved;
+    uint64_t pages;    // 기록한 page 개수
+    uint64_t size;     // 이미지 전체 크기
+};
+
+static unsigned checkpoint_interval;          // checkpoint 주기 (초), 0이면 이미지를 공유 mapping
+static char *checkpoint_path;                 // 이중 기록 파일 path (이미지 path 뒤에 ".ckpt")
+static uint64_t *dirty_pages;                 // 마지막 checkpoint 이후 바뀐 이미지 page bitmap
+static uint64_t *flush_pages;                 // 기록 중인 checkpoint의 page bitmap
+static size_t dirty_words;                    // bitmap 크기 (uint64_t 개수)
+static checkpoint_stats checkpoint_counter;   // checkpoint 통계
+static void (*checkpoint_done)(uint64_t lsn); // checkpoint가 디스크에 기록된 뒤 호출
+
+static int checkpoint_ops;                    // 볼륨을 변경하는 중인 요청 개수
+static int checkpoint_cutting;                // checkpoint가 새로운 변경을 막고 있는지 여부
+static __thread int checkpoint_depth;         // 현재 스레드의 checkpoint_hold 중첩 횟수
+static pthread_mutex_t checkpoint_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t checkpoint_cond = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t checkpoint_run_lock = PTHREAD_MUTEX_INITIALIZER; // checkpoint 한 번에 하나만
+
+static pthread_t checkpoint_thread;           // 주기적으로 checkpoint하는 스레드
+static int checkpoint_started;                // checkpoint_thread 실행 여부
+static int checkpoint_stop;                   // checkpoint_thread 종료 요청
+static pthread_cond_t checkpoint_wake = PTHREAD_COND_INITIALIZER;
+
+
+// inode table: 번호로 찾는 chunk (slab) 배열, chunk는 한 번 할당되면 옮기지 않음
+#define INODE_CHUNK_SIZE (1u << INODE_CHUNK_SHIFT)
+#define INODE_CHUNK_MAX  (1u << (32 - INODE_CHUNK_SHIFT))
+static inode **inode_chunks;      // 자주 쓰는 값 chunk 배열 (INODE_CHUNK_MAX 크기)
+static inode_cold **cold_chunks;  // 자주 쓰지 않는 파일 정보 chunk 배열 (INODE_CHUNK_MAX 크기)
+
+// inode slab: 같은 번호의 hot/cold chunk 한 쌍
+typedef struct inode_slab inode_slab;
+struct inode_slab {
+    inode_id free;     // 반환된 inode 번호 목록 (parent 필드로 연결)
+    uint32_t next;     // 아직 한 번도 쓰지 않은 첫 위치 (slab 안의 위치)
+    uint32_t live;     // slab 밖으로 나간 (사용 중이거나 magazine에 있는) inode 개수
+    uint32_t partial;  // 빈 자리가 있는 다음 slab 번호 + 1, 0이면 마지막
+    int listed;        // partial 목록에 있는지 여부
+    int released;      // 메모리를 OS에 반환했는지 여부
+};
+
+static inode_slab *slabs;         // slab 정보 배열 (INODE_CHUNK_MAX 크기)
+static unsigned long magazine_objects; // 모든 스레드의 magazine에 있는 inode 개수
+static pthread_mutex_t slab_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// 스레드별 inode 번호 cache: slab_lock 없이 할당/반환
+typedef struct inode_magazine inode_magazine;
+struct inode_magazine {
+    uint32_t count;                      // 들어 있는 번호 개수
+    int registered;                      // 스레드 종료 시 반환하도록 등록했는지 여부
+    inode_id ids[INODE_MAGAZINE_SIZE];   // inode 번호
+};
+
+static __thread inode_magazine magazine;
+static pthread_key_t magazine_key;
+static pthread_once_t magazine_once = PTHREAD_ONCE_INIT;
+
+// 이름 arena: 64 KB page를 2의 거듭제곱 크기 slot으로 잘라 이름 저장
+static char **name_pages;                 // page 배열, 크기가 고정되어 잠금 없이 읽음
+static pthread_mutex_t name_lock = PTHREAD_MUTEX_INITIALIZER; // 빈 slot 목록, 남은 공간 보호
+
+// dentry cache 항목: path에 해당하는 EXACT_FOUND 검색 결과
+// 또는 없는 path의 EXACT_NOT_FOUND/HEAD_NOT_FOUND 검색 결과 (negative 항목)
+typedef struct dcache_entry dcache_entry;
+struct dcache_entry {
+    uint64_t hash;            // path 해시 값
+    unsigned long generation; // 저장 당시 dcache_generation, 0이면 빈 항목
+    unsigned long negative_generation; // 저장 당시 dcache_negative_generation
+    uid_t uid;                // 탐색 권한을 확인한 호출 프로세스의 uid
+    gid_t gid;                // 탐색 권한을 확인한 호출 프로세스의 gid
+    asdfs_errno code;         // 검색 결과 주요 오류 번호
+    inode *parent;            // 상위 inode 객체 포인터
+                              // negative 항목은 없는 component를 검색한 디렉터리
+    inode *exact;             // path에 해당하는 inode 객체 포인터, negative 항목은 NULL
+    uint64_t version;         // negative 항목 저장 당시 parent->version
+                              // 고정된 디렉터리 항목은 next 기록 당시 exact->version
+    inode *next;              // 고정된 디렉터리 항목에서 다음에 검색할 것으로 예상되는 하위 inode
+    char path[DCACHE_PATH_MAX];
+};
+
+static dcache_entry dcache[DCACHE_SIZE];      // path 해시 값으로 위치가 정해지는 dentry cache
+static dcache_entry dcache_held[DCACHE_HELD_SIZE]; // 목록을 읽는 중인 디렉터리 항목, 다른 path로 교체되지 않음
+static unsigned int dcache_held_next;         // 다음에 교체할 dcache_held 위치
+static unsigned long dcache_generation = 1;   // 증가하면 이전 항목 전부 무효
+static unsigned long dcache_negative_generation = 1; // 증가하면 이전 negative 항목 전부 무효
+static dcache_stats dcache_counter;           // hit/miss 횟수
+static pthread_mutex_t dcache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// 이름 공간 (inode tree, 이름 색인, sibling 목록, orphan 목록) 잠금
+// 이름을 찾거나 목록을 읽는 요청은 읽기, 항목을 만들거나 지우거나 옮기는 요청은 쓰기로 잡음
+static pthread_rwlock_t namespace_lock = PTHREAD_RWLOCK_INITIALIZER;
+static __thread int namespace_depth;          // 현재 스레드의 namespace_hold 중첩 횟수
+
+// 이전 마운트의 lookup 횟수 초기화 잠금 (횟수 증가와 감소는 atomic 연산)
+static pthread_mutex_t lookup_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// 호출 프로세스 자격 정보: 한 요청 동안 모든 권한 확인에 사용
+typedef struct credential credential;
+struct credential {
+    uid_t uid;                // 호출 프로세스의 uid
+    gid_t gid;                // 호출 프로세스의 gid
+    pid_t pid;                // 호출 프로세스의 pid
+    int ngroups;              // supplementary groups 개수, -1이면 아직 조회하지 않음
+    gid_t groups[GROUPS_MAX]; // supplementary groups
+};
+
+// pid별 supplementary groups cache 항목
+typedef struct cred_entry cred_entry;
+struct cred_entry {
+    pid_t pid;                       // 호출 프로세스의 pid
+    uid_t uid;                       // 조회 당시 uid
+    gid_t gid;                       // 조회 당시 gid
+    uint64_t expire;                 // 유효 기한 (ms, CLOCK_MONOTONIC), 0이면 빈 항목
+    int ngroups;                     // supplementary groups 개수
+    gid_t groups[CRED_CACHE_GROUPS]; // supplementary groups
+};
+
+static cred_entry cred_cache[CRED_CACHE_SIZE];   // pid 위치의 supplementary groups cache
+static cred_stats cred_counter;                  // hit/miss 횟수
+static pthread_mutex_t cred_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int replaying;                                // journal 기록을 다시 적용하는 중인지 여부
+static __thread fuse_req_t request;                  // 현재 스레드가 처리 중인 low-level 요청
+static __thread struct fuse_context request_context; // request의 호출 프로세스 정보
+
+// 현재 요청의 호출 프로세스 정보 반환
+// low-level 요청이 지정되지 않았으면 high-level fuse context 사용
+static struct fuse_context *get_context() {
+    return request ? &request_context : fuse_get_context();
 }
 
-// 호출 프로세스가 해당 inode에 읽기 권한이 있는지 확인
-int can_read(inode *node) {
-    // 현재 fuse context, 호출 프로세스의 uid, gid.
-    struct fuse_context *context = fuse_get_context();
-    uid_t curr_uid = context->uid;
-    uid_t curr_gid = context->gid;
+// 현재 요청의 호출 프로세스 supplementary groups를 list에 기록, 개수 반환
+static int get_groups(int size, gid_t list[]) {
+    return request ? fuse_req_getgroups(request, size, list) : fuse_getgroups(size, list);
+}
 
-    // node의 파일 권한, 소유자 uid, 그룹 gid.
-    mode_t file_mode = node->attr.st_mode;
-    uid_t file_uid = node->attr.st_uid;
-    uid_t file_gid = node->attr.st_gid;
+// 현재 스레드가 처리 중인 low-level 요청 지정, NULL이면 high-level fuse context 사용
+void set_request(fuse_req_t req) {
+    request = req;
+    if (req == NULL) {
+        return;
+    }
 
-    // owner이고, 파일에 owner READ 권한이 있는 경우
-    if (((curr_uid == file_uid) && (file_mode & S_IRUSR))
-        // owner는 아니지만 group에 속하고, 파일에 group READ 권한이 있는 경우
-        || ((curr_gid == file_gid) && (file_mode & S_IRGRP)) ) {
-        return 1;
+    // 요청의 호출 프로세스 uid, gid, pid, umask
+    const struct fuse_ctx *ctx = fuse_req_ctx(req);
+    request_context.uid = ctx->uid;
+    request_context.gid = ctx->gid;
+    request_context.pid = ctx->pid;
+    request_context.umask = ctx->umask;
+}
+
+// journal 기록을 다시 적용하는 동안 권한 확인 생략 (기록할 때 이미 확인)
+// 끝나면 생략한 결과가 남지 않도록 dentry cache 전체 무효화
+void set_replay(int on) {
+    replaying = on;
+    if (!on) {
+        dcache_invalidate_all();
+    }
+}
+
+// 번호 id의 inode 반환, 0이면 NULL
+inode *get_inode(inode_id id) {
+    if (id == 0) {
+        return NULL;
     }
+    return &inode_chunks[id >> INODE_CHUNK_SHIFT][id & (INODE_CHUNK_SIZE - 1)];
+}
 
-    // supplementary groups 확인
-    gid_t list[512];
-    int length = fuse_getgroups(512, list);
-    for (int i=0; i<length && i<512; i++) {
-        uid_t supp_gid = list[i];
+// node의 자주 쓰지 않는 파일 정보 반환
+inode_cold *get_cold(inode *node) {
+    inode_id id = node->id;
+    return &cold_chunks[id >> INODE_CHUNK_SHIFT][id & (INODE_CHUNK_SIZE - 1)];
+}
 
-        // owner는 아니지만 supplementary group에 속하고,
-        // 파일에 group READ 권한이 있는 경우
-        if ((supp_gid == file_gid) && (file_mode & S_IRGRP)) {
-            return 1;
+// node의 번호 반환, NULL이면 0
+static inode_id node_id(inode *node) {
+    return node ? node->id : 0;
+}
+
+// ptr부터 size 바이트가 바뀌었음을 기록, 다음 checkpoint에서 해당 page를 이미지 파일에 기록
+// checkpoint를 사용하지 않거나 이미지 밖의 메모리이면 무시
+static void dirty_range(const void *ptr, size_t size) {
+    if (dirty_pages == NULL || size == 0) {
+        return;
+    }
+    uintptr_t pos = (uintptr_t)ptr - (uintptr_t)volume_image;
+    if ((uintptr_t)ptr < (uintptr_t)volume_image || pos >= volume->size) {
+        return;
+    }
+    for (uintptr_t page = pos >> CHECKPOINT_PAGE_SHIFT; page <= (pos + size - 1) >> CHECKPOINT_PAGE_SHIFT; page++) {
+        uint64_t bit = (uint64_t)1 << (page % 64);
+        // 이미 기록된 bit는 다시 쓰지 않음 (cache line 경합 방지)
+        if (!(dirty_pages[page / 64] & bit)) {
+            __sync_fetch_and_or(&dirty_pages[page / 64], bit);
         }
     }
+}
 
-    // 그 외 others이고, 파일에 others READ 권한이 있는 경우
-    if (file_mode & S_IROTH) {
+// node의 inode, inode_cold가 바뀌었음을 기록
+void dirty_inode(inode *node) {
+    if (node == NULL) {
+        return;
+    }
+    dirty_range(node, sizeof(inode));
+    dirty_range(get_cold(node), sizeof(inode_cold));
+}
+
+// node의 파일 정보를 stat 구조체로 반환
+struct stat get_attr(inode *node) {
+    inode_cold *cold = get_cold(node);
+    struct stat attr;
+    memset(&attr, 0, sizeof(attr));
+
+    attr.st_ino    = node->id;    // 파일 시리얼 넘버는 inode 번호 사용
+    attr.st_mode   = node->mode;
+    attr.st_uid    = node->uid;
+    attr.st_gid    = node->gid;
+    attr.st_nlink  = cold->nlink;
+    attr.st_rdev   = cold->rdev;
+    attr.st_size   = cold->size;
+    attr.st_blocks = cold->blocks * (DATA_BLOCK_SIZE / 512) - cold->zipSaved; // 512 B 단위, 압축으로 줄어든 크기 제외
+    attr.st_atime  = cold->atime;
+    attr.st_mtime  = cold->mtime;
+    attr.st_ctime  = cold->ctime;
+    return attr;
+}
+
+// 크기 size의 0으로 채운 메모리를 OS에서 바로 할당, 실패하면 NULL 반환
+static void *map_zero(size_t size) {
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+// ptr부터 size 바이트의 메모리를 OS에 반환, 다음에 접근하면 0으로 채워진 page
+// 이미지 파일 공유 mapping은 파일의 해당 부분도 비움
+// (private mapping은 파일 내용으로 돌아가지만 다시 쓰기 전에 항상 초기화하는 영역만 반환)
+static void release_pages(void *ptr, size_t size) {
+#ifdef MADV_REMOVE
+    if (volume_image && checkpoint_interval == 0) {
+        madvise(ptr, size, MADV_REMOVE);
+        return;
+    }
+#endif
+    madvise(ptr, size, MADV_DONTNEED);
+}
+
+// 블록 번호 ref의 위치 반환
+static char *data_at(block_ref ref) {
+    return data_arena + (size_t)ref * DATA_BLOCK_SIZE;
+}
+
+// 블록 번호 개수 (0번 제외)
+static block_ref data_arena_max() {
+    return (block_ref)(volume->superblock.f_blocks * DATA_REF_FACTOR);
+}
+
+// 중복 제거 색인 생성
+asdfs_errno enable_dedup() {
+    if (dedup_enabled) {
+        return NO_ERROR;
+    }
+
+    // volume_layout과 같은 전체 블록 번호 개수, bucket은 번호 개수 이상의 2의 거듭제곱
+    uint64_t blocks = VOLUME_SIZE_MB * 1024 / BLOCK_SIZE_KB * DATA_REF_FACTOR;
+    uint64_t buckets = 1;
+    while (buckets < blocks) {
+        buckets <<= 1;
+    }
+    dedup_buckets = (block_ref *)map_zero(sizeof(block_ref) * buckets);
+    dedup_next = (block_ref *)map_zero(sizeof(block_ref) * (blocks + 1));
+    dedup_hashes = (uint64_t *)map_zero(sizeof(uint64_t) * (blocks + 1));
+    if (dedup_buckets == NULL || dedup_next == NULL || dedup_hashes == NULL) {
+        return GENERAL_ERROR;
+    }
+    dedup_mask = (uint32_t)(buckets - 1);
+    for (int i=0; i<DEDUP_LOCKS; i++) {
+        pthread_mutex_init(&dedup_locks[i], NULL);
+    }
+    dedup_enabled = 1;
+    return NO_ERROR;
+}
+
+// 내용 hash의 색인 bucket 번호
+static uint32_t dedup_bucket(uint64_t hash) {
+    return (uint32_t)hash & dedup_mask;
+}
+
+// bucket의 lock
+static pthread_mutex_t *dedup_lock(uint32_t bucket) {
+    return &dedup_locks[bucket % DEDUP_LOCKS];
+}
+
+// 블록 ref를 내용 hash로 색인에 추가 (bucket lock 필요)
+static void dedup_link(block_ref ref, uint64_t hash) {
+    uint32_t bucket = dedup_bucket(hash);
+    dedup_hashes[ref] = hash;
+    dedup_next[ref] = dedup_buckets[bucket];
+    dedup_buckets[bucket] = ref;
+    __sync_fetch_and_add(&dedup_counter.indexed, 1);
+}
+
+// 이미지 파일에서 색인 표시된 블록으로 색인 다시 생성 (마운트 전에 호출)
+static void dedup_rebuild() {
+    for (block_ref ref=1; ref<volume->dataNext; ref++) {
+        if (data_arena_refs[ref] & DEDUP_INDEXED) {
+            dedup_link(ref, hash_data(data_at(ref), DATA_BLOCK_SIZE));
+        }
+    }
+}
+
+// 다른 위치가 공유하지 않고 색인에만 있는 블록 ref를 색인에서 뺌 (블록을 가리키는 위치에서만 호출)
+// 그 사이 다른 위치가 공유하여 뺄 수 없으면 0 반환
+// 중복 제거 없이 연 이미지 파일의 블록은 표시만 지움
+static int dedup_remove(block_ref ref) {
+    if (!dedup_enabled) {
+        if (!__sync_bool_compare_and_swap(&data_arena_refs[ref], DEDUP_INDEXED, 0)) {
+            return 0;
+        }
+        dirty_range(&data_arena_refs[ref], sizeof(uint32_t));
         return 1;
     }
 
+    // 색인 검색과 같은 lock 안에서 표시를 지워 검색 중인 스레드와 경합하지 않음
+    uint32_t bucket = dedup_bucket(dedup_hashes[ref]);
+    pthread_mutex_lock(dedup_lock(bucket));
+    int removed = __sync_bool_compare_and_swap(&data_arena_refs[ref], DEDUP_INDEXED, 0);
+    if (removed) {
+        block_ref *link = &dedup_buckets[bucket];
+        while (*link != 0 && *link != ref) {
+            link = &dedup_next[*link];
+        }
+        if (*link == ref) {
+            *link = dedup_next[ref];
+            __sync_fetch_and_sub(&dedup_counter.indexed, 1);
+        }
+    }
+    pthread_mutex_unlock(dedup_lock(bucket));
+    if (removed) {
+        dirty_range(&data_arena_refs[ref], sizeof(uint32_t));
+    }
+    return removed;
+}
+
+// 블록 압축 사용, interval초 동안 읽거나 쓰지 않은 블록을 압축 (start_compress)
+asdfs_errno enable_compress(unsigned interval) {
+    if (interval == 0 || zip_interval != 0) {
+        return NO_ERROR;
+    }
+
+    // volume_layout과 같은 전체 블록 번호 개수
+    uint64_t blocks = VOLUME_SIZE_MB * 1024 / BLOCK_SIZE_KB * DATA_REF_FACTOR;
+    data_arena_touch = (uint32_t *)map_zero(sizeof(uint32_t) * (blocks + 1));
+    if (data_arena_touch == NULL) {
+        return GENERAL_ERROR;
+    }
+    zip_interval = interval;
+    return NO_ERROR;
+}
+
+// dir에 크기 size의 이름 없는 파일을 만들어 fd 반환, 실패하면 -1
+static int spill_create(const char *dir, size_t size) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/asdfs.XXXXXX", dir);
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return -1;
+    }
+    unlink(path);
+    if (ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 블록 내보내기 사용, 블록 메모리가 budget MB를 넘으면 블록을 내림 (start_spill)
+asdfs_errno enable_spill(const char *dir, unsigned budget) {
+    if (spill_state != NULL) {
+        return NO_ERROR;
+    }
+
+    // 마운트 전에 디렉터리에 파일을 만들 수 있는지 확인
+    if (dir != NULL) {
+        int fd = spill_create(dir, 0);
+        if (fd < 0) {
+            fprintf(stderr, "asdfs_enable_spill %s: %s\n", dir, strerror(errno));
+            return GENERAL_ERROR;
+        }
+        close(fd);
+        spill_dir = strdup(dir);
+    }
+
+    // volume_layout과 같은 전체 블록 번호 개수
+    uint64_t blocks = VOLUME_SIZE_MB * 1024 / BLOCK_SIZE_KB * DATA_REF_FACTOR;
+    spill_state = (uint8_t *)map_zero(blocks + 1);
+    if (spill_state == NULL || (dir != NULL && spill_dir == NULL)) {
+        return GENERAL_ERROR;
+    }
+    spill_budget = (uint64_t)budget * 1024 / BLOCK_SIZE_KB;
+    return NO_ERROR;
+}
+
+// 압축된 블록 상태 desc의 pack 블록 번호
+static block_ref zip_pack_of(uint64_t desc) {
+    return (block_ref)desc;
+}
+
+// 압축된 블록 상태 desc의 pack 안의 위치 (B)
+static uint32_t zip_offset(uint64_t desc) {
+    return (uint32_t)(desc >> 32) & 0xFFFF;
+}
+
+// 압축된 블록 상태 desc의 압축된 크기 (B)
+static uint32_t zip_size(uint64_t desc) {
+    return (uint32_t)(desc >> 48) & 0x1FFF;
+}
+
+// 압축된 블록 상태 desc의 압축된 내용 위치
+static const char *zip_data(uint64_t desc) {
+    return data_at(zip_pack_of(desc)) + zip_offset(desc);
+}
+
+// 이미지 파일의 압축 상태 정리 및 통계 다시 계산 (마운트 전에 호출)
+// 반환을 기다리던 pack은 반환하고, 압축된 블록에 남은 블록 메모리는 OS에 반환
+static void zip_rebuild() {
+    for (block_ref ref=1; ref<volume->dataNext; ref++) {
+        uint64_t desc = data_arena_zip[ref];
+        if (desc & ZIP_RETIRED) {
+            data_arena_zip[ref] = 0;
+            dirty_range(&data_arena_zip[ref], sizeof(uint64_t));
+            dirty_range(&data_arena_free[volume->dataFreeCount], sizeof(uint32_t));
+            data_arena_free[volume->dataFreeCount++] = ref;
+        }
+        else if (desc & ZIP_PACK) {
+            zip_counter.packs++;
+        }
+        else if (desc & ZIP_PACKED) {
+            zip_counter.blocks++;
+            zip_counter.bytes += zip_size(desc);
+            release_pages(data_at(ref), DATA_BLOCK_SIZE);
+        }
+    }
+}
+
+// slab을 partial 목록 앞에 추가 (slab_lock 필요)
+static void slab_list(uint32_t index) {
+    if (!slabs[index].listed) {
+        slabs[index].partial = volume->slabPartial;
+        slabs[index].listed = 1;
+        volume->slabPartial = index + 1;
+        dirty_range(&slabs[index], sizeof(inode_slab));
+    }
+}
+
+// 새로운 slab 할당 후 partial 목록에 추가, 실패하면 -1 반환 (slab_lock 필요)
+static int slab_grow() {
+    // 번호 배열은 최대 크기로 한 번만 할당 (사용하는 부분만 메모리 차지)
+    if (slabs == NULL) {
+        inode_chunks = (inode **)map_zero(sizeof(inode *) * INODE_CHUNK_MAX);
+        cold_chunks = (inode_cold **)map_zero(sizeof(inode_cold *) * INODE_CHUNK_MAX);
+        slabs = (inode_slab *)map_zero(sizeof(inode_slab) * INODE_CHUNK_MAX);
+        if (inode_chunks == NULL || cold_chunks == NULL || slabs == NULL) {
+            return -1;
+        }
+    }
+
+    // 번호가 32비트를 넘거나 이미지의 inode 영역이 가득 찬 경우
+    if (volume->slabCount == (volume_image ? volume->slabMax : INODE_CHUNK_MAX)) {
+        return -1;
+    }
+
+    // 이미지 파일을 사용하면 chunk 위치는 open_volume에서 정해짐
+    uint32_t index = volume->slabCount;
+    if (!volume_image) {
+        // page 경계 (cache line 경계)에 맞춘 chunk 할당
+        inode *chunk = (inode *)map_zero(sizeof(inode) * INODE_CHUNK_SIZE);
+        inode_cold *cold = (inode_cold *)map_zero(sizeof(inode_cold) * INODE_CHUNK_SIZE);
+        if (chunk == NULL || cold == NULL) {
+            if (chunk) munmap(chunk, sizeof(inode) * INODE_CHUNK_SIZE);
+            if (cold) munmap(cold, sizeof(inode_cold) * INODE_CHUNK_SIZE);
+            return -1;
+        }
+        inode_chunks[index] = chunk;
+        cold_chunks[index] = cold;
+    }
+    volume->slabCount++;
+
+    // 0번은 없음을 의미하므로 첫 slab은 1번부터 사용
+    slabs[index].next = index == 0 ? 1 : 0;
+    dirty_range(&slabs[index], sizeof(inode_slab));
+    slab_list(index);
+    return 0;
+}
+
+// slab에서 inode 번호를 최대 count개 꺼내 ids에 기록, 꺼낸 개수 반환 (slab_lock 필요)
+static uint32_t slab_take(inode_id *ids, uint32_t count) {
+    uint32_t taken = 0;
+    while (taken < count) {
+        // 빈 자리가 있는 slab이 없으면 새로운 slab 할당
+        if (volume->slabPartial == 0 && slab_grow() != 0) {
+            break;
+        }
+
+        uint32_t index = volume->slabPartial - 1;
+        inode_slab *slab = &slabs[index];
+        dirty_range(slab, sizeof(inode_slab));
+
+        // 빈 slab을 다시 사용
+        if (slab->live == 0 && !slab->released && volume->slabEmpty > 0 && index != 0) {
+            volume->slabEmpty--;
+        }
+        slab->released = 0;
+
+        // 반환된 번호 먼저, 없으면 아직 쓰지 않은 위치에서 꺼냄
+        while (taken < count && (slab->free || slab->next < INODE_CHUNK_SIZE)) {
+            inode_id id = slab->free;
+            if (id) {
+                slab->free = get_inode(id)->parent;
+            }
+            else {
+                id = (inode_id)((index << INODE_CHUNK_SHIFT) | slab->next++);
+            }
+            ids[taken++] = id;
+            slab->live++;
+        }
+
+        // 빈 자리가 없어진 slab은 partial 목록에서 제거
+        if (!slab->free && slab->next == INODE_CHUNK_SIZE) {
+            volume->slabPartial = slab->partial;
+            slab->listed = 0;
+        }
+    }
+
+    // magazine은 뒤에서부터 꺼내므로 작은 번호가 먼저 나오도록 뒤집음
+    for (uint32_t i=0; i<taken/2; i++) {
+        inode_id id = ids[i];
+        ids[i] = ids[taken - 1 - i];
+        ids[taken - 1 - i] = id;
+    }
+    volume->slabOut += taken;
+    return taken;
+}
+
+// inode 번호 count개를 각 slab에 반환 (slab_lock 필요)
+// 모두 비는 slab은 하나만 남기고 메모리를 OS에 반환
+static void slab_put(const inode_id *ids, uint32_t count) {
+    for (uint32_t i=0; i<count; i++) {
+        uint32_t index = ids[i] >> INODE_CHUNK_SHIFT;
+        inode_slab *slab = &slabs[index];
+
+        get_inode(ids[i])->parent = slab->free;
+        dirty_range(get_inode(ids[i]), sizeof(inode));
+        slab->free = ids[i];
+        dirty_range(slab, sizeof(inode_slab));
+        slab->live--;
+        slab_list(index);
+
+        // slab이 모두 빈 경우
+        if (slab->live == 0 && index != 0) {
+            if (volume->slabEmpty == 0) {
+                // 다음 할당을 위해 하나는 남겨둠
+                volume->slabEmpty++;
+            }
+            else {
+                // hot/cold chunk 메모리를 OS에 반환
+                release_pages(inode_chunks[index], sizeof(inode) * INODE_CHUNK_SIZE);
+                release_pages(cold_chunks[index], sizeof(inode_cold) * INODE_CHUNK_SIZE);
+                slab->free = 0;
+                slab->next = 0;
+                slab->released = 1;
+            }
+        }
+    }
+    volume->slabOut -= count;
+}
+
+// 스레드 종료 시 magazine의 inode 번호를 slab에 반환
+static void magazine_drain_all(void *arg) {
+    inode_magazine *mag = (inode_magazine *)arg;
+    CHECKPOINT_HOLD();
+    pthread_mutex_lock(&slab_lock);
+    slab_put(mag->ids, mag->count);
+    magazine_objects -= mag->count;
+    pthread_mutex_unlock(&slab_lock);
+    mag->count = 0;
+}
+
+// magazine_key 생성
+static void magazine_key_create() {
+    pthread_key_create(&magazine_key, magazine_drain_all);
+}
+
+// inode table에서 빈 inode 할당, 실패하면 NULL 반환
+static inode *alloc_inode() {
+    inode_magazine *mag = &magazine;
+
+    // magazine이 비었으면 slab에서 절반만큼 한 번에 채움
+    if (mag->count == 0) {
+        if (!mag->registered) {
+            pthread_once(&magazine_once, magazine_key_create);
+            pthread_setspecific(magazine_key, mag);
+            mag->registered = 1;
+        }
+
+        pthread_mutex_lock(&slab_lock);
+        mag->count = slab_take(mag->ids, INODE_MAGAZINE_SIZE / 2);
+        magazine_objects += mag->count;
+        pthread_mutex_unlock(&slab_lock);
+        if (mag->count == 0) {
+            return NULL;
+        }
+    }
+    inode_id id = mag->ids[--mag->count];
+    __sync_fetch_and_sub(&magazine_objects, 1);
+
+    // root가 아닌 inode는 파일 개수에 포함
+    if (id != ROOT_INODE_ID) {
+        __sync_fetch_and_add(&volume->superblock.f_files, 1);
+    }
+
+    // inode 초기화
+    inode *node = &inode_chunks[id >> INODE_CHUNK_SHIFT][id & (INODE_CHUNK_SIZE - 1)];
+    memset(node, 0, sizeof(inode));
+    node->id = id;
+    memset(&cold_chunks[id >> INODE_CHUNK_SHIFT][id & (INODE_CHUNK_SIZE - 1)], 0, sizeof(inode_cold));
+    dirty_inode(node);
+    return node;
+}
+
+// 이름 번호 ref의 문자열 위치 반환
+static char *name_at(name_ref ref) {
+    return name_pages[ref >> NAME_PAGE_SHIFT] + (ref & (NAME_PAGE_SIZE - 1));
+}
+
+// node의 파일 이름 반환 (NUL로 끝남)
+const char *get_name(inode *node) {
+    return name_at(node->name);
+}
+
+// 길이 length인 이름의 해시 값 계산 (FNV-1a)
+static uint32_t name_hash(const char *name, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i=0; i<length; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// 길이 length인 이름 (NUL 포함)이 들어가는 slot 크기 종류 반환
+static int name_class(size_t length) {
+    int class = 0;
+    while ((size_t)(NAME_SLOT_MIN << class) < length + 1) {
+        class++;
+    }
+    return class;
+}
+
+// class 크기의 slot 할당, 실패하면 0 반환 (name_lock 필요)
+static name_ref name_take(int class) {
+    uint32_t size = NAME_SLOT_MIN << class;
+
+    // 반환된 slot이 있으면 재사용
+    name_ref ref = volume->nameFree[class];
+    if (ref) {
+        memcpy(&volume->nameFree[class], name_at(ref), sizeof(name_ref));
+        return ref;
+    }
+
+    // 현재 page가 없거나 남은 공간이 없으면 새로운 page 할당
+    if ((volume->nameTop >> NAME_PAGE_SHIFT) >= volume->namePageCount
+        || (volume->nameTop & (NAME_PAGE_SIZE - 1)) + size > NAME_PAGE_SIZE) {
+        // 이름 번호가 32비트를 넘거나 이미지의 이름 영역이 가득 찬 경우
+        if (volume->namePageCount == (volume_image ? volume->namePageMax : NAME_PAGE_MAX)) {
+            return 0;
+        }
+
+        // 이미지 파일을 사용하면 page 위치는 open_volume에서 정해짐
+        if (!volume_image) {
+            // page 배열은 최대 크기로 한 번만 할당 (name_at이 잠금 없이 읽는 도중 옮겨지지 않음, 사용하는 부분만 메모리 차지)
+            if (name_pages == NULL) {
+                name_pages = (char **)map_zero(sizeof(char *) * NAME_PAGE_MAX);
+                if (name_pages == NULL) {
+                    return 0;
+                }
+            }
+            name_pages[volume->namePageCount] = (char *)malloc(NAME_PAGE_SIZE);
+            if (name_pages[volume->namePageCount] == NULL) {
+                return 0;
+            }
+        }
+
+        // 0번은 없음을 의미하므로 첫 page는 NAME_SLOT_MIN부터 사용
+        volume->nameTop = (name_ref)(volume->namePageCount << NAME_PAGE_SHIFT);
+        if (volume->namePageCount == 0) {
+            volume->nameTop = NAME_SLOT_MIN;
+        }
+        volume->namePageCount++;
+    }
+
+    // page의 남은 공간 앞에서 slot 자르기
+    ref = volume->nameTop;
+    volume->nameTop += size;
+    return ref;
+}
+
+// class 크기의 slot 할당, 실패하면 0 반환
+// 서로 다른 디렉토리의 변경은 동시에 실행되므로 잠금 필요
+static name_ref name_alloc(int class) {
+    pthread_mutex_lock(&name_lock);
+    name_ref ref = name_take(class);
+    pthread_mutex_unlock(&name_lock);
+    return ref;
+}
+
+// class 크기의 slot ref 반환
+static void name_release(name_ref ref, int class) {
+    if (ref == 0) {
+        return;
+    }
+    pthread_mutex_lock(&name_lock);
+    memcpy(name_at(ref), &volume->nameFree[class], sizeof(name_ref));
+    dirty_range(name_at(ref), sizeof(name_ref));
+    volume->nameFree[class] = ref;
+    pthread_mutex_unlock(&name_lock);
+}
+
+// node의 이름 slot을 반환하고 번호를 magazine에 반환
+static void free_inode(inode *node) {
+    name_release(node->name, name_class(node->nameLength));
+    node->name = 0;
+    __sync_fetch_and_sub(&volume->superblock.f_files, 1);
+
+    // magazine이 가득 찼으면 절반을 slab에 한 번에 반환
+    inode_magazine *mag = &magazine;
+    if (mag->count == INODE_MAGAZINE_SIZE) {
+        uint32_t half = INODE_MAGAZINE_SIZE / 2;
+        pthread_mutex_lock(&slab_lock);
+        slab_put(mag->ids + half, half);
+        magazine_objects -= half;
+        pthread_mutex_unlock(&slab_lock);
+        mag->count = half;
+    }
+    if (!mag->registered) {
+        pthread_once(&magazine_once, magazine_key_create);
+        pthread_setspecific(magazine_key, mag);
+        mag->registered = 1;
+    }
+    mag->ids[mag->count++] = node->id;
+    __sync_fetch_and_add(&magazine_objects, 1);
+}
+
+// inode 할당 통계 반환
+inode_stats get_inode_stats() {
+    inode_stats stats;
+    pthread_mutex_lock(&slab_lock);
+    stats.cached = magazine_objects;
+    stats.live = volume->slabOut - magazine_objects;
+    stats.slabs = volume->slabCount;
+    stats.released = 0;
+    for (uint32_t i=0; i<volume->slabCount; i++) {
+        stats.released += slabs[i].released;
+    }
+    stats.free = (unsigned long)(volume->slabCount - stats.released) * INODE_CHUNK_SIZE - volume->slabOut;
+    pthread_mutex_unlock(&slab_lock);
+    return stats;
+}
+
+// 현재 요청의 호출 프로세스 uid, gid, pid로 cred 초기화
+// supplementary groups는 처음 필요할 때 credential_groups에서 조회
+static void get_credential(credential *cred) {
+    struct fuse_context *context = get_context();
+    cred->uid = context->uid;
+    cred->gid = context->gid;
+    cred->pid = context->pid;
+    cred->ngroups = -1;
+}
+
+// 현재 시간 (ms, CLOCK_MONOTONIC)
+static uint64_t now_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+// cred의 supplementary groups 개수 반환
+// 요청마다 한 번만 pid별 cache 또는 fuse_getgroups (/proc 파싱)에서 조회
+static int credential_groups(credential *cred) {
+    // 이번 요청에서 이미 조회한 경우
+    if (cred->ngroups >= 0) {
+        return cred->ngroups;
+    }
+
+    uint64_t now = now_ms();
+    cred_entry *entry = &cred_cache[(unsigned)cred->pid % CRED_CACHE_SIZE];
+
+    // 유효 시간 안에 같은 pid, uid, gid로 조회한 결과가 있는 경우
+    pthread_mutex_lock(&cred_lock);
+    if (entry->expire > now
+        && entry->pid == cred->pid
+        && entry->uid == cred->uid
+        && entry->gid == cred->gid) {
+        cred->ngroups = entry->ngroups;
+        memcpy(cred->groups, entry->groups, sizeof(gid_t) * entry->ngroups);
+        cred_counter.hit++;
+    }
+    pthread_mutex_unlock(&cred_lock);
+    if (cred->ngroups >= 0) {
+        return cred->ngroups;
+    }
+
+    // supplementary groups 조회
+    int length = get_groups(GROUPS_MAX, cred->groups);
+    if (length < 0) {
+        length = 0;
+    }
+    if (length > GROUPS_MAX) {
+        length = GROUPS_MAX;
+    }
+    cred->ngroups = length;
+
+    // cache 항목에 들어가는 개수면 저장
+    pthread_mutex_lock(&cred_lock);
+    cred_counter.miss++;
+    if (length <= CRED_CACHE_GROUPS) {
+        entry->pid = cred->pid;
+        entry->uid = cred->uid;
+        entry->gid = cred->gid;
+        entry->expire = now + CRED_CACHE_TTL_MS;
+        entry->ngroups = length;
+        memcpy(entry->groups, cred->groups, sizeof(gid_t) * length);
+    }
+    pthread_mutex_unlock(&cred_lock);
+
+    return length;
+}
+
+// 호출 프로세스가 gid 그룹을 supplementary group으로 가지는지 확인
+static int in_groups(credential *cred, gid_t gid) {
+    int length = credential_groups(cred);
+    for (int i=0; i<length; i++) {
+        if (cred->groups[i] == gid) {
+            return 1;
+        }
+    }
     return 0;
 }
 
-// 호출 프로세스가 해당 inode에 쓰기 권한이 있는지 확인
-int can_write(inode *node) {
-    // 현재 fuse context, 호출 프로세스의 uid, gid.
-    struct fuse_context *context = fuse_get_context();
-    uid_t curr_uid = context->uid;
-    uid_t curr_gid = context->gid;
-
-    // node의 파일 권한, 소유자 uid, 그룹 gid.
-    mode_t file_mode = node->attr.st_mode;
-    uid_t file_uid = node->attr.st_uid;
-    uid_t file_gid = node->attr.st_gid;
-
-    // owner이고, 파일에 owner WRITE 권한이 있는 경우
-    if (((curr_uid == file_uid) && (file_mode & S_IWUSR))
-        // owner는 아니지만 group에 속하고, 파일에 group WRITE 권한이 있는 경우
-        || ((curr_gid == file_gid) && (file_mode & S_IWGRP)) ) {
-        return 1;
+// 호출 프로세스가 superuser인지 반환
+int is_root(credential *cred) {
+    return cred->uid == 0;
+}
+
+// 호출 프로세스가 해당 inode에 읽기 권한이 있는지 확인
+int can_read(credential *cred, inode *node) {
+    // node의 파일 권한, 소유자 uid, 그룹 gid.
+    mode_t file_mode = node->mode;
+    uid_t file_uid = node->uid;
+    uid_t file_gid = node->gid;
+
+    // owner이고, 파일에 owner READ 권한이 있는 경우
+    if (((cred->uid == file_uid) && (file_mode & S_IRUSR))
+        // owner는 아니지만 group에 속하고, 파일에 group READ 권한이 있는 경우
+        || ((cred->gid == file_gid) && (file_mode & S_IRGRP)) ) {
+        return 1;
+    }
+
+    // owner는 아니지만 supplementary group에 속하고,
+    // 파일에 group READ 권한이 있는 경우
+    if ((file_mode & S_IRGRP) && in_groups(cred, file_gid)) {
+        return 1;
+    }
+
+    // 그 외 others이고, 파일에 others READ 권한이 있는 경우
+    if (file_mode & S_IROTH) {
+        return 1;
+    }
+
+    return 0;
+}
+
+// 호출 프로세스가 해당 inode에 쓰기 권한이 있는지 확인
+int can_write(credential *cred, inode *node) {
+    // node의 파일 권한, 소유자 uid, 그룹 gid.
+    mode_t file_mode = node->mode;
+    uid_t file_uid = node->uid;
+    uid_t file_gid = node->gid;
+
+    // owner이고, 파일에 owner WRITE 권한이 있는 경우
+    if (((cred->uid == file_uid) && (file_mode & S_IWUSR))
+        // owner는 아니지만 group에 속하고, 파일에 group WRITE 권한이 있는 경우
+        || ((cred->gid == file_gid) && (file_mode & S_IWGRP)) ) {
+        return 1;
+    }
+
+    // owner는 아니지만 supplementary group에 속하고,
+    // 파일에 group WRITE 권한이 있는 경우
+    if ((file_mode & S_IWGRP) && in_groups(cred, file_gid)) {
+        return 1;
+    }
+
+    // others이고, 파일에 others WRITE 권한이 있는 경우
+    if (file_mode & S_IWOTH) {
+        return 1;
+    }
+
+    return 0;
+}
+
+// 호출 프로세스가 해당 inode에 실행/탐색 권한이 있는지 확인
+int can_execute(credential *cred, inode *node) {
+    // node의 파일 권한, 소유자 uid, 그룹 gid.
+    mode_t file_mode = node->mode;
+    uid_t file_uid = node->uid;
+    uid_t file_gid = node->gid;
+
+    // owner이고, 파일에 owner EXECUTE 권한이 있는 경우
+    if (((cred->uid == file_uid) && (file_mode & S_IXUSR))
+        // owner는 아니지만 group에 속하고, 파일에 group EXECUTE 권한이 있는 경우
+        || ((cred->gid == file_gid) && (file_mode & S_IXGRP)) ) {
+        return 1;
+    }
+
+    // owner는 아니지만 supplementary group에 속하고,
+    // 파일에 group EXECUTE 권한이 있는 경우
+    if ((file_mode & S_IXGRP) && in_groups(cred, file_gid)) {
+        return 1;
+    }
+
+    // others이고, 파일에 others EXECUTE 권한이 있는 경우
+    if (file_mode & S_IXOTH) {
+        return 1;
+    }
+
+    return 0;
+}
+
+// supplementary groups 없이 호출 프로세스가 해당 inode를 탐색할 수 있는지 확인
+// uid, gid가 같은 모든 호출 프로세스에 대해 같은 결과
+static int can_execute_without_groups(credential *cred, inode *node) {
+    mode_t file_mode = node->mode;
+
+    return ((cred->uid == node->uid) && (file_mode & S_IXUSR))
+        || ((cred->gid == node->gid) && (file_mode & S_IXGRP))
+        || (file_mode & S_IXOTH);
+}
+
+// path 앞 length 바이트의 해시 값 계산 (FNV-1a)
+static uint64_t dcache_hash_prefix(const char *path, size_t length) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i=0; i<length; i++) {
+        hash ^= (unsigned char)path[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// path 해시 값 계산 (FNV-1a)
+static uint64_t dcache_hash(const char *path) {
+    return dcache_hash_prefix(path, strlen(path));
+}
+
+// dentry cache에서 path 검색, 있으면 res에 위치 정보 기록 후 주요 오류 번호 반환
+// 없으면 NO_ERROR 반환
+static asdfs_errno dcache_lookup(const char *path, search_result *res, credential *cred) {
+    uint64_t hash = dcache_hash(path);
+    dcache_entry *entry = &dcache[hash & (DCACHE_SIZE - 1)];
+    asdfs_errno code = NO_ERROR;
+
+    pthread_mutex_lock(&dcache_lock);
+    // 같은 세대에 같은 uid, gid로 탐색 권한을 확인한 같은 path인 경우
+    if (entry->generation == dcache_generation
+        && entry->hash == hash
+        && entry->uid == cred->uid
+        && entry->gid == cred->gid
+        && strcmp(entry->path, path) == 0) {
+        if (entry->code == EXACT_FOUND) {
+            // 위치 정보 반환
+            res->parent = entry->parent;
+            res->exact = entry->exact;
+            res->left = get_inode(entry->exact->leftSibling);
+            res->right = get_inode(entry->exact->rightSibling);
+            code = EXACT_FOUND;
+            dcache_counter.hit++;
+        }
+        // negative 항목은 저장 이후 parent에 하위 inode가 추가되지 않은 경우만 유효
+        else if (entry->negative_generation == dcache_negative_generation
+                 && get_cold(entry->parent)->version == entry->version) {
+            res->parent = entry->parent;
+            code = entry->code;
+            dcache_counter.negative++;
+        }
+    }
+    if (code == NO_ERROR) {
+        dcache_counter.miss++;
+    }
+    pthread_mutex_unlock(&dcache_lock);
+
+    return code;
+}
+
+// 탐색 시작 당시 세대 generation으로 path의 검색 결과 res를 dentry cache에 저장
+// code가 EXACT_NOT_FOUND/HEAD_NOT_FOUND면 version은 탐색 당시 res->parent의 version
+static void dcache_insert(const char *path, const search_result *res, asdfs_errno code, uint64_t version, unsigned long generation, credential *cred) {
+    if (strlen(path) >= DCACHE_PATH_MAX) {
+        return;
+    }
+
+    uint64_t hash = dcache_hash(path);
+    dcache_entry *entry = &dcache[hash & (DCACHE_SIZE - 1)];
+
+    pthread_mutex_lock(&dcache_lock);
+    // 탐색 도중 전체 무효화가 일어났다면 저장하지 않음
+    if (generation == dcache_generation) {
+        entry->hash = hash;
+        entry->generation = generation;
+        entry->negative_generation = dcache_negative_generation;
+        entry->uid = cred->uid;
+        entry->gid = cred->gid;
+        entry->code = code;
+        entry->parent = res->parent;
+        entry->exact = res->exact;
+        entry->version = version;
+        strcpy(entry->path, path);
+    }
+    pthread_mutex_unlock(&dcache_lock);
+}
+
+// path에 해당하는 dentry cache 항목 무효화
+void dcache_invalidate(const char *path) {
+    uint64_t hash = dcache_hash(path);
+    dcache_entry *entry = &dcache[hash & (DCACHE_SIZE - 1)];
+
+    pthread_mutex_lock(&dcache_lock);
+    if (entry->hash == hash && strcmp(entry->path, path) == 0) {
+        entry->generation = 0;
+    }
+    for (int i=0; i<DCACHE_HELD_SIZE; i++) {
+        if (dcache_held[i].hash == hash && strcmp(dcache_held[i].path, path) == 0) {
+            dcache_held[i].generation = 0;
+        }
+    }
+    pthread_mutex_unlock(&dcache_lock);
+}
+
+// 고정된 디렉터리 항목 중 세대 generation에 uid, gid로 저장된 path 앞 length 바이트 path 검색
+// 있으면 항목 위치, 없으면 -1 반환 (dcache_lock 필요)
+static int dcache_held_find(const char *path, size_t length, unsigned long generation, credential *cred) {
+    uint64_t hash = dcache_hash_prefix(path, length);
+    for (int i=0; i<DCACHE_HELD_SIZE; i++) {
+        dcache_entry *entry = &dcache_held[i];
+        if (entry->generation == generation
+            && entry->hash == hash
+            && entry->uid == cred->uid
+            && entry->gid == cred->gid
+            && strncmp(entry->path, path, length) == 0
+            && entry->path[length] == '\0') {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// path의 상위 디렉터리가 고정되어 있으면 고정된 항목 위치와 디렉터리 inode를 dir 포인터로 반환 후
+// cursor를 path의 마지막 component 앞으로 이동, 없으면 -1 반환
+static int dcache_held_lookup(const char *path, const char **cursor, unsigned long generation, credential *cred, inode **dir) {
+    // 마지막 component 앞의 '/' 위치, 상위 디렉터리가 root이거나 마지막 component가 없으면 제외
+    const char *slash = strrchr(path, '/');
+    if (slash == NULL || slash == path || slash[1] == '\0') {
+        return -1;
+    }
+
+    pthread_mutex_lock(&dcache_lock);
+    int held = dcache_held_find(path, (size_t)(slash - path), generation, cred);
+    if (held >= 0) {
+        *dir = dcache_held[held].exact;
+        dcache_counter.held++;
+    }
+    pthread_mutex_unlock(&dcache_lock);
+
+    if (held >= 0) {
+        *cursor = slash;
+    }
+    return held;
+}
+
+// 목록을 읽는 디렉터리 dir의 path를 dentry cache에 고정
+// supplementary groups 없이 탐색한 결과로 dentry cache에 있는 경우만 고정
+void dcache_hold(const char *path, inode *dir) {
+    size_t length = strlen(path);
+    if (length >= DCACHE_PATH_MAX || dir == NULL) {
+        return;
+    }
+
+    credential cred;
+    get_credential(&cred);
+
+    uint64_t hash = dcache_hash(path);
+    dcache_entry *entry = &dcache[hash & (DCACHE_SIZE - 1)];
+
+    // dentry cache에서 교체된 경우 한 번 다시 탐색
+    for (int retry = 0; retry < 2; retry++) {
+        int held = 0;
+        pthread_mutex_lock(&dcache_lock);
+        // 이미 고정된 경우
+        int index = dcache_held_find(path, length, dcache_generation, &cred);
+        if (index >= 0 && dcache_held[index].exact == dir) {
+            held = 1;
+        }
+        // dentry cache의 항목을 고정
+        else if (entry->generation == dcache_generation
+                 && entry->hash == hash
+                 && entry->uid == cred.uid
+                 && entry->gid == cred.gid
+                 && entry->code == EXACT_FOUND
+                 && entry->exact == dir
+                 && strcmp(entry->path, path) == 0) {
+            dcache_entry *slot = &dcache_held[dcache_held_next++ % DCACHE_HELD_SIZE];
+            *slot = *entry;
+            slot->next = NULL;
+            held = 1;
+        }
+        pthread_mutex_unlock(&dcache_lock);
+
+        if (held) {
+            return;
+        }
+        search_result res;
+        find_inode(path, &res);
+    }
+}
+
+// dentry cache 전체 무효화
+void dcache_invalidate_all() {
+    pthread_mutex_lock(&dcache_lock);
+    dcache_generation++;
+    pthread_mutex_unlock(&dcache_lock);
+}
+
+// dir에 하위 inode가 추가/삭제됨: dir 아래의 negative 항목, 고정된 항목의 예상 위치 무효화
+static void dcache_touch(inode *dir) {
+    pthread_mutex_lock(&dcache_lock);
+    get_cold(dir)->version = ++volume->dirVersion;
+    dirty_range(get_cold(dir), sizeof(inode_cold));
+    pthread_mutex_unlock(&dcache_lock);
+}
+
+// 디렉터리 삭제: 삭제된 디렉터리를 가리키는 negative 항목 무효화
+static void dcache_invalidate_negative() {
+    pthread_mutex_lock(&dcache_lock);
+    dcache_negative_generation++;
+    pthread_mutex_unlock(&dcache_lock);
+}
+
+// supplementary groups cache 통계 반환
+cred_stats get_cred_stats() {
+    pthread_mutex_lock(&cred_lock);
+    cred_stats stats = cred_counter;
+    pthread_mutex_unlock(&cred_lock);
+    return stats;
+}
+
+// dentry cache 통계 반환
+dcache_stats get_dcache_stats() {
+    pthread_mutex_lock(&dcache_lock);
+    dcache_stats stats = dcache_counter;
+    pthread_mutex_unlock(&dcache_lock);
+    return stats;
+}
+
+// 색인 하위 트리 높이 반환
+static int index_height(inode *tree) {
+    return tree ? tree->indexHeight : 0;
+}
+
+// tree의 색인 하위 트리 높이 갱신
+static void index_update(inode *tree) {
+    int left = index_height(get_inode(tree->indexLeft));
+    int right = index_height(get_inode(tree->indexRight));
+    tree->indexHeight = (left > right ? left : right) + 1;
+    dirty_range(tree, sizeof(inode));
+}
+
+// tree를 오른쪽으로 회전, 새로운 하위 트리 root 반환
+static inode *index_rotate_right(inode *tree) {
+    inode *left = get_inode(tree->indexLeft);
+    tree->indexLeft = left->indexRight;
+    left->indexRight = tree->id;
+
+    index_update(tree);
+    index_update(left);
+    return left;
+}
+
+// tree를 왼쪽으로 회전, 새로운 하위 트리 root 반환
+static inode *index_rotate_left(inode *tree) {
+    inode *right = get_inode(tree->indexRight);
+    tree->indexRight = right->indexLeft;
+    right->indexLeft = tree->id;
+
+    index_update(tree);
+    index_update(right);
+    return right;
+}
+
+// tree 하위 트리의 좌우 높이 차이가 1 이하가 되도록 회전,
+// 새로운 하위 트리 root 반환
+static inode *index_balance(inode *tree) {
+    index_update(tree);
+    inode *left = get_inode(tree->indexLeft);
+    inode *right = get_inode(tree->indexRight);
+    int balance = index_height(left) - index_height(right);
+
+    // 왼쪽이 더 높은 경우
+    if (balance > 1) {
+        if (index_height(get_inode(left->indexLeft)) < index_height(get_inode(left->indexRight))) {
+            tree->indexLeft = index_rotate_left(left)->id;
+        }
+        return index_rotate_right(tree);
+    }
+
+    // 오른쪽이 더 높은 경우
+    if (balance < -1) {
+        if (index_height(get_inode(right->indexRight)) < index_height(get_inode(right->indexLeft))) {
+            tree->indexRight = index_rotate_right(right)->id;
+        }
+        return index_rotate_left(tree);
+    }
+
+    return tree;
+}
+
+// 길이 length인 name과 node의 이름 순서 비교
+// (name이 앞이면 음수, 같으면 0, 뒤면 양수 반환)
+// 이름 순서는 바이트 값 순서이며, 앞부분이 같으면 짧은 이름이 앞
+static int name_compare(const char *name, size_t length, inode *node) {
+    size_t common = length < node->nameLength ? length : node->nameLength;
+    int cmp = memcmp(name, get_name(node), common);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return length == node->nameLength ? 0 : (length < node->nameLength ? -1 : 1);
+}
+
+// 해시 값 hash, 길이 length인 name이 node의 이름과 같은지 여부
+// 해시 값이나 길이가 다르면 이름 문자열은 읽지 않음
+static int name_equal(uint32_t hash, const char *name, size_t length, inode *node) {
+    return hash == node->nameHash && length == node->nameLength && memcmp(name, get_name(node), length) == 0;
+}
+
+// tree 하위 트리에 new 삽입, 새로운 하위 트리 root 반환
+// 삽입 위치의 이름 순서 직전/직후 inode를 left/right 포인터로 반환
+static inode *index_insert(inode *tree, inode *new, inode **left, inode **right) {
+    if (tree == NULL) {
+        new->indexLeft = 0;
+        new->indexRight = 0;
+        new->indexHeight = 1;
+        return new;
+    }
+
+    if (name_compare(get_name(new), new->nameLength, tree) < 0) {
+        *right = tree;
+        tree->indexLeft = index_insert(get_inode(tree->indexLeft), new, left, right)->id;
+    }
+    else {
+        *left = tree;
+        tree->indexRight = index_insert(get_inode(tree->indexRight), new, left, right)->id;
+    }
+    return index_balance(tree);
+}
+
+// tree 하위 트리에서 가장 앞의 inode 분리, 새로운 하위 트리 root 반환
+static inode *index_remove_first(inode *tree) {
+    if (tree->indexLeft == 0) {
+        return get_inode(tree->indexRight);
+    }
+    tree->indexLeft = node_id(index_remove_first(get_inode(tree->indexLeft)));
+    return index_balance(tree);
+}
+
+// tree 하위 트리에서 node 분리, 새로운 하위 트리 root 반환
+static inode *index_remove(inode *tree, inode *node) {
+    if (tree == NULL) {
+        return NULL;
+    }
+
+    int cmp = name_compare(get_name(node), node->nameLength, tree);
+    if (cmp < 0) {
+        tree->indexLeft = node_id(index_remove(get_inode(tree->indexLeft), node));
+    }
+    else if (cmp > 0) {
+        tree->indexRight = node_id(index_remove(get_inode(tree->indexRight), node));
+    }
+    // tree가 node인 경우
+    else {
+        inode *left = get_inode(tree->indexLeft);
+        inode *right = get_inode(tree->indexRight);
+        if (right == NULL) {
+            return left;
+        }
+
+        // 오른쪽 하위 트리의 가장 앞 inode로 node 자리를 대체
+        inode *first = right;
+        while (first->indexLeft) {
+            first = get_inode(first->indexLeft);
+        }
+        first->indexRight = node_id(index_remove_first(right));
+        first->indexLeft = node_id(left);
+        tree = first;
+    }
+    return index_balance(tree);
+}
+
+// parent의 이름 색인을 검색하여
+// 길이 length인 search_name의 위치 정보 또는 search_name이 들어갈 위치 정보를
+// search_result에 기록하여 res 포인터로 반환
+asdfs_errno child_search(inode *parent, const char *search_name, size_t length, search_result *res){
+    if (parent == NULL || search_name == NULL || res == NULL) {
+        return GENERAL_ERROR;
+    }
+    
+    // 위치 정보 초기화
+    res->parent = parent;
+    res->left = NULL;
+    res->exact = NULL;
+    res->right = NULL;
+
+    // 색인 root부터 이름을 비교하며 내려감
+    inode *child = get_inode(parent->indexRoot);
+    while (child) {
+        // 이름을 비교하는 동안 다음에 내려갈 두 하위 트리 root를 미리 읽어둠
+        __builtin_prefetch(get_inode(child->indexLeft));
+        __builtin_prefetch(get_inode(child->indexRight));
+
+        int cmp = name_compare(search_name, length, child);
+
+        // child가 search_name과 같은 경우
+        if (cmp == 0) {
+            // 위치 정보 반환
+            res->left = get_inode(child->leftSibling);
+            res->exact = child;
+            res->right = get_inode(child->rightSibling);
+
+            // 주어진 위치에 inode 있음
+            return EXACT_FOUND;
+        }
+
+        // child보다 이름 순서가 앞이면 왼쪽, 뒤면 오른쪽으로 진행하며
+        // 지나온 inode 중 가장 가까운 것을 left/right로 기록
+        if (cmp < 0) {
+            res->right = child;
+            child = get_inode(child->indexLeft);
+        }
+        else {
+            res->left = child;
+            child = get_inode(child->indexRight);
+        }
+    }
+
+    // 주어진 위치에 inode 없음
+    return EXACT_NOT_FOUND;
+}
+
+// 고정된 디렉터리 항목 held의 디렉터리 parent 아래에서 길이 length인 name 검색
+// 목록 순서대로 검색하면 이전에 찾은 inode의 rightSibling이 바로 name이므로 색인 탐색 생략
+static asdfs_errno dcache_held_search(int held, inode *parent, const char *name, size_t length, search_result *res) {
+    dcache_entry *entry = &dcache_held[held];
+
+    // 예상 위치는 기록 이후 parent에 하위 inode가 추가/삭제되지 않은 경우만 유효
+    pthread_mutex_lock(&dcache_lock);
+    inode *next = NULL;
+    if (entry->exact == parent && entry->version == get_cold(parent)->version) {
+        next = entry->next;
+    }
+    pthread_mutex_unlock(&dcache_lock);
+
+    asdfs_errno return_code;
+    if (next && name_equal(name_hash(name, length), name, length, next)) {
+        res->parent = parent;
+        res->left = get_inode(next->leftSibling);
+        res->exact = next;
+        res->right = get_inode(next->rightSibling);
+        return_code = EXACT_FOUND;
+    }
+    else {
+        return_code = child_search(parent, name, length, res);
+    }
+
+    // 다음 예상 위치 기록
+    pthread_mutex_lock(&dcache_lock);
+    if (entry->exact == parent) {
+        entry->next = return_code == EXACT_FOUND ? res->right : NULL;
+        entry->version = get_cold(parent)->version;
+    }
+    pthread_mutex_unlock(&dcache_lock);
+
+    return return_code;
+}
+
+// readdir offset은 자식마다 붙인 순서 번호 (cold->order)에 DIR_COOKIE_BASE를 더한 값
+// 순서 번호는 형제 순서대로 증가하고 다른 자식이 추가/삭제되어도 바뀌지 않으므로
+// 마지막으로 받은 항목이 삭제되어도 그 다음 자식부터 이어서 읽을 수 있음
+#define DIR_ORDER_MAX   ((uint64_t)1 << 62) // 순서 번호 상한 (off_t 범위 안)
+#define DIR_ORDER_STEP  ((uint64_t)1 << 32) // 처음이나 끝에 추가할 때 이웃과의 간격
+#define DIR_ORDER_DENSE ((uint64_t)1 << 20) // 번호를 다시 붙일 때 최소 간격
+
+// child 다음 자식부터 이어서 읽을 수 있는 readdir offset 반환
+off_t child_cookie(inode *child) {
+    return (off_t)get_cold(child)->order + DIR_COOKIE_BASE;
+}
+
+// parent의 자식 중 readdir offset cookie 항목 다음 자식 반환, 없으면 NULL
+inode *seek_child(inode *parent, off_t cookie) {
+    if (cookie < DIR_COOKIE_BASE) {
+        return get_inode(parent->firstChild);
+    }
+    uint64_t order = (uint64_t)(cookie - DIR_COOKIE_BASE);
+
+    // 색인에서 순서 번호가 order보다 큰 첫 자식 검색 (순서 번호는 이름 순서와 같은 순서)
+    inode *next = NULL;
+    inode *child = get_inode(parent->indexRoot);
+    while (child) {
+        if (get_cold(child)->order > order) {
+            next = child;
+            child = get_inode(child->indexLeft);
+        }
+        else {
+            child = get_inode(child->indexRight);
+        }
+    }
+    return next;
+}
+
+// 형제 목록에 연결된 node의 순서 번호 앞뒤 한계 (이웃이 없으면 0, DIR_ORDER_MAX)
+static uint64_t order_before(inode *node) {
+    inode *left = get_inode(node->leftSibling);
+    return left ? get_cold(left)->order : 0;
+}
+
+static uint64_t order_after(inode *node) {
+    inode *right = get_inode(node->rightSibling);
+    return right ? get_cold(right)->order : DIR_ORDER_MAX;
+}
+
+// 형제 목록에 연결된 new 양쪽 번호 사이에 빈 번호가 없으면
+// 간격이 DIR_ORDER_DENSE 이상이 될 때까지 new 주변 형제를 넓혀가며 고르게 번호를 다시 붙임
+// (다시 붙인 형제 사이의 cookie로 이어서 읽으면 그 범위의 항목을 건너뛰거나 다시 받을 수 있음)
+static void order_relabel(inode *new) {
+    inode *first = new;
+    inode *last = new;
+    uint64_t count = 1;
+    for (int side = 0; ; side ^= 1) {
+        uint64_t low = order_before(first);
+        uint64_t high = order_after(last);
+        if ((high - low) / (count + 1) >= DIR_ORDER_DENSE) {
+            uint64_t step = (high - low) / (count + 1);
+            uint64_t order = low;
+            for (inode *node = first; ; node = get_inode(node->rightSibling)) {
+                order += step;
+                get_cold(node)->order = order;
+                dirty_range(&get_cold(node)->order, sizeof(uint64_t));
+                if (node == last) {
+                    return;
+                }
+            }
+        }
+        if ((side == 0 || last->rightSibling == 0) && first->leftSibling) {
+            first = get_inode(first->leftSibling);
+        }
+        else {
+            last = get_inode(last->rightSibling);
+        }
+        count++;
+    }
+}
+
+// 형제 목록에 연결된 new에 이웃 사이의 순서 번호 부여
+// 처음이나 끝에 추가하면 이웃에서 DIR_ORDER_STEP만큼, 사이에 추가하면 가운데 번호
+static void order_assign(inode *new) {
+    uint64_t low = order_before(new);
+    uint64_t high = order_after(new);
+    uint64_t order;
+    if (high - low < 2) {
+        order_relabel(new);
+        return;
+    }
+    if (new->leftSibling == 0 && new->rightSibling == 0) {
+        order = DIR_ORDER_MAX / 2;
+    }
+    else if (new->rightSibling == 0 && high - low > 2 * DIR_ORDER_STEP) {
+        order = low + DIR_ORDER_STEP;
+    }
+    else if (new->leftSibling == 0 && high - low > 2 * DIR_ORDER_STEP) {
+        order = high - DIR_ORDER_STEP;
+    }
+    else {
+        order = low + (high - low) / 2;
+    }
+    get_cold(new)->order = order;
+    dirty_range(&get_cold(new)->order, sizeof(uint64_t));
+}
+
+// 파일 시스템 root inode, superblock 초기화
+// root는 uid, gid 소유이며 umask를 적용한 권한을 가짐
+// 이미 초기화된 볼륨 (이미지 파일)은 그대로 사용
+void init_root_superblock(uid_t uid, gid_t gid, mode_t umask) {
+    // 현재 시간 가져오기
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    // CPU 기능에 맞는 데이터 복사 방식 선택
+    copy_init();
+
+    if (volume->formatted) {
+        return;
+    }
+
+    // root inode 할당 (번호 ROOT_INODE_ID)
+    inode *root = get_root();
+    if (root == NULL) {
+        root = alloc_inode();
+        path_comp name = { "ROOT", 4 };
+        rename_inode(root, name);
+    }
+
+    // root inode 초기화
+    inode_cold *cold = get_cold(root);
+    root->mode  = S_IFDIR | (0777 & ~umask); // 파일 모드
+    root->uid   = uid;                       //
+    root->gid   = gid;                       //
+    cold->nlink = 1;                         // 파일 링크 개수
+    cold->atime = now.tv_sec;                // 파일 최근 사용 시간
+    cold->mtime = now.tv_sec;                // 파일 최근 수정 시간
+    cold->ctime = now.tv_sec;                // 파일 최근 상태 변화 시간
+    // 나머지 값은 alloc_inode에서 전부 0.
+    dirty_inode(root);
+    
+    // superblock 초기화
+    
+    // f_bsize: 파일 시스템 블록 크기
+    unsigned long f_bsize = BLOCK_SIZE_KB * 1024; // 4096
+    
+    // f_blocks: 파일 시스템 내 전체 블록 개수
+    fsblkcnt_t f_blocks = VOLUME_SIZE_MB * 1024 / BLOCK_SIZE_KB; // 25600
+    
+    // f_favail: 사용 가능한 파일 시리얼 넘버 (inode) 개수
+    fsfilcnt_t f_favail = (fsfilcnt_t)(f_blocks * (f_bsize / INODE_SIZE_BYTE)); // 204800
+
+    volume->superblock.f_bsize   = f_bsize;      // 파일 시스템 블록 크기
+    volume->superblock.f_blocks  = f_blocks;     // 파일 시스템 내 전체 블록 개수
+    volume->superblock.f_bfree   = f_blocks - 1; // 사용 가능한 블록 수, root만큼 제외
+    volume->superblock.f_bavail  = f_blocks - 1; // 일반 권한 프로세스가 사용 가능한 블록 수, root만큼 제외
+    volume->superblock.f_files   = 0;            // 전체 파일 시리얼 넘버 (inode) 개수, alloc_inode/free_inode에서 계산
+    volume->superblock.f_favail  = f_favail - 1; // 사용 가능한 파일 시리얼 넘버 (inode) 개수, root만큼 제외
+    volume->inodeCapacity = f_favail - 1;
+    volume->superblock.f_namemax = MAX_FILENAME; // 최대 파일 이름 길이
+    // 나머지 값은 static이므로 전부 0.
+
+    volume->formatted = 1;
+}
+
+#define VOLUME_ALIGN NAME_PAGE_SIZE // 이미지 파일 영역 정렬 단위 (B)
+
+// size를 VOLUME_ALIGN 단위로 올림
+static uint64_t volume_align(uint64_t size) {
+    return (size + VOLUME_ALIGN - 1) / VOLUME_ALIGN * VOLUME_ALIGN;
+}
+
+// 현재 빌드 설정의 이미지 파일 배치를 layout에 기록
+static void volume_layout(volume_header *layout) {
+    memset(layout, 0, sizeof(*layout));
+    memcpy(layout->magic, VOLUME_MAGIC, sizeof(layout->magic));
+    layout->layout = VOLUME_LAYOUT;
+
+    // init_root_superblock과 같은 전체 블록 개수와 inode 개수
+    uint64_t blocks = VOLUME_SIZE_MB * 1024 / BLOCK_SIZE_KB;
+    uint64_t inodes = blocks * (BLOCK_SIZE_KB * 1024 / INODE_SIZE_BYTE);
+
+    layout->blockSize = DATA_BLOCK_SIZE;
+    layout->inodeSize = sizeof(inode);
+    layout->coldSize = sizeof(inode_cold);
+    layout->blocks = blocks;
+    // 스레드별 magazine에 있는 번호를 위해 slab 하나 더
+    layout->slabMax = (uint32_t)((inodes + INODE_CHUNK_SIZE - 1) / INODE_CHUNK_SIZE + 1);
+    // 모든 inode가 가장 큰 slot을 쓰는 경우의 두 배
+    layout->namePageMax = (uint32_t)(inodes * (NAME_SLOT_MIN << (NAME_CLASSES - 1)) / NAME_PAGE_SIZE * 2 + 1);
+
+    // 영역 배치: header, slab 정보, inode chunk, inode_cold chunk, 이름 page,
+    // 반환된 블록 번호, 블록 공유 횟수, 블록 압축 상태, 블록 소유 파일, 데이터 블록 (블록 번호 개수만큼)
+    uint64_t refs = blocks * DATA_REF_FACTOR;
+    uint64_t offset = volume_align(sizeof(volume_header));
+    layout->slabOffset = offset;
+    offset += volume_align(sizeof(inode_slab) * layout->slabMax);
+    layout->hotOffset = offset;
+    offset += volume_align((uint64_t)sizeof(inode) * INODE_CHUNK_SIZE * layout->slabMax);
+    layout->coldOffset = offset;
+    offset += volume_align((uint64_t)sizeof(inode_cold) * INODE_CHUNK_SIZE * layout->slabMax);
+    layout->nameOffset = offset;
+    offset += (uint64_t)NAME_PAGE_SIZE * layout->namePageMax;
+    layout->freeOffset = offset;
+    offset += volume_align(sizeof(uint32_t) * refs);
+    layout->refsOffset = offset;
+    offset += volume_align(sizeof(uint32_t) * (refs + 1));
+    layout->zipOffset = offset;
+    offset += volume_align(sizeof(uint64_t) * (refs + 1));
+    layout->ownerOffset = offset;
+    offset += volume_align(sizeof(inode_id) * (refs + 1));
+    layout->dataOffset = offset;
+    offset += (refs + 1) * DATA_BLOCK_SIZE; // 0번은 없음을 의미하므로 블록 하나 더
+    layout->size = volume_align(offset);
+}
+
+// 이미지 파일 header가 현재 빌드 설정의 배치 layout과 같은지 여부
+static int volume_match(const volume_header *header, const volume_header *layout) {
+    return memcmp(header->magic, layout->magic, sizeof(layout->magic)) == 0
+        && header->layout == layout->layout
+        && header->blockSize == layout->blockSize
+        && header->inodeSize == layout->inodeSize
+        && header->coldSize == layout->coldSize
+        && header->blocks == layout->blocks
+        && header->slabMax == layout->slabMax
+        && header->namePageMax == layout->namePageMax
+        && header->dataOffset == layout->dataOffset
+        && header->size == layout->size;
+}
+
+// fd의 pos 위치에 buf의 size 바이트 기록, 실패하면 -1 반환
+static int checkpoint_write(int fd, const void *buf, size_t size, off_t pos) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t written = pwrite(fd, (const char *)buf + done, size - done, pos + (off_t)done);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return -1;
+        }
+        done += (size_t)written;
+    }
+    return 0;
+}
+
+// fd의 pos 위치에서 buf로 size 바이트 읽기, 실패하면 -1 반환
+static int checkpoint_read(int fd, void *buf, size_t size, off_t pos) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t count = pread(fd, (char *)buf + done, size - done, pos + (off_t)done);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return -1;
+        }
+        done += (size_t)count;
+    }
+    return 0;
+}
+
+// 이중 기록 파일 안에서 page 내용이 시작하는 위치 (page 번호 배열 다음)
+static off_t checkpoint_data_pos(uint64_t pages) {
+    return (off_t)(CHECKPOINT_PAGE + (pages * sizeof(uint64_t) + CHECKPOINT_PAGE - 1) / CHECKPOINT_PAGE * CHECKPOINT_PAGE);
+}
+
+// list의 page 번호 순서대로 data의 page를 fd의 제자리에 기록, 실패하면 -1 반환
+// 번호가 이어지는 page는 한 번에 기록
+static int checkpoint_put(int fd, const uint64_t *list, uint64_t count, const char *data) {
+    uint64_t i = 0;
+    while (i < count) {
+        uint64_t run = 1;
+        while (i + run < count && list[i + run] == list[i] + run) {
+            run++;
+        }
+        size_t size = (size_t)run * CHECKPOINT_PAGE;
+        if (checkpoint_write(fd, data + i * CHECKPOINT_PAGE, size, (off_t)(list[i] * CHECKPOINT_PAGE)) != 0) {
+            return -1;
+        }
+        i += run;
+    }
+    return 0;
+}
+
+// 이중 기록 파일 side의 page를 이미지 파일 fd의 제자리에 기록, 실패하면 -1 반환
+static int checkpoint_apply(int side, int fd, const checkpoint_header *header) {
+    uint64_t *list = (uint64_t *)malloc((size_t)header->pages * sizeof(uint64_t) + 1);
+    char *data = (char *)malloc((size_t)header->pages * CHECKPOINT_PAGE + 1);
+    int result = -1;
+    if (list != NULL && data != NULL
+        && checkpoint_read(side, list, (size_t)header->pages * sizeof(uint64_t), CHECKPOINT_PAGE) == 0
+        && checkpoint_read(side, data, (size_t)header->pages * CHECKPOINT_PAGE, checkpoint_data_pos(header->pages)) == 0) {
+        result = 0;
+        for (uint64_t i = 0; i < header->pages; i++) {
+            if ((list[i] + 1) * CHECKPOINT_PAGE > header->size) {
+                result = -1;
+            }
+        }
+        if (result == 0) {
+            result = checkpoint_put(fd, list, header->pages, data);
+        }
+    }
+    free(list);
+    free(data);
+    return result;
+}
+
+// path의 이중 기록 파일에 완전히 기록된 checkpoint가 남아 있으면 이미지 파일 fd에 다시 기록
+// (이미지 파일에 덮어쓰는 도중 중단된 경우), 실패하면 -1 반환
+static int checkpoint_redo(int fd, const char *path) {
+    int side = open(path, O_RDWR);
+    if (side < 0) {
+        return errno == ENOENT ? 0 : -1;
+    }
+
+    // 이중 기록을 끝내지 못한 checkpoint는 이미지 파일에 쓰지 않았으므로 버림
+    checkpoint_header header;
+    int result = 0;
+    if (checkpoint_read(side, &header, sizeof(header), 0) == 0
+        && memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) == 0 && header.complete) {
+        fprintf(stderr, "asdfs_open_volume: redoing checkpoint of %lu pages\n", (unsigned long)header.pages);
+        result = checkpoint_apply(side, fd, &header);
+        if (result == 0) {
+            result = fsync(fd);
+        }
+    }
+    if (result == 0 && (ftruncate(side, 0) != 0 || fsync(side) != 0)) {
+        result = -1;
+    }
+    close(side);
+    return result;
+}
+
+// from 이후 경과 시간 (ms)
+static double checkpoint_elapsed(const struct timespec *from) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - from->tv_sec) * 1000.0 + (double)(now.tv_nsec - from->tv_nsec) / 1e6;
+}
+
+// 볼륨 변경 요청이 cut을 기다려야 하는지 여부 (checkpoint 또는 블록 압축 사용)
+static int volume_gated() {
+    return checkpoint_interval != 0 || zip_interval != 0;
+}
+
+// checkpoint (또는 압축 스레드)가 cut을 끝낼 때까지 대기한 뒤 볼륨 변경 시작, 항상 1 반환
+// 같은 스레드에서 중첩해서 호출 가능
+int checkpoint_hold() {
+    if (!volume_gated() || checkpoint_depth++ > 0) {
+        return 1;
+    }
+    pthread_mutex_lock(&checkpoint_lock);
+    while (checkpoint_cutting) {
+        pthread_cond_wait(&checkpoint_cond, &checkpoint_lock);
+    }
+    checkpoint_ops++;
+    pthread_mutex_unlock(&checkpoint_lock);
+    return 1;
+}
+
+// checkpoint_hold로 시작한 볼륨 변경 끝
+void checkpoint_release(int *held) {
+    (void)held;
+    if (!volume_gated() || --checkpoint_depth > 0) {
+        return;
+    }
+    pthread_mutex_lock(&checkpoint_lock);
+    if (--checkpoint_ops == 0 && checkpoint_cutting) {
+        pthread_cond_broadcast(&checkpoint_cond);
+    }
+    pthread_mutex_unlock(&checkpoint_lock);
+}
+
+// 이름 공간 사용 시작: write이면 쓰기, 아니면 읽기로 잠금, 항상 1 반환
+// 같은 스레드에서 이미 잡았으면 중첩 횟수만 증가 (읽기로 잡은 채 쓰기로 다시 잡지 않아야 함)
+int namespace_hold(int write) {
+    if (namespace_depth++ > 0) {
+        return 1;
+    }
+    if (write) {
+        pthread_rwlock_wrlock(&namespace_lock);
+    }
+    else {
+        pthread_rwlock_rdlock(&namespace_lock);
+    }
+    return 1;
+}
+
+// namespace_hold로 시작한 이름 공간 사용 끝
+void namespace_release(int *held) {
+    if (*held == 0) {
+        return;
+    }
+    *held = 0;
+    if (--namespace_depth > 0) {
+        return;
+    }
+    pthread_rwlock_unlock(&namespace_lock);
+}
+
+// 진행 중인 변경 요청이 끝날 때까지 대기하고 새로운 변경 요청을 막음 (cut, checkpoint_run_lock 필요)
+static void volume_cut() {
+    pthread_mutex_lock(&checkpoint_lock);
+    checkpoint_cutting = 1;
+    while (checkpoint_ops > 0) {
+        pthread_cond_wait(&checkpoint_cond, &checkpoint_lock);
+    }
+    pthread_mutex_unlock(&checkpoint_lock);
+}
+
+// cut 끝: 변경 요청 재개
+static void volume_resume() {
+    pthread_mutex_lock(&checkpoint_lock);
+    checkpoint_cutting = 0;
+    pthread_cond_broadcast(&checkpoint_cond);
+    pthread_mutex_unlock(&checkpoint_lock);
+}
+
+// 마지막 checkpoint 이후 바뀐 page만 이미지 파일에 기록
+// 1. 변경 요청이 모두 끝나기를 기다리고 새로운 변경 요청을 막음 (cut)
+// 2. 바뀐 page를 메모리에 복사한 뒤 변경 요청 재개 (cut 시점의 내용 보존)
+// 3. 이중 기록 파일을 디스크에 기록한 뒤 이미지 파일의 제자리에 기록
+// 중간에 중단되어도 이미지 파일은 이전 또는 이번 checkpoint 시점의 볼륨
+asdfs_errno checkpoint_volume() {
+    if (dirty_pages == NULL) {
+        return NO_ERROR;
+    }
+    pthread_mutex_lock(&checkpoint_run_lock);
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // cut: 진행 중인 변경 요청이 끝날 때까지 대기
+    volume_cut();
+
+    // 바뀐 page 목록 교체, 이후 변경은 다음 checkpoint에 기록
+    uint64_t *pages = dirty_pages;
+    dirty_pages = flush_pages;
+    flush_pages = pages;
+    uint64_t count = 0;
+    for (size_t i=0; i<dirty_words; i++) {
+        count += (uint64_t)__builtin_popcountll(pages[i]);
+    }
+
+    // 볼륨 정보 (할당 상태, superblock)는 거의 모든 변경에서 바뀌므로 항상 기록
+    if (count > 0) {
+        for (uint64_t page = 0; page <= (sizeof(volume_header) - 1) >> CHECKPOINT_PAGE_SHIFT; page++) {
+            if (!(pages[page / 64] & ((uint64_t)1 << (page % 64)))) {
+                pages[page / 64] |= (uint64_t)1 << (page % 64);
+                count++;
+            }
+        }
+    }
+
+    int side = -1;
+    uint64_t *list = NULL;
+    uint64_t applied = volume->appliedLsn;
+    checkpoint_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.pages = count;
+    header.size = volume->size;
+    int result = 0;
+
+    // 바뀐 page가 있으면 page 번호와 cut 시점의 page 내용을 메모리에 복사
+    // (cut 동안에는 파일에 쓰지 않으므로 멈추는 시간은 복사 시간뿐)
+    char *data = NULL;
+    if (count > 0) {
+        list = (uint64_t *)malloc((size_t)count * sizeof(uint64_t));
+        data = (char *)malloc((size_t)count * CHECKPOINT_PAGE);
+        result = (list != NULL && data != NULL) ? 0 : -1;
+        if (result == 0) {
+            uint64_t n = 0;
+            for (size_t i=0; i<dirty_words; i++) {
+                for (uint64_t word = pages[i]; word; word &= word - 1) {
+                    list[n] = (uint64_t)i * 64 + (uint64_t)__builtin_ctzll(word);
+                    memcpy(data + n * CHECKPOINT_PAGE, volume_image + list[n] * CHECKPOINT_PAGE, CHECKPOINT_PAGE);
+                    n++;
+                }
+            }
+        }
+    }
+
+    // cut 끝: 변경 요청 재개
+    volume_resume();
+    double stall = checkpoint_elapsed(&start);
+
+    // 이중 기록 파일을 디스크에 기록한 뒤 완료 표시, 이후 이미지 파일의 제자리에 기록
+    if (count > 0 && result == 0) {
+        side = open(checkpoint_path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (side < 0
+            || checkpoint_write(side, &header, sizeof(header), 0) != 0
+            || checkpoint_write(side, list, (size_t)count * sizeof(uint64_t), CHECKPOINT_PAGE) != 0
+            || checkpoint_write(side, data, (size_t)count * CHECKPOINT_PAGE, checkpoint_data_pos(count)) != 0
+            || fsync(side) != 0) {
+            result = -1;
+        }
+        header.complete = 1;
+        if (result == 0 && (checkpoint_write(side, &header, sizeof(header), 0) != 0 || fsync(side) != 0
+            || checkpoint_put(volume_fd, list, count, data) != 0 || fsync(volume_fd) != 0)) {
+            result = -1;
+        }
+        // 이미지 파일에 모두 기록되었으므로 이중 기록 내용은 필요 없음
+        if (result == 0 && ftruncate(side, 0) != 0) {
+            result = -1;
+        }
+    }
+    if (side >= 0) {
+        close(side);
+    }
+    free(list);
+    free(data);
+
+    if (result != 0) {
+        // 기록하지 못한 page는 다음 checkpoint에 다시 기록
+        fprintf(stderr, "asdfs_checkpoint: %s\n", strerror(errno));
+        for (size_t i=0; i<dirty_words; i++) {
+            if (pages[i]) {
+                __sync_fetch_and_or(&dirty_pages[i], pages[i]);
+            }
+        }
+    }
+    memset(pages, 0, dirty_words * sizeof(uint64_t));
+
+    if (result == 0 && count > 0) {
+        // 통계 기록 및 출력
+        double total = checkpoint_elapsed(&start);
+        checkpoint_counter.cycles++;
+        checkpoint_counter.lastBytes = count * CHECKPOINT_PAGE;
+        checkpoint_counter.bytes += checkpoint_counter.lastBytes;
+        checkpoint_counter.lastMs = total;
+        checkpoint_counter.lastStallMs = stall;
+        if (stall > checkpoint_counter.maxStallMs) {
+            checkpoint_counter.maxStallMs = stall;
+        }
+        fprintf(stderr, "asdfs_checkpoint pages %lu bytes %lu stall %.3f ms total %.3f ms\n",
+                (unsigned long)count, (unsigned long)checkpoint_counter.lastBytes, stall, total);
+
+        // cut 시점까지의 변경은 이미지 파일에 기록됨
+        if (checkpoint_done) {
+            checkpoint_done(applied);
+        }
+    }
+    pthread_mutex_unlock(&checkpoint_run_lock);
+    return result == 0 ? NO_ERROR : GENERAL_ERROR;
+}
+
+// checkpoint_interval마다 checkpoint, checkpoint_stop이면 종료
+static void *checkpoint_main(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&checkpoint_lock);
+    while (!checkpoint_stop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += checkpoint_interval;
+        while (!checkpoint_stop && pthread_cond_timedwait(&checkpoint_wake, &checkpoint_lock, &deadline) != ETIMEDOUT);
+        if (checkpoint_stop) {
+            break;
+        }
+        pthread_mutex_unlock(&checkpoint_lock);
+        checkpoint_volume();
+        pthread_mutex_lock(&checkpoint_lock);
+    }
+    pthread_mutex_unlock(&checkpoint_lock);
+    return NULL;
+}
+
+// 주기적으로 checkpoint하는 스레드 시작, 실패하면 -1 반환
+// 각 checkpoint가 디스크에 기록되면 cut 시점의 journal 기록 번호로 done 호출
+int start_checkpoint(void (*done)(uint64_t lsn)) {
+    checkpoint_done = done;
+    if (checkpoint_interval == 0 || checkpoint_started) {
+        return 0;
+    }
+    if (pthread_create(&checkpoint_thread, NULL, checkpoint_main, NULL) != 0) {
+        fprintf(stderr, "asdfs_start_checkpoint: cannot start checkpoint thread\n");
+        return -1;
+    }
+    checkpoint_started = 1;
+    return 0;
+}
+
+// checkpoint 통계 반환
+checkpoint_stats get_checkpoint_stats() {
+    pthread_mutex_lock(&checkpoint_run_lock);
+    checkpoint_stats stats = checkpoint_counter;
+    pthread_mutex_unlock(&checkpoint_run_lock);
+    return stats;
+}
+
+// path의 이미지 파일을 볼륨으로 사용, 파일이 없거나 비어 있으면 새로 생성
+// 이미지를 mapping하고 위치만 계산하므로 볼륨 크기에 관계없이 바로 요청 처리 가능
+// checkpoint가 0이 아니면 private mapping 후 checkpoint초마다 바뀐 page만 이미지 파일에 기록
+// init_root_superblock 전에 호출, 실패하면 GENERAL_ERROR 반환
+asdfs_errno open_volume(const char *path, unsigned checkpoint) {
+    // 이미 메모리에 볼륨을 만든 경우
+    if (volume_image != NULL || volume->formatted || volume->slabCount > 0 || data_arena != NULL) {
+        return GENERAL_ERROR;
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        fprintf(stderr, "asdfs_open_volume %s: %s\n", path, strerror(errno));
+        return GENERAL_ERROR;
+    }
+
+    volume_header layout;
+    volume_layout(&layout);
+
+    // 이미지 파일에 덮어쓰는 도중 중단된 checkpoint 마저 기록
+    size_t length = strlen(path);
+    checkpoint_path = (char *)malloc(length + sizeof(".ckpt"));
+    if (checkpoint_path == NULL) {
+        close(fd);
+        return GENERAL_ERROR;
+    }
+    memcpy(checkpoint_path, path, length);
+    memcpy(checkpoint_path + length, ".ckpt", sizeof(".ckpt"));
+    if (checkpoint_redo(fd, checkpoint_path) != 0) {
+        fprintf(stderr, "asdfs_open_volume %s: cannot redo checkpoint\n", checkpoint_path);
+        close(fd);
+        return GENERAL_ERROR;
+    }
+
+    // 빈 파일이면 새로운 이미지 (sparse file), 아니면 header 검사
+    struct stat st;
+    int create = fstat(fd, &st) == 0 && st.st_size == 0;
+    if (create) {
+        // header는 바로 기록 (private mapping은 첫 checkpoint 전까지 파일에 쓰지 않음)
+        volume_header header = layout;
+        header.dataNext = 1;
+        if (ftruncate(fd, (off_t)layout.size) != 0 || checkpoint_write(fd, &header, sizeof(header), 0) != 0
+            || fsync(fd) != 0) {
+            fprintf(stderr, "asdfs_open_volume %s: %s\n", path, strerror(errno));
+            close(fd);
+            return GENERAL_ERROR;
+        }
+    }
+    else {
+        volume_header header;
+        if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) || !volume_match(&header, &layout)
+            || (uint64_t)st.st_size < layout.size) {
+            fprintf(stderr, "asdfs_open_volume %s: not an image of this volume size/build\n", path);
+            close(fd);
+            return GENERAL_ERROR;
+        }
+    }
+
+    // checkpoint를 사용하면 바뀐 page를 커널이 이미지 파일에 쓰지 않도록 private mapping
+    int flags = checkpoint ? MAP_PRIVATE | MAP_NORESERVE : MAP_SHARED;
+    char *base = (char *)mmap(NULL, (size_t)layout.size, PROT_READ | PROT_WRITE, flags, fd, 0);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "asdfs_open_volume %s: %s\n", path, strerror(errno));
+        close(fd);
+        return GENERAL_ERROR;
+    }
+
+    // chunk, page 위치 배열 (주소는 mapping마다 다르므로 이미지에 저장하지 않음)
+    inode_chunks = (inode **)map_zero(sizeof(inode *) * INODE_CHUNK_MAX);
+    cold_chunks = (inode_cold **)map_zero(sizeof(inode_cold *) * INODE_CHUNK_MAX);
+    name_pages = (char **)malloc(sizeof(char *) * layout.namePageMax);
+    if (inode_chunks == NULL || cold_chunks == NULL || name_pages == NULL) {
+        munmap(base, (size_t)layout.size);
+        close(fd);
+        return GENERAL_ERROR;
+    }
+    for (uint32_t i=0; i<layout.slabMax; i++) {
+        inode_chunks[i] = (inode *)(base + layout.hotOffset) + (size_t)i * INODE_CHUNK_SIZE;
+        cold_chunks[i] = (inode_cold *)(base + layout.coldOffset) + (size_t)i * INODE_CHUNK_SIZE;
+    }
+    for (uint32_t i=0; i<layout.namePageMax; i++) {
+        name_pages[i] = base + layout.nameOffset + (size_t)i * NAME_PAGE_SIZE;
+    }
+
+    volume_image = base;
+    volume_fd = fd;
+    volume = (volume_header *)base;
+    slabs = (inode_slab *)(base + layout.slabOffset);
+    data_arena = base + layout.dataOffset;
+    data_arena_fd = fd;
+    data_arena_pos = (off_t)layout.dataOffset;
+    data_arena_free = (uint32_t *)(base + layout.freeOffset);
+    data_arena_refs = (uint32_t *)(base + layout.refsOffset);
+    data_arena_zip = (uint64_t *)(base + layout.zipOffset);
+    data_arena_owner = (inode_id *)(base + layout.ownerOffset);
+    if (dedup_enabled) {
+        dedup_rebuild();
+    }
+
+    // private mapping에서 바뀐 블록은 파일에 없으므로 fd로 참조하지 않음
+    // 바뀐 page bitmap: 이미지 page 하나당 1비트
+    if (checkpoint) {
+        data_arena_fd = -1;
+        dirty_words = (size_t)((layout.size / CHECKPOINT_PAGE + 63) / 64);
+        dirty_pages = (uint64_t *)map_zero(dirty_words * sizeof(uint64_t));
+        flush_pages = (uint64_t *)map_zero(dirty_words * sizeof(uint64_t));
+        if (dirty_pages == NULL || flush_pages == NULL) {
+            return GENERAL_ERROR;
+        }
+        checkpoint_interval = checkpoint;
+    }
+
+    // 반환을 기다리던 pack 반환 (바뀐 page bitmap을 만든 뒤 다음 checkpoint에 기록)
+    zip_rebuild();
+
+    if (!create && !volume->clean) {
+        fprintf(stderr, "asdfs_open_volume %s: not cleanly unmounted\n", path);
+    }
+    // 비정상 종료된 공유 mapping은 dataNext보다 뒤의 블록이 먼저 기록되었을 수 있으므로 파일에서 비움
+    // 비우지 못하면 0이라고 가정하지 않음 (clean이 0으로 남으므로 다음 마운트에서 다시 시도)
+    data_arena_zeroed = create || volume->clean || checkpoint != 0;
+    if (!data_arena_zeroed && volume->dataNext <= data_arena_max()) {
+        size_t tail = ((size_t)data_arena_max() + 1 - volume->dataNext) * DATA_BLOCK_SIZE;
+#ifdef MADV_REMOVE
+        data_arena_zeroed = madvise(data_at(volume->dataNext), tail, MADV_REMOVE) == 0;
+#endif
+        if (!data_arena_zeroed) {
+            fprintf(stderr, "asdfs_open_volume %s: cannot clear blocks past %u\n", path, (unsigned)volume->dataNext);
+        }
+    }
+
+    // 이전 마운트의 커널 lookup 횟수는 모두 무효
+    volume->mounts++;
+    volume->clean = 0;
+    dirty_range(volume, sizeof(volume_header));
+
+    // 이전 마운트에서 삭제되었지만 커널이 참조하던 inode 삭제
+    while (volume->orphans) {
+        inode *node = get_inode(volume->orphans);
+        volume->orphans = get_cold(node)->orphan;
+        get_cold(node)->orphan = 0;
+        dirty_range(get_cold(node), sizeof(inode_cold));
+        destroy_inode(node);
+    }
+    return NO_ERROR;
+}
+
+// 이어 쓰기 예약 자리의 lock 초기화
+static void data_extent_init() {
+    for (int i=0; i<DATA_EXTENT_SLOTS; i++) {
+        pthread_mutex_init(&data_extents[i].lock, NULL);
+    }
+}
+
+// 예약 자리 extent에서 사용하지 않은 블록 번호를 반환하고 비움 (extent lock을 잡은 상태에서 호출)
+static void data_extent_drop(data_extent *extent) {
+    if (extent->used < extent->count) {
+        pthread_mutex_lock(&data_arena_lock);
+        // 다시 가져갈 때 앞 번호부터 나오도록 뒤에서부터 반환
+        while (extent->count > extent->used) {
+            block_ref ref = extent->refs[--extent->count];
+            dirty_range(&data_arena_free[volume->dataFreeCount], sizeof(uint32_t));
+            data_arena_free[volume->dataFreeCount++] = ref;
+        }
+        pthread_mutex_unlock(&data_arena_lock);
+    }
+    extent->id = 0;
+    extent->size = 0;
+    extent->used = 0;
+    extent->count = 0;
+    extent->zero = 0;
+}
+
+// 모든 파일이 예약한 블록 번호 반환 (볼륨을 닫을 때)
+static void data_extent_drop_all() {
+    pthread_once(&data_extent_once, data_extent_init);
+    for (int i=0; i<DATA_EXTENT_SLOTS; i++) {
+        pthread_mutex_lock(&data_extents[i].lock);
+        if (data_extents[i].id != 0) {
+            data_extent_drop(&data_extents[i]);
+        }
+        pthread_mutex_unlock(&data_extents[i].lock);
+    }
+}
+
+// 볼륨 닫기: 압축 스레드를 멈추고 현재 스레드의 inode 번호 cache와 이어 쓰기 예약을 반환하고 이미지 파일을 디스크에 기록
+// checkpoint를 사용하면 checkpoint 스레드를 멈추고 마지막 checkpoint
+void close_volume() {
+    if (spill_started) {
+        pthread_mutex_lock(&spill_lock);
+        spill_stop = 1;
+        pthread_cond_signal(&spill_wake);
+        pthread_mutex_unlock(&spill_lock);
+        pthread_join(spill_thread, NULL);
+        spill_started = 0;
+    }
+    if (zip_started) {
+        pthread_mutex_lock(&zip_lock);
+        zip_stop = 1;
+        pthread_cond_signal(&zip_wake);
+        pthread_mutex_unlock(&zip_lock);
+        pthread_join(zip_thread, NULL);
+        zip_started = 0;
+    }
+    if (magazine.count > 0) {
+        magazine_drain_all(&magazine);
+    }
+    data_extent_drop_all();
+    if (volume_image == NULL) {
+        return;
+    }
+    volume->clean = 1;
+    if (checkpoint_interval == 0) {
+        msync(volume_image, (size_t)volume->size, MS_SYNC);
+        return;
+    }
+
+    if (checkpoint_started) {
+        pthread_mutex_lock(&checkpoint_lock);
+        checkpoint_stop = 1;
+        pthread_cond_signal(&checkpoint_wake);
+        pthread_mutex_unlock(&checkpoint_lock);
+        pthread_join(checkpoint_thread, NULL);
+        checkpoint_started = 0;
+    }
+    dirty_range(volume, sizeof(volume_header));
+    checkpoint_volume();
+}
+
+// 볼륨에 반영된 마지막 journal 기록 번호 반환
+uint64_t get_applied_lsn() {
+    return volume->appliedLsn;
+}
+
+// lsn까지의 journal 기록이 볼륨에 반영되었음을 기록 (더 작은 번호는 무시)
+void set_applied_lsn(uint64_t lsn) {
+    uint64_t applied = volume->appliedLsn;
+    while (applied < lsn && !__sync_bool_compare_and_swap(&volume->appliedLsn, applied, lsn)) {
+        applied = volume->appliedLsn;
+    }
+}
+
+// 이미지 파일의 데이터 블록 앞 영역 (볼륨 정보, inode, 이름)을 디스크에 기록
+// checkpoint를 사용하면 바뀐 page 전체를 checkpoint
+// 이미지 파일을 쓰지 않으면 아무것도 하지 않음
+asdfs_errno sync_volume() {
+    if (volume_image == NULL) {
+        return NO_ERROR;
+    }
+    if (checkpoint_interval) {
+        return checkpoint_volume();
+    }
+    if (msync(volume_image, (size_t)volume->dataOffset, MS_SYNC) != 0) {
+        fprintf(stderr, "asdfs_sync_volume: %s\n", strerror(errno));
+        return GENERAL_ERROR;
+    }
+    return NO_ERROR;
+}
+
+// 파일 시스템 superblock 정보 반환
+struct statvfs get_superblock() {
+    struct statvfs buf = volume->superblock;
+
+    // 사용 가능한 파일 시리얼 넘버 (inode) 개수
+    fsfilcnt_t f_files = buf.f_files;
+    buf.f_ffree = f_files < volume->inodeCapacity ? volume->inodeCapacity - f_files : 0;
+    buf.f_favail = buf.f_ffree;
+	return buf;
+}
+
+// 파일 시스템 root inode 반환
+inode *get_root() {
+    return volume->slabCount > 0 ? get_inode(ROOT_INODE_ID) : NULL;
+}
+
+// 검색 결과 res의 parent, exact에 대한 보조 비트 마스크를 return_code에 적용
+static asdfs_errno search_permission(credential *cred, search_result *res, asdfs_errno return_code) {
+    // journal 재적용 중에는 모든 권한 허용
+    if (replaying) {
+        return return_code | CAN_READ_PARENT | CAN_WRITE_PARENT | CAN_EXECUTE_PARENT
+            | CAN_READ_EXACT | CAN_WRITE_EXACT | CAN_EXECUTE_EXACT | IS_OWNER;
+    }
+
+    // parent를 찾은 경우 해당하는 보조 비트 마스크 적용
+    if (res->parent) {
+        return_code |= can_read(cred, res->parent) ? CAN_READ_PARENT : 0;
+        return_code |= can_write(cred, res->parent) ? CAN_WRITE_PARENT : 0;
+        return_code |= can_execute(cred, res->parent) ? CAN_EXECUTE_PARENT : 0;
+    }
+
+    // exact 찾은 경우 해당하는 보조 비트 마스크 적용
+    if (res->exact) {
+        return_code |= can_read(cred, res->exact) ? CAN_READ_EXACT : 0;
+        return_code |= can_write(cred, res->exact) ? CAN_WRITE_EXACT : 0;
+        return_code |= can_execute(cred, res->exact) ? CAN_EXECUTE_EXACT : 0;
+
+        // 호출 프로세스가 exact의 소유자인 경우
+        if (res->exact->uid == cred->uid) {
+            return_code |= IS_OWNER;
+        }
+    }
+
+    return return_code;
+}
+
+// cursor 위치부터 다음 path component를 comp에 기록하고 cursor 이동
+// 남은 component가 없으면 0 반환
+int next_path_comp(const char **cursor, path_comp *comp) {
+    const char *ptr = *cursor;
+
+    // 연속된 "/" 건너뛰기
+    while (*ptr == '/') {
+        ptr++;
+    }
+    // 남은 component 없음
+    if (*ptr == '\0') {
+        *cursor = ptr;
+        return 0;
+    }
+
+    // 다음 "/" 또는 문자열 끝까지가 하나의 component
+    const char *end = ptr;
+    while (*end != '/' && *end != '\0') {
+        end++;
+    }
+
+    comp->name = ptr;
+    comp->length = (size_t)(end - ptr);
+    *cursor = end;
+    return 1;
+}
+
+// path에 해당하는 inode 검색, 결과 res 포인터로 반환
+asdfs_errno find_inode(const char *path, search_result *res) {
+    if (res == NULL) {
+        return GENERAL_ERROR;
+    }
+
+    // res 초기화
+    res->parent = NULL;
+    res->left = NULL;
+    res->exact = NULL;
+    res->right = NULL;
+    res->tail.name = NULL;
+    res->tail.length = 0;
+
+    // 호출 프로세스 자격 정보, 이번 요청의 모든 권한 확인에 사용
+    credential cred;
+    get_credential(&cred);
+    
+    // root를 찾는 경우
+    inode *root = get_root();
+    if (strcmp(path, "/")==0) {
+        // 위치 정보 반환
+        res->exact = root;
+
+        // 주요 오류 번호 및 비트 마스크 반환
+        asdfs_errno return_code = EXACT_FOUND;
+        return_code |= can_read(&cred, root) ? CAN_READ_EXACT : 0;
+        return_code |= can_write(&cred, root) ? CAN_WRITE_PARENT : 0;
+        return_code |= can_execute(&cred, root) ? CAN_EXECUTE_EXACT : 0;
+        return return_code;
+    }
+    
+    // dentry cache에 있는 경우 tree 탐색 생략
+    asdfs_errno return_code = dcache_lookup(path, res, &cred);
+    if (return_code == EXACT_FOUND) {
+        res->tail.name = get_name(res->exact);
+        res->tail.length = res->exact->nameLength;
+        return search_permission(&cred, res, return_code);
+    }
+    // 최근에 없었던 path인 경우
+    if (return_code == HEAD_NOT_FOUND) {
+        return return_code;
+    }
+    if (return_code == EXACT_NOT_FOUND) {
+        // tail은 path의 마지막 component
+        const char *cursor = path;
+        path_comp comp;
+        while (next_path_comp(&cursor, &comp)) {
+            res->tail = comp;
+        }
+        return search_permission(&cred, res, return_code);
+    }
+
+    // 탐색 도중 무효화 여부를 확인하기 위한 현재 dentry cache 세대
+    pthread_mutex_lock(&dcache_lock);
+    unsigned long generation = dcache_generation;
+    pthread_mutex_unlock(&dcache_lock);
+
+    // supplementary groups 없이 탐색했는지 여부 (dentry cache 저장 가능 여부)
+    int cacheable = 1;
+
+    // parent는 root에서 시작
+    inode *parent = root;
+
+    // path의 첫번째 component부터 탐색
+    const char *cursor = path;
+
+    // 상위 디렉터리가 고정된 경우 상위 디렉터리의 마지막 component부터 탐색
+    int held = dcache_held_lookup(path, &cursor, generation, &cred, &parent);
+
+    path_comp curr_comp;
+    int has_comp = next_path_comp(&cursor, &curr_comp);
+    while (has_comp) {
+        // parent가 디렉터리가 아닌 경우 탐색 불가
+        if (!(parent->mode & S_IFDIR)) {
+            // tree path 중간에 디렉터리가 아닌 inode 있음
+            return HEAD_NOT_DIRECTORY;
+        }
+
+        // superuser가 아닌 사용자면서 상위 폴더에 EXECUTE 권한이 없을 경우 탐색 불가
+        if (!is_root(&cred) && !can_execute_without_groups(&cred, parent)) {
+            if (!can_execute(&cred, parent)) {
+                // tree path 탐색 권한 없음
+                return HEAD_NO_PERMISSION;
+            }
+            // supplementary group으로 탐색한 결과는 uid, gid만으로 재사용 불가
+            cacheable = 0;
+        }
+        
+        // parent 아래에 curr_comp에 해당하는 inode가 있는지 검색
+        if (held >= 0) {
+            return_code = dcache_held_search(held, parent, curr_comp.name, curr_comp.length, res);
+        }
+        else {
+            return_code = child_search(parent, curr_comp.name, curr_comp.length, res);
+        }
+        res->tail = curr_comp;
+
+        // 다음 처리할 path component
+        path_comp next_comp;
+        has_comp = next_path_comp(&cursor, &next_comp);
+        
+        // curr_comp inode가 있었을 경우,
+        if (return_code == EXACT_FOUND) {
+            // parent를 exact로 교체
+            parent = res->exact;
+        }
+        // curr_comp inode가 없었으나 다음 처리할 path component가 남은 경우
+        else if (has_comp) {
+            // parent에 curr_comp가 추가되기 전까지 없는 path로 저장
+            if (cacheable) {
+                dcache_insert(path, res, HEAD_NOT_FOUND, get_cold(parent)->version, generation, &cred);
+            }
+            // 주어진 위치로의 tree path 없음
+            return HEAD_NOT_FOUND;
+        }
+
+        // next_comp로 진행
+        curr_comp = next_comp;
+    }
+
+    // 찾은 inode 또는 없는 마지막 component는 dentry cache에 저장
+    if ((return_code == EXACT_FOUND || return_code == EXACT_NOT_FOUND) && cacheable) {
+        dcache_insert(path, res, return_code, get_cold(parent)->version, generation, &cred);
+    }
+
+    return search_permission(&cred, res, return_code);
+}
+
+// parent 아래에서 name에 해당하는 inode 검색, 결과 res 포인터로 반환
+asdfs_errno lookup_inode(inode *parent, const char *name, search_result *res) {
+    if (parent == NULL || name == NULL || res == NULL) {
+        return GENERAL_ERROR;
+    }
+
+    // 호출 프로세스 자격 정보, 이번 요청의 모든 권한 확인에 사용
+    credential cred;
+    get_credential(&cred);
+
+    // parent가 디렉터리가 아닌 경우 탐색 불가
+    if (!(parent->mode & S_IFDIR)) {
+        // tree path 중간에 디렉터리가 아닌 inode 있음
+        return HEAD_NOT_DIRECTORY;
+    }
+
+    // superuser가 아닌 사용자면서 parent에 EXECUTE 권한이 없을 경우 탐색 불가
+    if (!is_root(&cred) && !can_execute(&cred, parent)) {
+        // tree path 탐색 권한 없음
+        return HEAD_NO_PERMISSION;
+    }
+
+    // parent 아래에 name에 해당하는 inode가 있는지 검색
+    size_t length = strlen(name);
+    asdfs_errno return_code = child_search(parent, name, length, res);
+    res->tail.name = name;
+    res->tail.length = length;
+
+    return search_permission(&cred, res, return_code);
+}
+
+// node의 위치 정보 및 보조 비트 마스크를 포함한 검색 결과 res 포인터로 반환
+asdfs_errno access_inode(inode *node, search_result *res) {
+    if (node == NULL || res == NULL) {
+        return GENERAL_ERROR;
+    }
+
+    // 위치 정보 반환
+    res->parent = get_inode(node->parent);
+    res->left = get_inode(node->leftSibling);
+    res->exact = node;
+    res->right = get_inode(node->rightSibling);
+    res->tail.name = get_name(node);
+    res->tail.length = node->nameLength;
+
+    // 호출 프로세스 자격 정보
+    credential cred;
+    get_credential(&cred);
+
+    return search_permission(&cred, res, EXACT_FOUND);
+}
+
+// 잔여 블록 count개 예약, 남은 블록이 모자라면 0 반환
+// 여러 스레드가 동시에 할당하므로 확인과 감소를 compare-and-swap 한 번으로 처리
+static int space_take(uint64_t count) {
+    fsblkcnt_t free = __atomic_load_n(&volume->superblock.f_bfree, __ATOMIC_RELAXED);
+    do {
+        if (free < count) {
+            return 0;
+        }
+    } while (!__atomic_compare_exchange_n(&volume->superblock.f_bfree, &free, free - count, 0,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    __atomic_sub_fetch(&volume->superblock.f_bavail, count, __ATOMIC_RELAXED);
+    return 1;
+}
+
+// 반환한 블록 count개를 잔여 블록에 더함
+static void space_give(uint64_t count) {
+    __atomic_add_fetch(&volume->superblock.f_bfree, count, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&volume->superblock.f_bavail, count, __ATOMIC_RELAXED);
+}
+
+// find_inode 결과 res의 tail 이름으로 새로운 inode 생성, out 포인터로 반환
+asdfs_errno create_inode(const search_result *res, struct stat attr, inode **out) {
+    // find_inode에서 찾은 마지막 path component가 파일 이름 (tail)
+    if (res == NULL || res->tail.name == NULL) {
+        return GENERAL_ERROR;
+    }
+
+    // inode table에서 새로운 inode 할당
+    inode *new = alloc_inode();
+    if (new == NULL) {
+        return GENERAL_ERROR;
+    }
+
+    // 파일 시스템 잔여 블록 수 계산
+    unsigned long block_size = volume->superblock.f_bsize;
+    unsigned long inodes_per_block = block_size / INODE_SIZE_BYTE;
+
+    // new를 제외한 inode 개수에서 블록 당 inode 개수를 나눈
+    // 나머지가 0이면 새로운 블록 할당 필요
+    fsfilcnt_t remainder = (volume->superblock.f_files - 1) % inodes_per_block;
+    if (remainder == 0) {
+        // 이 때 남은 블록이 없다면 
+        if (!space_take(1)) {
+            free_inode(new);
+            // 파일 시스템에 남은 용량 없음
+            return NO_FREE_SPACE;
+        }
+    }
+
+    // 파일 정보 복사
+    inode_cold *cold = get_cold(new);
+    new->mode   = attr.st_mode;
+    new->uid    = attr.st_uid;
+    new->gid    = attr.st_gid;
+    cold->nlink = attr.st_nlink;
+    cold->rdev  = attr.st_rdev;
+    cold->atime = attr.st_atime;
+    cold->mtime = attr.st_mtime;
+    cold->ctime = attr.st_ctime;
+
+    // 파일 이름 복사
+    if (rename_inode(new, res->tail) != NO_ERROR) {
+        destroy_inode(new);
+        return GENERAL_ERROR;
+    }
+
+    // out 포인터로 new 반환
+    *out = new;
+    return NO_ERROR;
+}
+
+#define DATA_FANOUT (1u << DATA_FANOUT_SHIFT)
+
+// 할당되지 않은 블록을 읽을 때 사용하는 0으로 채워진 블록
+static const char zero_block[DATA_BLOCK_SIZE];
+
+// 블록 영역 생성 (처음 한 번), 실패 시 -1 반환 (data_arena_lock 필요)
+// 이미지 파일을 사용하면 open_volume에서 생성
+static int data_arena_init() {
+    if (data_arena != NULL) {
+        return 0;
+    }
+    // 0번은 없음을 의미하므로 블록 하나 더 예약
+    size_t size = ((size_t)data_arena_max() + 1) * DATA_BLOCK_SIZE;
+
+    // spill 디렉터리가 있으면 그 안의 이름 없는 파일, 블록을 내려도 파일에 남음
+    int fd = -1;
+    if (spill_dir != NULL) {
+        fd = spill_create(spill_dir, size);
+        if (fd < 0) {
+            fprintf(stderr, "asdfs_spill %s: %s\n", spill_dir, strerror(errno));
+            return -1;
+        }
+    }
+#if defined(__linux__) && defined(SYS_memfd_create)
+    // 파일 크기만 정하고 실제 메모리는 쓰는 블록만 사용
+    else {
+        fd = (int)syscall(SYS_memfd_create, "asdfs", 1); // MFD_CLOEXEC
+        if (fd >= 0 && ftruncate(fd, (off_t)size) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+#endif
+    if (fd >= 0) {
+        void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_NORESERVE, fd, 0);
+        if (ptr != MAP_FAILED) {
+            data_arena = (char *)ptr;
+            data_arena_fd = fd;
+        }
+        else {
+            close(fd);
+        }
+    }
+    // memfd를 쓸 수 없으면 익명 mapping (spill 파일은 mapping할 수 없으면 실패)
+    if (data_arena == NULL && spill_dir == NULL) {
+        data_arena = (char *)map_zero(size);
+    }
+    data_arena_free = (uint32_t *)map_zero(sizeof(uint32_t) * data_arena_max());
+    data_arena_refs = (uint32_t *)map_zero(sizeof(uint32_t) * ((size_t)data_arena_max() + 1));
+    data_arena_zip = (uint64_t *)map_zero(sizeof(uint64_t) * ((size_t)data_arena_max() + 1));
+    data_arena_owner = (inode_id *)map_zero(sizeof(inode_id) * ((size_t)data_arena_max() + 1));
+    if (volume->dataNext == 0) {
+        volume->dataNext = 1;
+    }
+    return (data_arena && data_arena_free && data_arena_refs && data_arena_zip && data_arena_owner) ? 0 : -1;
+}
+
+// 블록 영역에서 블록 하나 할당, 없으면 0
+// 반환된 블록을 다시 쓰는 경우 이전 내용이 남아 있음
+// zero가 NULL이 아니면 한 번도 쓰지 않아 0인 블록인지 여부를 기록 (0으로 채우지 않아도 되며 아직 메모리를 쓰지 않음)
+static block_ref data_arena_take(int *zero) {
+    block_ref ref = 0;
+    int fresh = 0;
+    pthread_mutex_lock(&data_arena_lock);
+    if (data_arena_init() == 0) {
+        if (volume->dataFreeCount > 0) {
+            ref = data_arena_free[--volume->dataFreeCount];
+        }
+        else if (volume->dataNext <= data_arena_max()) {
+            ref = volume->dataNext++;
+            fresh = data_arena_zeroed;
+        }
+    }
+    pthread_mutex_unlock(&data_arena_lock);
+    if (zero != NULL) {
+        *zero = fresh;
+    }
+    return ref;
+}
+
+// 블록을 블록 영역에 반환
+static void data_arena_put(block_ref ref) {
+    pthread_mutex_lock(&data_arena_lock);
+    dirty_range(&data_arena_free[volume->dataFreeCount], sizeof(uint32_t));
+    data_arena_free[volume->dataFreeCount++] = ref;
+    pthread_mutex_unlock(&data_arena_lock);
+}
+
+// 블록 번호를 최대 count개 가져와 refs에 오름차순으로 기록, 가져온 개수 반환
+// 반환된 번호부터 사용하므로 지운 파일의 블록을 다시 쓰면 그 파일과 같은 순서로 이어짐
+// 한 번도 쓰지 않은 0인 블록은 반환된 번호보다 크므로 그 첫 번호를 zero에 기록 (없으면 가장 큰 번호 + 1)
+static uint32_t data_arena_take_run(block_ref *refs, uint32_t count, block_ref *zero) {
+    uint32_t taken = 0;
+    *zero = data_arena_max() + 1;
+    pthread_mutex_lock(&data_arena_lock);
+    if (data_arena_init() == 0) {
+        while (taken < count && volume->dataFreeCount > 0) {
+            refs[taken++] = data_arena_free[--volume->dataFreeCount];
+        }
+        if (taken < count && data_arena_zeroed) {
+            *zero = volume->dataNext;
+        }
+        while (taken < count && volume->dataNext <= data_arena_max()) {
+            refs[taken++] = volume->dataNext++;
+        }
+    }
+    pthread_mutex_unlock(&data_arena_lock);
+
+    for (uint32_t i=1; i<taken; i++) {
+        block_ref ref = refs[i];
+        uint32_t j = i;
+        for (; j > 0 && refs[j - 1] > ref; j--) {
+            refs[j] = refs[j - 1];
+        }
+        refs[j] = ref;
+    }
+    return taken;
+}
+
+// id 파일의 index번째 블록에 쓸 블록 번호 반환, 없으면 0
+// 파일 끝에 이어 쓰면 (append) 예약한 번호를 차례로 사용하고, 다 쓰면 두 배로 다시 예약
+// 그 외의 위치는 블록 영역에서 하나만 가져옴
+// 한 번도 쓰지 않아 0인 블록인지 여부는 zero 포인터로 반환
+static block_ref data_extent_take(inode_id id, uint64_t index, int append, int *zero) {
+    pthread_once(&data_extent_once, data_extent_init);
+    data_extent *extent = &data_extents[id % DATA_EXTENT_SLOTS];
+    pthread_mutex_lock(&extent->lock);
+
+    // 예약한 번호로 이어 쓰는 중
+    if (extent->id == id && extent->next == index && extent->used < extent->count) {
+        block_ref ref = extent->refs[extent->used++];
+        extent->next++;
+        *zero = ref >= extent->zero;
+        pthread_mutex_unlock(&extent->lock);
+        return ref;
+    }
+
+    // 파일의 첫 블록이거나 파일 끝이 아니면 예약하지 않음
+    if (!append || index == 0) {
+        pthread_mutex_unlock(&extent->lock);
+        return data_arena_take(zero);
+    }
+
+    // 다른 파일이 쓰던 자리이거나 다른 위치에서 이어 쓰기 시작하면 남은 번호 반환
+    uint32_t size = 2;
+    if (extent->id == id && extent->next == index) {
+        size = extent->size * 2 < DATA_EXTENT_MAX ? extent->size * 2 : DATA_EXTENT_MAX;
+    }
+    data_extent_drop(extent);
+    block_ref first_zero;
+    extent->count = data_arena_take_run(extent->refs, size, &first_zero);
+    if (extent->count == 0) {
+        pthread_mutex_unlock(&extent->lock);
+        return 0;
+    }
+    extent->id = id;
+    extent->size = size;
+    extent->used = 1;
+    extent->next = index + 1;
+    extent->zero = first_zero;
+    block_ref ref = extent->refs[0];
+    *zero = ref >= extent->zero;
+    pthread_mutex_unlock(&extent->lock);
+    return ref;
+}
+
+// id 파일이 예약한 블록 번호 중 사용하지 않은 번호 반환
+static void data_extent_release(inode_id id) {
+    pthread_once(&data_extent_once, data_extent_init);
+    data_extent *extent = &data_extents[id % DATA_EXTENT_SLOTS];
+    pthread_mutex_lock(&extent->lock);
+    if (extent->id == id) {
+        data_extent_drop(extent);
+    }
+    pthread_mutex_unlock(&extent->lock);
+}
+
+// 압축을 푼 블록 cache의 lock 초기화
+static void zip_cache_init() {
+    for (int i=0; i<ZIP_CACHE_SIZE; i++) {
+        pthread_mutex_init(&zip_cache[i].lock, NULL);
+    }
+}
+
+// 압축된 블록 ref (압축 상태 desc)의 inner 위치부터 length 바이트를 mem으로 복사
+// 압축을 푼 블록 cache에 없으면 pack에서 풀어서 cache에 저장
+static void zip_read(block_ref ref, uint64_t desc, char *mem, size_t inner, size_t length) {
+    pthread_once(&zip_once, zip_cache_init);
+    zip_entry *entry = &zip_cache[ref % ZIP_CACHE_SIZE];
+    pthread_mutex_lock(&entry->lock);
+    if (entry->ref == ref && entry->desc == desc) {
+        __sync_fetch_and_add(&zip_counter.hit, 1);
+    }
+    else {
+        entry->ref = 0;
+        if (decompress_data(zip_data(desc), zip_size(desc), entry->data, DATA_BLOCK_SIZE) == 0) {
+            entry->ref = ref;
+            entry->desc = desc;
+        }
+        else {
+            fprintf(stderr, "asdfs_zip_read: corrupted block %u\n", ref);
+            memset(entry->data, 0, DATA_BLOCK_SIZE);
+        }
+        __sync_fetch_and_add(&zip_counter.miss, 1);
+    }
+    memcpy(mem, entry->data + inner, length);
+    pthread_mutex_unlock(&entry->lock);
+}
+
+// 블록 ref가 더 이상 압축 상태로 pack에 있지 않음, 압축을 푼 블록 cache에서 제거
+static void zip_cache_drop(block_ref ref) {
+    pthread_once(&zip_once, zip_cache_init);
+    zip_entry *entry = &zip_cache[ref % ZIP_CACHE_SIZE];
+    pthread_mutex_lock(&entry->lock);
+    if (entry->ref == ref) {
+        entry->ref = 0;
+    }
+    pthread_mutex_unlock(&entry->lock);
+}
+
+// 압축된 블록 ref (압축 상태 desc)의 줄어든 크기를 소유 파일의 st_blocks에 반영 (sign: 1 압축, -1 해제)
+static void zip_credit(block_ref ref, uint64_t desc, int sign) {
+    inode *owner = get_inode(data_arena_owner[ref]);
+    if (owner == NULL) {
+        return;
+    }
+    inode_cold *cold = get_cold(owner);
+    cold->zipSaved += sign * (blkcnt_t)((DATA_BLOCK_SIZE - zip_size(desc)) / 512);
+    dirty_range(cold, sizeof(inode_cold));
+}
+
+// 비워진 pack 반환
+// 읽기 요청이 아직 pack을 가리킬 수 있으므로 압축 스레드가 실행 중이면 두 주기 뒤에 블록 영역에 반환
+static void zip_pack_retire(block_ref pack) {
+    __sync_fetch_and_sub(&zip_counter.packs, 1);
+    space_give(1);
+    pthread_mutex_lock(&zip_lock);
+    int later = zip_started;
+    if (later) {
+        data_arena_zip[pack] = ZIP_PACK | ZIP_RETIRED | zip_retiring;
+        zip_retiring = pack;
+    }
+    else {
+        data_arena_zip[pack] = 0;
+    }
+    dirty_range(&data_arena_zip[pack], sizeof(uint64_t));
+    pthread_mutex_unlock(&zip_lock);
+    if (!later) {
+        data_arena_put(pack);
+    }
+}
+
+// pack에서 size 바이트 항목 하나가 빠짐, 모두 비면 반환 (채워 넣는 중인 pack은 계속 사용)
+static void zip_pack_drop(block_ref pack, uint32_t size) {
+    uint64_t left = __sync_sub_and_fetch(&data_arena_zip[pack], size);
+    dirty_range(&data_arena_zip[pack], sizeof(uint64_t));
+    if ((uint32_t)left == 0 && pack != volume->zipPack) {
+        zip_pack_retire(pack);
+    }
+}
+
+// 압축된 블록 ref의 압축을 풀어 블록 메모리에 다시 저장 (공유하지 않는 블록에 쓰기 전에 호출)
+// 남은 블록이 없으면 NO_FREE_SPACE 반환
+static asdfs_errno zip_expand(block_ref ref) {
+    uint64_t desc = data_arena_zip[ref];
+    if (!(desc & ZIP_PACKED)) {
+        return NO_ERROR;
+    }
+    // 블록 메모리만큼 잔여 블록 예약
+    if (!space_take(1)) {
+        return NO_FREE_SPACE;
+    }
+    zip_read(ref, desc, data_at(ref), 0, DATA_BLOCK_SIZE);
+    dirty_range(data_at(ref), DATA_BLOCK_SIZE);
+    data_arena_zip[ref] = 0;
+    dirty_range(&data_arena_zip[ref], sizeof(uint64_t));
+    zip_cache_drop(ref);
+    zip_credit(ref, desc, -1);
+    __sync_fetch_and_sub(&zip_counter.blocks, 1);
+    __sync_fetch_and_sub(&zip_counter.bytes, zip_size(desc));
+    __sync_fetch_and_add(&zip_counter.expanded, 1);
+    zip_pack_drop(zip_pack_of(desc), zip_size(desc));
+    return NO_ERROR;
+}
+
+// 반환하는 블록 ref의 압축 상태와 소유 파일 정리
+// 압축된 블록이었으면 (블록을 차지하지 않으므로 잔여 블록이 늘지 않음) 1 반환
+static int zip_forget(block_ref ref) {
+    uint64_t desc = data_arena_zip[ref];
+    if (desc & ZIP_PACKED) {
+        data_arena_zip[ref] = 0;
+        dirty_range(&data_arena_zip[ref], sizeof(uint64_t));
+        zip_cache_drop(ref);
+        zip_credit(ref, desc, -1);
+        __sync_fetch_and_sub(&zip_counter.blocks, 1);
+        __sync_fetch_and_sub(&zip_counter.bytes, zip_size(desc));
+        zip_pack_drop(zip_pack_of(desc), zip_size(desc));
+    }
+    if (data_arena_owner[ref] != 0) {
+        data_arena_owner[ref] = 0;
+        dirty_range(&data_arena_owner[ref], sizeof(inode_id));
+    }
+    return (desc & ZIP_PACKED) != 0;
+}
+
+// 블록 ref의 CLOCK 사용 비트 표시, 메모리에서 내린 블록이면 다시 읽은 것으로 셈
+static void spill_use(block_ref ref) {
+    uint8_t state = __sync_fetch_and_and(&spill_state[ref], (uint8_t)~SPILL_OUT);
+    if (state & SPILL_OUT) {
+        __sync_fetch_and_add(&spill_counter.fetched, 1);
+        __sync_fetch_and_sub(&spill_counter.out, 1);
+    }
+    if (!(state & SPILL_USED)) {
+        __sync_fetch_and_or(&spill_state[ref], SPILL_USED);
+    }
+}
+
+// 블록 ref가 더 이상 블록 메모리를 쓰지 않음 (반환 또는 압축), 내보내기 상태 정리
+static void spill_forget(block_ref ref) {
+    if (spill_state == NULL) {
+        return;
+    }
+    uint8_t state = __sync_fetch_and_and(&spill_state[ref], 0);
+    if (state & SPILL_OUT) {
+        __sync_fetch_and_sub(&spill_counter.out, 1);
+    }
+}
+
+// 메모리에 있는 것으로 보는 사용 중인 블록 개수
+static uint64_t spill_resident() {
+    uint64_t used = volume->superblock.f_blocks - volume->superblock.f_bfree;
+    uint64_t out = spill_counter.out;
+    return used > out ? used - out : 0;
+}
+
+// 블록을 할당한 뒤 블록 메모리가 예산을 넘으면 다음 주기를 기다리지 않고 블록을 내리는 스레드를 깨움
+static void spill_check() {
+    if (!spill_started || spill_wanted || spill_resident() <= spill_budget) {
+        return;
+    }
+    if (__sync_bool_compare_and_swap(&spill_wanted, 0, 1)) {
+        pthread_mutex_lock(&spill_lock);
+        pthread_cond_signal(&spill_wake);
+        pthread_mutex_unlock(&spill_lock);
+    }
+}
+
+// 블록 ref를 읽거나 씀 (압축 대상에서 interval초 동안 제외, 내보낼 블록 후보에서 한 바퀴 제외)
+static void data_touch(block_ref ref) {
+    if (data_arena_touch != NULL && data_arena_touch[ref] != zip_now) {
+        data_arena_touch[ref] = zip_now;
+    }
+    if (spill_state != NULL && spill_state[ref] != SPILL_USED) {
+        spill_use(ref);
+    }
+}
+
+// 다른 위치와 공유하지 않는 데이터 블록 ref의 소유 파일을 id로 기록 (압축한 크기를 st_blocks에 반영할 파일)
+static void data_own(block_ref ref, inode_id id) {
+    if (data_arena_owner[ref] != id && data_arena_refs[ref] == 0) {
+        data_arena_owner[ref] = id;
+        dirty_range(&data_arena_owner[ref], sizeof(inode_id));
+    }
+}
+
+// 블록 ref를 다른 위치도 가리키게 됨: 소유 파일을 지우고 압축으로 줄어든 크기는 소유 파일에서 뺌
+static void data_disown(block_ref ref) {
+    if (data_arena_owner[ref] == 0) {
+        return;
+    }
+    uint64_t desc = data_arena_zip[ref];
+    if (desc & ZIP_PACKED) {
+        zip_credit(ref, desc, -1);
+    }
+    data_arena_owner[ref] = 0;
+    dirty_range(&data_arena_owner[ref], sizeof(inode_id));
+}
+
+// 파일 위치 하나가 데이터 블록 ref를 더 이상 가리키지 않음
+// 공유하는 다른 위치가 없으면 블록을 반환하고 1, 아직 공유 중이면 공유 횟수만 줄이고 0 반환
+// 압축된 블록은 반환해도 잔여 블록이 늘지 않으므로 0 반환
+static int data_unref(block_ref ref) {
+    for (;;) {
+        uint32_t refs = data_arena_refs[ref];
+        if ((refs & ~DEDUP_INDEXED) == 0) {
+            // 색인된 블록은 색인에서 뺀 뒤 반환, 그 사이 다른 위치가 공유하면 다시 확인
+            if (refs == DEDUP_INDEXED && !dedup_remove(ref)) {
+                continue;
+            }
+            int packed = zip_forget(ref);
+            spill_forget(ref);
+            data_arena_put(ref);
+            return !packed;
+        }
+        if (__sync_bool_compare_and_swap(&data_arena_refs[ref], refs, refs - 1)) {
+            dirty_range(&data_arena_refs[ref], sizeof(uint32_t));
+            return 0;
+        }
+    }
+}
+
+// 0으로 채운 radix tree 노드 할당, 실패하면 0
+// 노드는 볼륨의 블록 하나를 차지하지만 파일의 블록 수에는 포함하지 않음
+static block_ref data_node_alloc() {
+    if (!space_take(1)) {
+        return 0;
+    }
+    int zero;
+    block_ref ref = data_arena_take(&zero);
+    if (ref == 0) {
+        space_give(1);
+        return 0;
+    }
+    if (!zero) {
+        memset(data_at(ref), 0, DATA_BLOCK_SIZE);
+    }
+    dirty_range(data_at(ref), DATA_BLOCK_SIZE);
+    return ref;
+}
+
+// radix tree 노드 반환
+static void data_node_free(block_ref ref) {
+    data_arena_put(ref);
+    space_give(1);
+}
+
+// level 높이의 radix tree 노드 ref와 하위 노드, 블록 반환, 파일에서 뺀 데이터 블록 수 반환
+// 다른 파일과 공유 중이라 볼륨에 남은 블록 수는 shared 포인터에 더함
+static blkcnt_t data_free(block_ref ref, int level, blkcnt_t *shared) {
+    if (ref == 0) {
+        return 0;
+    }
+    if (level == 0) {
+        *shared += !data_unref(ref);
+        return 1;
+    }
+    blkcnt_t freed = 0;
+    block_ref *node = (block_ref *)data_at(ref);
+    for (unsigned i=0; i<DATA_FANOUT; i++) {
+        freed += data_free(node[i], level - 1, shared);
+    }
+    data_node_free(ref);
+    return freed;
+}
+
+// cold data의 index번째 블록 번호 위치 반환
+// create가 0이 아니면 필요한 노드를 할당하고, 아니면 없는 경우 NULL 반환
+static block_ref *data_slot(inode_cold *cold, uint64_t index, int create) {
+    // index번째 블록이 들어갈 때까지 radix tree 높이 증가
+    while (cold->dataHeight * DATA_FANOUT_SHIFT < 64 && (index >> (cold->dataHeight * DATA_FANOUT_SHIFT)) != 0) {
+        if (!create) {
+            return NULL;
+        }
+        // 기존 root를 새로운 root의 첫번째 자식으로
+        if (cold->data != 0) {
+            block_ref node = data_node_alloc();
+            if (node == 0) {
+                return NULL;
+            }
+            ((block_ref *)data_at(node))[0] = cold->data;
+            cold->data = node;
+        }
+        cold->dataHeight++;
+    }
+
+    // root부터 index번째 블록까지 내려감
+    block_ref *slot = &cold->data;
+    for (int level = cold->dataHeight; level > 0; level--) {
+        if (*slot == 0) {
+            if (!create) {
+                return NULL;
+            }
+            *slot = data_node_alloc();
+            if (*slot == 0) {
+                return NULL;
+            }
+            dirty_range(slot, sizeof(block_ref));
+        }
+        unsigned child = (unsigned)(index >> ((level - 1) * DATA_FANOUT_SHIFT)) & (DATA_FANOUT - 1);
+        slot = &((block_ref *)data_at(*slot))[child];
+    }
+    return slot;
+}
+
+// level 높이의 하위 트리 slot (첫 블록 번호 base)에서 first번째부터 end번째 전까지 블록 반환
+// 모든 자식이 반환된 노드도 반환, 파일에서 뺀 데이터 블록 수 반환 (공유 중인 블록은 shared에 더함)
+static blkcnt_t data_clear(block_ref *slot, int level, uint64_t base, uint64_t first, uint64_t end, blkcnt_t *shared) {
+    if (*slot == 0) {
+        return 0;
+    }
+
+    // 하위 트리 전체가 범위 안인 경우
+    uint64_t span = (uint64_t)1 << (level * DATA_FANOUT_SHIFT);
+    if (base >= first && (base + span - 1) < end) {
+        blkcnt_t freed = data_free(*slot, level, shared);
+        *slot = 0;
+        dirty_range(slot, sizeof(block_ref));
+        return freed;
+    }
+    if (level == 0) {
+        return 0;
+    }
+
+    // 하위 트리 일부가 범위 안인 경우
+    block_ref *node = (block_ref *)data_at(*slot);
+    uint64_t child_span = span >> DATA_FANOUT_SHIFT;
+    unsigned from = first > base ? (unsigned)((first - base) / child_span) : 0;
+    unsigned to = (end - base - 1) / child_span < DATA_FANOUT ? (unsigned)((end - base - 1) / child_span) : DATA_FANOUT - 1;
+    blkcnt_t freed = 0;
+    for (unsigned i=from; i<=to; i++) {
+        freed += data_clear(&node[i], level - 1, base + i * child_span, first, end, shared);
+    }
+
+    // 남은 자식이 없으면 노드 반환
+    unsigned i = 0;
+    while (i < DATA_FANOUT && node[i] == 0) {
+        i++;
+    }
+    if (i == DATA_FANOUT) {
+        data_node_free(*slot);
+        *slot = 0;
+        dirty_range(slot, sizeof(block_ref));
+    }
+    return freed;
+}
+
+// cold data의 first번째부터 end번째 전까지 블록 반환 후 파일 시스템 잔여 블록에 반영
+// 다른 파일과 공유 중인 블록은 파일에서만 빠지고 잔여 블록은 그대로
+static void data_release(inode_cold *cold, uint64_t first, uint64_t end) {
+    if (first >= end) {
+        return;
+    }
+    blkcnt_t shared = 0;
+    blkcnt_t freed = data_clear(&cold->data, cold->dataHeight, 0, first, end, &shared);
+    cold->blocks -= freed;
+    volume->logicalBlocks -= freed;
+    space_give((uint64_t)(freed - shared));
+}
+
+// slot의 데이터 블록을 다른 파일과 공유 중이면 복사본으로 교체 (블록에 쓰기 전에 호출)
+// 중복 제거 색인에만 있는 블록은 색인에서 빼고 그대로 사용, 압축된 블록은 압축을 풀어서 사용
+// 남은 블록이 없으면 NO_FREE_SPACE, 할당 실패 시 GENERAL_ERROR 반환
+static asdfs_errno data_unshare(block_ref *slot) {
+    block_ref old = *slot;
+    if (old == 0) {
+        return NO_ERROR;
+    }
+    if (data_arena_refs[old] == 0 || (data_arena_refs[old] == DEDUP_INDEXED && dedup_remove(old))) {
+        return zip_expand(old);
+    }
+    // 복사본만큼 잔여 블록 예약
+    if (!space_take(1)) {
+        return NO_FREE_SPACE;
+    }
+    block_ref ref = data_arena_take(NULL);
+    if (ref == 0) {
+        space_give(1);
+        return GENERAL_ERROR;
+    }
+    uint64_t desc = data_arena_zip[old];
+    if (desc & ZIP_PACKED) {
+        zip_read(old, desc, data_at(ref), 0, DATA_BLOCK_SIZE);
+    }
+    else {
+        memcpy(data_at(ref), data_at(old), DATA_BLOCK_SIZE);
+    }
+    dirty_range(data_at(ref), DATA_BLOCK_SIZE);
+    *slot = ref;
+    dirty_range(slot, sizeof(block_ref));
+
+    // 그 사이 다른 파일이 원본을 놓아 반환된 경우 예약한 만큼 되돌림
+    if (data_unref(old)) {
+        space_give(1);
+    }
+    return NO_ERROR;
+}
+
+// cold data의 off부터 length 바이트를 0으로 채움 (블록 하나 안의 범위, 할당된 블록만)
+// 공유 중인 블록은 복사한 뒤 채우며, 복사할 블록이 없으면 NO_FREE_SPACE 반환
+static asdfs_errno data_zero(inode_cold *cold, off_t off, size_t length) {
+    block_ref *slot = data_slot(cold, (uint64_t)off / DATA_BLOCK_SIZE, 0);
+    if (slot && *slot) {
+        asdfs_errno code = data_unshare(slot);
+        if (code != NO_ERROR) {
+            return code;
+        }
+        data_touch(*slot);
+        memset(data_at(*slot) + off % DATA_BLOCK_SIZE, 0, length);
+        dirty_range(data_at(*slot) + off % DATA_BLOCK_SIZE, length);
+    }
+    return NO_ERROR;
+}
+
+// cold data를 size 크기로 줄임
+// 마지막 블록의 size 이후 부분은 0으로 채우고 size 이후 블록을 반환
+// 마지막 블록이 공유 중이고 복사할 블록이 없으면 아무것도 바꾸지 않고 NO_FREE_SPACE 반환
+static asdfs_errno data_truncate(inode_cold *cold, off_t size) {
+    uint64_t blocks = (uint64_t)(size / DATA_BLOCK_SIZE) + !!(size % DATA_BLOCK_SIZE);
+
+    // 마지막 블록의 size 이후 부분
+    if (size % DATA_BLOCK_SIZE) {
+        asdfs_errno code = data_zero(cold, size, DATA_BLOCK_SIZE - size % DATA_BLOCK_SIZE);
+        if (code != NO_ERROR) {
+            return code;
+        }
+    }
+
+    // size 이후 블록 반환
+    data_release(cold, blocks, UINT64_MAX);
+    if (cold->data == 0) {
+        cold->dataHeight = 0;
+        return NO_ERROR;
+    }
+
+    // 남은 블록이 낮은 radix tree에 들어가면 높이 감소
+    while (cold->dataHeight > 0 && ((blocks - 1) >> ((cold->dataHeight - 1) * DATA_FANOUT_SHIFT)) == 0) {
+        block_ref node = cold->data;
+        cold->data = ((block_ref *)data_at(node))[0];
+        data_node_free(node);
+        cold->dataHeight--;
+    }
+    return NO_ERROR;
+}
+
+// node의 data 크기 변경
+// 블록은 쓰기 시 할당되므로 늘어난 부분은 블록을 차지하지 않는 hole
+asdfs_errno alloc_data_inode(inode *node, off_t size) {
+    inode_cold *cold = get_cold(node);
+    if (size < 0) {
+        return GENERAL_ERROR;
+    }
+    dirty_range(cold, sizeof(inode_cold));
+
+    // 크기가 줄어드는 경우 이후 블록 반환
+    if (size < cold->size) {
+        asdfs_errno code = data_truncate(cold, size);
+        if (code != NO_ERROR) {
+            return code;
+        }
+    }
+
+    // 새로운 크기 반영
+    cold->size = size;
+    return NO_ERROR;
+}
+
+// node의 data 공간 반환
+void dealloc_data_inode(inode *node) {
+    inode_cold *cold = get_cold(node);
+    dirty_range(cold, sizeof(inode_cold));
+    data_extent_release(node->id);
+
+    // data 블록 반환 후 파일 시스템 잔여 블록 수에 반영
+    data_release(cold, 0, UINT64_MAX);
+    cold->data = 0;
+    cold->dataHeight = 0;
+}
+
+// node 파일을 닫음: 이어 쓰기용으로 예약하고 쓰지 않은 블록 번호 반환
+void release_data_inode(inode *node) {
+    data_extent_release(node->id);
+}
+
+// node data의 index번째 블록 위치 반환, 없으면 블록 할당, 다른 파일과 공유 중이면 복사
+// fill이 0이 아니면 새로 할당한 블록을 0으로 채움
+// 남은 블록이 없으면 NO_FREE_SPACE, 할당 실패 시 GENERAL_ERROR를 code 포인터로 반환
+static void *data_block(inode *node, uint64_t index, int fill, asdfs_errno *code) {
+    inode_cold *cold = get_cold(node);
+    block_ref *slot = data_slot(cold, index, 1);
+    if (slot == NULL) {
+        *code = volume->superblock.f_bfree == 0 ? NO_FREE_SPACE : GENERAL_ERROR;
+        return NULL;
+    }
+    // 호출한 쪽에서 블록에 쓰므로 공유 중이면 복사하고 바뀐 것으로 기록
+    if (*slot != 0) {
+        *code = data_unshare(slot);
+        if (*code != NO_ERROR) {
+            return NULL;
+        }
+        data_touch(*slot);
+        data_own(*slot, node->id);
+        dirty_range(data_at(*slot), DATA_BLOCK_SIZE);
+        return data_at(*slot);
+    }
+
+    // 잔여 블록 예약, 파일 시스템에 남은 블록이 없는 경우
+    if (!space_take(1)) {
+        *code = NO_FREE_SPACE;
+        return NULL;
+    }
+    // 파일 끝에 이어 쓰는 블록은 파일별로 예약한 번호에서 가져옴
+    int append = (off_t)(index * DATA_BLOCK_SIZE) >= cold->size;
+    int zero;
+    block_ref ref = data_extent_take(node->id, index, append, &zero);
+    if (ref == 0) {
+        space_give(1);
+        *code = GENERAL_ERROR;
+        return NULL;
+    }
+    *slot = ref;
+    dirty_range(slot, sizeof(block_ref));
+    data_touch(ref);
+    data_own(ref, node->id);
+
+    // 블록 전체를 바로 덮어쓰지 않는 경우 0으로 채움
+    char *block = data_at(ref);
+    dirty_range(block, DATA_BLOCK_SIZE);
+    // 한 번도 쓰지 않은 블록은 이미 0이므로 채우지 않음 (fallocate로 할당한 블록은 쓸 때까지 메모리를 쓰지 않음)
+    if (fill && !zero) {
+        memset(block, 0, DATA_BLOCK_SIZE);
+    }
+
+    // 할당된 블록 수 반영
+    cold->blocks++;
+    volume->logicalBlocks++;
+    spill_check();
+    return block;
+}
+
+// cold data의 index번째 블록 (블록 전체를 방금 씀)과 같은 내용의 블록이 색인에 있으면 공유하고 쓴 블록은 반환
+// 없으면 쓴 블록을 색인에 추가 (중복 제거를 사용하는 경우만)
+static void data_dedup(inode_cold *cold, uint64_t index) {
+    block_ref *slot = data_slot(cold, index, 0);
+    if (!dedup_enabled || slot == NULL || *slot == 0) {
+        return;
+    }
+    block_ref ref = *slot;
+    const char *block = data_at(ref);
+    uint64_t hash = hash_data(block, DATA_BLOCK_SIZE);
+    uint32_t bucket = dedup_bucket(hash);
+    __sync_fetch_and_add(&dedup_counter.hashed, 1);
+
+    // hash가 같으면 내용까지 비교, 찾은 블록은 lock 안에서 공유 횟수를 늘려 색인에서 빠지지 않게 함
+    pthread_mutex_lock(dedup_lock(bucket));
+    block_ref same = dedup_buckets[bucket];
+    while (same != 0 && (dedup_hashes[same] != hash || memcmp(data_at(same), block, DATA_BLOCK_SIZE) != 0)) {
+        same = dedup_next[same];
+    }
+    if (same != 0) {
+        __sync_fetch_and_add(&data_arena_refs[same], 1);
+    }
+    else if (__sync_bool_compare_and_swap(&data_arena_refs[ref], 0, DEDUP_INDEXED)) {
+        dedup_link(ref, hash);
+    }
+    pthread_mutex_unlock(dedup_lock(bucket));
+
+    // 없으면 쓴 블록이 색인에 남음
+    if (same == 0) {
+        dirty_range(&data_arena_refs[ref], sizeof(uint32_t));
+        return;
+    }
+
+    // 찾은 블록으로 교체하고 쓴 블록 반환
+    dirty_range(&data_arena_refs[same], sizeof(uint32_t));
+    data_disown(same);
+    *slot = same;
+    dirty_range(slot, sizeof(block_ref));
+    if (data_unref(ref)) {
+        space_give(1);
+    }
+    __sync_fetch_and_add(&dedup_counter.hit, 1);
+}
+
+// 없는 level 높이 하위 트리의 lo번째부터 hi번째 전까지 블록을 할당할 때 필요한 블록 수 (데이터 블록과 노드)
+static uint64_t data_absent(int level, uint64_t lo, uint64_t hi) {
+    uint64_t count = hi - lo;
+    for (int l = 1; l <= level; l++) {
+        int shift = l * DATA_FANOUT_SHIFT;
+        count += shift < 64 ? ((hi - 1) >> shift) - (lo >> shift) + 1 : 1;
+    }
+    return count;
+}
+
+// level 높이의 하위 트리 ref (첫 블록 번호 base)에서 lo번째부터 hi번째 전까지 (하위 트리 안의 범위)
+// 없는 블록을 할당할 때 필요한 블록 수 (데이터 블록과 노드)
+static uint64_t data_needed(block_ref ref, int level, uint64_t base, uint64_t lo, uint64_t hi) {
+    if (lo >= hi) {
+        return 0;
+    }
+    if (ref == 0) {
+        return data_absent(level, lo, hi);
+    }
+    if (level == 0) {
+        return 0;
+    }
+    block_ref *node = (block_ref *)data_at(ref);
+    uint64_t child_span = (uint64_t)1 << ((level - 1) * DATA_FANOUT_SHIFT);
+    uint64_t count = 0;
+    for (uint64_t i = (lo - base) / child_span; i <= (hi - 1 - base) / child_span; i++) {
+        uint64_t child = base + i * child_span;
+        count += data_needed(node[i], level - 1, child, lo > child ? lo : child,
+                             hi < child + child_span ? hi : child + child_span);
+    }
+    return count;
+}
+
+// cold data의 first번째부터 end번째 전까지 없는 블록을 할당할 때 필요한 블록 수
+// 없는 데이터 블록과 그 위치까지 새로 만들어야 하는 radix tree 노드 (높이 증가 포함)
+static uint64_t data_required(inode_cold *cold, uint64_t first, uint64_t end) {
+    int height = cold->dataHeight;
+    while (height * DATA_FANOUT_SHIFT < 64 && ((end - 1) >> (height * DATA_FANOUT_SHIFT)) != 0) {
+        height++;
+    }
+    if (cold->data == 0) {
+        return data_absent(height, first, end);
+    }
+
+    // 높이가 늘어나면 기존 root 위에 높이마다 노드가 추가되고, 추가된 노드의 첫 자식 밖은 비어 있음
+    uint64_t count = 0;
+    for (int level = height; level > cold->dataHeight; level--) {
+        uint64_t span = (uint64_t)1 << ((level - 1) * DATA_FANOUT_SHIFT);
+        count++;
+        if (end > span) {
+            count += data_absent(level - 1, first > span ? first : span, end);
+            end = span;
+        }
+        if (first >= end) {
+            return count;
+        }
+    }
+    return count + data_needed(cold->data, cold->dataHeight, 0, first, end);
+}
+
+// node data의 off부터 length 바이트 범위의 블록을 0으로 채워 할당, 파일 크기는 유지
+asdfs_errno fill_data_inode(inode *node, off_t off, off_t length) {
+    inode_cold *cold = get_cold(node);
+    if (off < 0 || length <= 0) {
+        return GENERAL_ERROR;
+    }
+    dirty_range(cold, sizeof(inode_cold));
+
+    // 없는 블록과 노드를 할당하는 데 필요한 블록 수가 남은 블록 수보다 많으면 할당하지 않음
+    uint64_t first = (uint64_t)off / DATA_BLOCK_SIZE;
+    uint64_t end = ((uint64_t)off + length + DATA_BLOCK_SIZE - 1) / DATA_BLOCK_SIZE;
+    if (data_required(cold, first, end) > volume->superblock.f_bfree) {
+        return NO_FREE_SPACE;
+    }
+
+    // 이미 있는 블록은 그대로 (공유 중인 블록도 복사하지 않음)
+    asdfs_errno code = NO_ERROR;
+    for (uint64_t index = first; index < end; index++) {
+        block_ref *slot = data_slot(cold, index, 0);
+        if ((slot == NULL || *slot == 0) && data_block(node, index, 1, &code) == NULL) {
+            return code;
+        }
+    }
+    return NO_ERROR;
+}
+
+// node data의 off부터 length 바이트 범위를 hole로 변경, 파일 크기는 유지
+// 범위에 모두 포함된 블록은 반환하고, 일부만 포함된 블록은 해당 부분을 0으로 채움
+asdfs_errno punch_data_inode(inode *node, off_t off, off_t length) {
+    inode_cold *cold = get_cold(node);
+    if (off < 0 || length <= 0) {
+        return GENERAL_ERROR;
+    }
+    dirty_range(cold, sizeof(inode_cold));
+
+    uint64_t start = (uint64_t)off;
+    uint64_t stop = (uint64_t)off + length;
+    uint64_t first = (start + DATA_BLOCK_SIZE - 1) / DATA_BLOCK_SIZE; // 범위에 모두 포함된 첫 블록
+    uint64_t end = stop / DATA_BLOCK_SIZE;                            // 범위에 모두 포함된 마지막 블록 다음
+
+    // 범위가 블록 하나 안인 경우
+    if (first > end) {
+        return data_zero(cold, off, (size_t)length);
+    }
+
+    // 앞뒤 일부만 포함된 블록
+    asdfs_errno code = NO_ERROR;
+    if (start % DATA_BLOCK_SIZE) {
+        code = data_zero(cold, off, (size_t)(first * DATA_BLOCK_SIZE - start));
+    }
+    if (code == NO_ERROR && stop % DATA_BLOCK_SIZE) {
+        code = data_zero(cold, (off_t)(end * DATA_BLOCK_SIZE), (size_t)(stop % DATA_BLOCK_SIZE));
+    }
+    if (code != NO_ERROR) {
+        return code;
+    }
+
+    // 모두 포함된 블록 반환
+    data_release(cold, first, end);
+    if (cold->data == 0) {
+        cold->dataHeight = 0;
+    }
+    return NO_ERROR;
+}
+
+// src data의 src_off부터 length 바이트의 블록을 dst data의 dst_off 위치에서 공유 (내용은 복사하지 않음)
+// 위치와 길이는 블록 단위, 공유한 블록은 어느 한쪽이 쓸 때 복사 (data_unshare)
+// src의 hole은 dst에서도 hole, dst의 기존 블록은 반환, 범위가 dst 크기를 넘으면 크기 증가
+// radix tree 노드를 할당할 블록이 없으면 NO_FREE_SPACE 반환 (그 전까지 공유한 블록은 유지)
+asdfs_errno clone_data_inode(inode *dst, off_t dst_off, inode *src, off_t src_off, off_t length) {
+    inode_cold *from = get_cold(src);
+    inode_cold *to = get_cold(dst);
+    if (dst_off < 0 || src_off < 0 || length < 0) {
+        return GENERAL_ERROR;
+    }
+    dirty_range(to, sizeof(inode_cold));
+
+    uint64_t first = (uint64_t)src_off / DATA_BLOCK_SIZE;
+    uint64_t target = (uint64_t)dst_off / DATA_BLOCK_SIZE;
+    uint64_t count = ((uint64_t)length + DATA_BLOCK_SIZE - 1) / DATA_BLOCK_SIZE;
+    asdfs_errno code = NO_ERROR;
+    for (uint64_t i=0; i<count; i++) {
+        // src의 hole은 dst의 블록 반환
+        block_ref *slot = data_slot(from, first + i, 0);
+        block_ref ref = slot ? *slot : 0;
+        if (ref == 0) {
+            data_release(to, target + i, target + i + 1);
+            continue;
+        }
+
+        // dst 위치에 src 블록 번호 기록 후 공유 횟수 증가
+        block_ref *place = data_slot(to, target + i, 1);
+        if (place == NULL) {
+            code = volume->superblock.f_bfree == 0 ? NO_FREE_SPACE : GENERAL_ERROR;
+            break;
+        }
+        if (*place == ref) {
+            continue;
+        }
+        __sync_fetch_and_add(&data_arena_refs[ref], 1);
+        dirty_range(&data_arena_refs[ref], sizeof(uint32_t));
+        data_disown(ref);
+        block_ref old = *place;
+        *place = ref;
+        dirty_range(place, sizeof(block_ref));
+
+        // dst의 기존 블록은 반환, 없던 위치면 파일의 블록 수 증가
+        if (old == 0) {
+            to->blocks++;
+            volume->logicalBlocks++;
+        }
+        else if (data_unref(old)) {
+            space_give(1);
+        }
+    }
+    if (to->data == 0) {
+        to->dataHeight = 0;
+    }
+
+    // 공유한 부분이 파일 크기를 넘으면 크기 증가
+    if (code == NO_ERROR && dst_off + length > to->size) {
+        to->size = dst_off + length;
+    }
+    return code;
+}
+
+// node data의 off부터 최대 size 바이트를 가리키는 iovec을 최대 count개 iov에 기록, 기록한 개수 반환
+// 압축된 블록은 가리킬 메모리가 없으므로 그 앞에서 멈춤
+int map_data_inode(inode *node, off_t off, size_t size, struct iovec *iov, int count) {
+    inode_cold *cold = get_cold(node);
+
+    // 파일 크기를 넘는 부분은 제외
+    if (off < 0 || off >= cold->size) {
+        return 0;
+    }
+    if ((off_t)size > cold->size - off) {
+        size = (size_t)(cold->size - off);
+    }
+
+    int used = 0;
+    size_t done = 0;
+    while (done < size && used < count) {
+        uint64_t pos = (uint64_t)off + done;
+        size_t inner = (size_t)(pos % DATA_BLOCK_SIZE);
+        size_t length = DATA_BLOCK_SIZE - inner;
+        if (length > size - done) {
+            length = size - done;
+        }
+
+        // 할당되지 않은 블록은 0으로 채워진 블록
+        block_ref *slot = data_slot(cold, pos / DATA_BLOCK_SIZE, 0);
+        block_ref ref = slot ? *slot : 0;
+        if (ref != 0 && (data_arena_zip[ref] & ZIP_PACKED)) {
+            break;
+        }
+        if (ref != 0) {
+            data_touch(ref);
+        }
+        const char *block = ref ? data_at(ref) : zero_block;
+
+        // 블록 영역에서 바로 이어지는 블록은 앞의 iovec에 합침
+        if (used > 0 && (const char *)iov[used - 1].iov_base + iov[used - 1].iov_len == block + inner && block != zero_block) {
+            iov[used - 1].iov_len += length;
+        }
+        else {
+            iov[used].iov_base = (void *)(block + inner);
+            iov[used].iov_len = length;
+            used++;
+        }
+        done += length;
+    }
+    return used;
+}
+
+// node data의 off부터 최대 size 바이트를 가리키는 fuse_buf를 최대 count개 bufs에 기록, 기록한 개수 반환
+// 블록 영역에 fd가 있으면 블록은 (fd, 위치)로, 없으면 메모리 주소로 가리킴
+// 할당되지 않은 블록은 0으로 채워진 블록의 메모리 주소를 가리킴
+int map_buf_data_inode(inode *node, off_t off, size_t size, struct fuse_buf *bufs, int count) {
+    struct iovec iov[16];
+    size_t done = 0;
+    int used = 0;
+
+    // 블록 위치를 16개씩 확인하여 fuse_buf로 변환
+    while (used < count) {
+        int mapped = map_data_inode(node, off + done, size - done, iov, count - used < 16 ? count - used : 16);
+        if (mapped == 0) {
+            break;
+        }
+        for (int i=0; i<mapped; i++) {
+            struct fuse_buf *buf = &bufs[used++];
+            memset(buf, 0, sizeof(*buf));
+            buf->size = iov[i].iov_len;
+            char *base = (char *)iov[i].iov_base;
+            if (data_arena_fd >= 0 && base >= data_arena && base < data_at(data_arena_max() + 1)) {
+                buf->flags = FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK;
+                buf->fd = data_arena_fd;
+                buf->pos = data_arena_pos + (off_t)(base - data_arena);
+            }
+            else {
+                buf->mem = iov[i].iov_base;
+                buf->fd = -1;
+            }
+            done += iov[i].iov_len;
+        }
+    }
+    return used;
+}
+
+// node의 데이터 블록을 이미지 파일에 기록
+// checkpoint를 사용하면 node 블록을 포함해 바뀐 page 전체를 checkpoint
+// 이미지 파일을 쓰지 않으면 아무것도 하지 않음
+asdfs_errno sync_data_inode(inode *node) {
+    if (volume_image == NULL) {
+        return NO_ERROR;
+    }
+    if (checkpoint_interval) {
+        return checkpoint_volume();
     }
 
-    // supplementary groups 확인
-    gid_t list[512];
-    int length = fuse_getgroups(512, list);
-    for (int i=0; i<length && i<512; i++) {
-        uid_t supp_gid = list[i];
+    // 블록 영역에서 이어지는 블록끼리 모아서 msync
+    off_t size = get_cold(node)->size;
+    off_t done = 0;
+    struct iovec iov[16];
+    while (done < size) {
+        int used = map_data_inode(node, done, (size_t)(size - done), iov, 16);
+        for (int i=0; i<used; i++) {
+            char *base = (char *)iov[i].iov_base;
+            if (base >= data_arena && base < data_at(data_arena_max() + 1)) {
+                // msync 주소는 page 경계여야 함
+                char *start = base - (size_t)(base - volume_image) % DATA_BLOCK_SIZE;
+                if (msync(start, iov[i].iov_len + (size_t)(base - start), MS_SYNC) != 0) {
+                    fprintf(stderr, "asdfs_sync_data_inode: %s\n", strerror(errno));
+                    return GENERAL_ERROR;
+                }
+            }
+            done += (off_t)iov[i].iov_len;
+        }
 
-        // owner는 아니지만 supplementary group에 속하고,
-        // 파일에 group WRITE 권한이 있는 경우
-        if ((supp_gid == file_gid) && (file_mode & S_IWGRP)) {
-            return 1;
+        // 압축된 블록은 pack 블록을 msync
+        if (used == 0) {
+            block_ref *slot = data_slot(get_cold(node), (uint64_t)done / DATA_BLOCK_SIZE, 0);
+            uint64_t desc = (slot && *slot) ? data_arena_zip[*slot] : 0;
+            if ((desc & ZIP_PACKED) && msync(data_at(zip_pack_of(desc)), DATA_BLOCK_SIZE, MS_SYNC) != 0) {
+                fprintf(stderr, "asdfs_sync_data_inode: %s\n", strerror(errno));
+                return GENERAL_ERROR;
+            }
+            done = (done / DATA_BLOCK_SIZE + 1) * DATA_BLOCK_SIZE;
         }
     }
+    return NO_ERROR;
+}
 
-    // others이고, 파일에 others WRITE 권한이 있는 경우
-    if (file_mode & S_IWOTH) {
-        return 1;
+// cold data의 pos 위치부터 블록 끝까지 최대 size 바이트를 mem으로 복사, 복사한 바이트 수 반환
+// 압축된 블록은 압축을 푼 블록 cache에서 복사, 파일 크기를 넘는 부분은 읽지 않음
+static size_t data_read_block(inode_cold *cold, uint64_t pos, char *mem, size_t size) {
+    if (pos >= (uint64_t)cold->size) {
+        return 0;
+    }
+    size_t inner = (size_t)(pos % DATA_BLOCK_SIZE);
+    size_t length = DATA_BLOCK_SIZE - inner;
+    if (length > size) {
+        length = size;
+    }
+    if (length > (uint64_t)cold->size - pos) {
+        length = (size_t)((uint64_t)cold->size - pos);
     }
 
-    return 0;
+    block_ref *slot = data_slot(cold, pos / DATA_BLOCK_SIZE, 0);
+    block_ref ref = slot ? *slot : 0;
+    uint64_t desc = ref ? data_arena_zip[ref] : 0;
+    if (desc & ZIP_PACKED) {
+        zip_read(ref, desc, mem, inner, length);
+    }
+    else {
+        memcpy(mem, (ref ? data_at(ref) : zero_block) + inner, length);
+    }
+    return length;
 }
 
-// 호출 프로세스가 해당 inode에 실행/탐색 권한이 있는지 확인
-int can_execute(inode *node) {
-    // 현재 fuse context, 호출 프로세스의 uid, gid.
-    struct fuse_context *context = fuse_get_context();
-    uid_t curr_uid = context->uid;
-    uid_t curr_gid = context->gid;
-
-    // node의 파일 권한, 소유자 uid, 그룹 gid.
-    mode_t file_mode = node->attr.st_mode;
-    uid_t file_uid = node->attr.st_uid;
-    uid_t file_gid = node->attr.st_gid;
+// node data의 off부터 최대 size 바이트를 mem으로 복사, 복사한 바이트 수 반환
+size_t read_data_inode(inode *node, char *mem, size_t size, off_t off) {
+    size_t done = 0;
+    struct iovec iov[16];
 
-    // owner이고, 파일에 owner EXECUTE 권한이 있는 경우
-    if (((curr_uid == file_uid) && (file_mode & S_IXUSR))
-        // owner는 아니지만 group에 속하고, 파일에 group EXECUTE 권한이 있는 경우
-        || ((curr_gid == file_gid) && (file_mode & S_IXGRP)) ) {
-        return 1;
+    // 블록 16개씩 위치를 확인하여 복사, 압축된 블록은 하나씩 압축을 풀어서 복사
+    for (;;) {
+        int used = map_data_inode(node, off + done, size - done, iov, 16);
+        for (int i=0; i<used; i++) {
+            copy_data(mem + done, iov[i].iov_base, iov[i].iov_len, 0);
+            done += iov[i].iov_len;
+        }
+        if (used == 0) {
+            size_t length = data_read_block(get_cold(node), (uint64_t)off + done, mem + done, size - done);
+            if (length == 0) {
+                break;
+            }
+            done += length;
+        }
     }
+    return done;
+}
 
-    // supplementary groups 확인
-    gid_t list[512];
-    int length = fuse_getgroups(512, list);
-    for (int i=0; i<length && i<512; i++) {
-        uid_t supp_gid = list[i];
+// node data의 off부터 mem의 size 바이트 쓰기, 파일 크기를 넘으면 크기 증가
+asdfs_errno write_data_inode(inode *node, const char *mem, size_t size, off_t off, size_t *written) {
+    inode_cold *cold = get_cold(node);
+    asdfs_errno code = NO_ERROR;
+    dirty_range(cold, sizeof(inode_cold));
 
-        // owner는 아니지만 supplementary group에 속하고,
-        // 파일에 group EXECUTE 권한이 있는 경우
-        if ((supp_gid == file_gid) && (file_mode & S_IXGRP)) {
-            return 1;
+    size_t done = 0;
+    while (done < size) {
+        uint64_t pos = (uint64_t)off + done;
+        size_t inner = (size_t)(pos % DATA_BLOCK_SIZE);
+        size_t length = DATA_BLOCK_SIZE - inner;
+        if (length > size - done) {
+            length = size - done;
         }
-    }
 
-    // others이고, 파일에 others EXECUTE 권한이 있는 경우
-    if (file_mode & S_IXOTH) {
-        return 1;
+        // 처음 쓰는 블록 할당, 블록 전체를 쓰지 않으면 나머지는 0으로 채움
+        char *block = (char *)data_block(node, pos / DATA_BLOCK_SIZE, length < DATA_BLOCK_SIZE, &code);
+        if (block == NULL) {
+            break;
+        }
+
+        // 큰 쓰기 요청은 cache를 거치지 않고 저장 (중복 제거는 바로 다시 읽으므로 cache를 거침)
+        copy_data(block + inner, mem + done, length, size >= COPY_STREAM_MIN && !dedup_enabled);
+        if (length == DATA_BLOCK_SIZE) {
+            data_dedup(cold, pos / DATA_BLOCK_SIZE);
+        }
+        done += length;
     }
 
-    return 0;
+    // 쓴 부분이 파일 크기를 넘으면 크기 증가
+    if (done > 0 && off + (off_t)done > cold->size) {
+        cold->size = off + done;
+    }
+    *written = done;
+    return code;
 }
 
-// parent의 firstChild부터 lastChild까지 검색하여
-// search_name의 위치 정보 또는 search_name이 들어갈 위치 정보를
-// search_result에 기록하여 res 포인터로 반환
-asdfs_errno child_search(inode *parent, const char *search_name, search_result *res){
-    if (parent == NULL || search_name == NULL || res == NULL) {
-        return GENERAL_ERROR;
-    }
-    
-    res->parent = parent;
-    
-    // parent에 child가 없는 경우
-    inode *firstChild = parent->firstChild;
-    if(parent->firstChild==NULL){
-        // 위치 정보 반환
-        res->left=NULL;
-        res->exact=NULL;
-        res->right=NULL;
-        
-        // 주어진 위치에 inode 없음
-        return EXACT_NOT_FOUND;
-    }
-    
-    // firstChild보다 ABC순으로 앞에 위치하는 경우
-    if (strcmp(search_name,firstChild->name)<0) {
-        // 위치 정보 반환
-        res->left = NULL;
-        res->exact = NULL;
-        res->right = firstChild;
+// node data의 off부터 buf의 내용 쓰기, 파일 크기를 넘으면 크기 증가, 쓴 바이트 수는 written 포인터로 반환
+// buf가 pipe인 경우 (splice) 중간 버퍼 없이 블록으로 바로 읽어옴
+asdfs_errno write_buf_data_inode(inode *node, struct fuse_bufvec *buf, off_t off, size_t *written) {
+    inode_cold *cold = get_cold(node);
+    asdfs_errno code = NO_ERROR;
+    size_t size = fuse_buf_size(buf);
+    dirty_range(cold, sizeof(inode_cold));
 
-        // 주어진 위치에 inode 없음
-        return EXACT_NOT_FOUND;
+    // 메모리 버퍼 하나인 경우 write_data_inode와 같음
+    if (buf->count == 1 && !(buf->buf[0].flags & FUSE_BUF_IS_FD)) {
+        return write_data_inode(node, (const char *)buf->buf[0].mem + buf->off, size, off, written);
     }
 
+    size_t done = 0;
+    while (done < size) {
+        uint64_t pos = (uint64_t)off + done;
+        size_t inner = (size_t)(pos % DATA_BLOCK_SIZE);
+        size_t length = DATA_BLOCK_SIZE - inner;
+        if (length > size - done) {
+            length = size - done;
+        }
 
-    // lastChild보다 ABC순으로 뒤에 위치하는 경우
-    inode *lastChild = parent->lastChild;
-    if (strcmp(search_name,lastChild->name)>0) {
-        // 위치 정보 반환
-        res->left = lastChild;
-        res->exact = NULL;
-        res->right = NULL;
+        // 처음 쓰는 블록 할당, 블록 전체를 쓰지 않으면 나머지는 0으로 채움
+        blkcnt_t blocks = cold->blocks;
+        char *block = (char *)data_block(node, pos / DATA_BLOCK_SIZE, length < DATA_BLOCK_SIZE, &code);
+        if (block == NULL) {
+            break;
+        }
 
-        // 주어진 위치에 inode 없음
-        return EXACT_NOT_FOUND;
-    }
-    
-    // firstChild부터 ABC순으로
-    // 직전에 위치하지 않는 child inode가 나올 때까지 반복
-    inode *child = firstChild;
-    while (strcmp(search_name,child->name)>0) {
-        child = child->rightSibling;
+        // buf에서 블록으로 복사, buf의 현재 위치는 fuse_buf_copy가 이동
+        struct fuse_bufvec dst = FUSE_BUFVEC_INIT(length);
+        dst.buf[0].mem = block + inner;
+        ssize_t copied = fuse_buf_copy(&dst, buf, 0);
+        if (copied < (ssize_t)length) {
+            if (copied < 0) {
+                copied = 0;
+            }
+            // 새로 할당한 블록 중 채우지 못한 부분은 0으로 채움
+            if (cold->blocks != blocks) {
+                memset(block + inner + copied, 0, length - copied);
+            }
+            done += copied;
+            code = GENERAL_ERROR;
+            break;
+        }
+        if (length == DATA_BLOCK_SIZE) {
+            data_dedup(cold, pos / DATA_BLOCK_SIZE);
+        }
+        done += length;
     }
-    
-    // child가 search_name과 같은 경우
-    if (strcmp(search_name,child->name)==0) {
-        // 위치 정보 반환
-        res->left = child->leftSibling;
-        res->exact = child;
-        res->right = child->rightSibling;
 
-        // 주어진 위치에 inode 있음
-        return EXACT_FOUND;
+    // 쓴 부분이 파일 크기를 넘으면 크기 증가
+    if (done > 0 && off + (off_t)done > cold->size) {
+        cold->size = off + done;
     }
-    // 같지 않은 경우
-    else {
-        // 위치 정보 반환
-        res->left = child->leftSibling;
-        res->exact = NULL;
-        res->right = child;
+    *written = done;
+    return code;
+}
 
-        // 주어진 위치에 inode 없음
-        return EXACT_NOT_FOUND;
+// 압축한 블록 ref의 블록 메모리를 OS에 반환
+// memfd (또는 spill 파일) 블록 영역은 공유 mapping이라 MADV_DONTNEED로는 page가 남으므로 파일의 해당 부분을 비움
+static void zip_release_block(block_ref ref) {
+#ifdef MADV_REMOVE
+    if (volume_image == NULL && data_arena_fd >= 0 && madvise(data_at(ref), DATA_BLOCK_SIZE, MADV_REMOVE) == 0) {
+        return;
     }
+#endif
+    release_pages(data_at(ref), DATA_BLOCK_SIZE);
 }
 
-// 파일 시스템 root inode, superblock 초기화
-void init_root_superblock() {
-    // 현재 fuse context 가져오기. 호출 프로세스의 uid, gid.
-    struct fuse_context *context = fuse_get_context();
-
-    // 현재 시간 가져오기
-    struct timespec now;
-    clock_gettime(CLOCK_REALTIME, &now);
-
-    // root inode 초기화
-    strncpy(root.name, "ROOT", MAX_FILENAME);
-    root.attr.st_mode  = S_IFDIR | (0777 & ~(context->umask)); // 파일 모드
-    root.attr.st_nlink = 1;              // 파일 링크 개수
-    root.attr.st_uid   = context->uid;   // 
-    root.attr.st_gid   = context->gid;   //
-    root.attr.st_atime = now.tv_sec;     // 파일 최근 사용 시간
-    root.attr.st_mtime = now.tv_sec;     // 파일 최근 수정 시간
-    root.attr.st_ctime = now.tv_sec;     // 파일 최근 상태 변화 시간
-    // 나머지 값은 static이므로 전부 0.
-    
-    // superblock 초기화
-    
-    // f_bsize: 파일 시스템 블록 크기
-    unsigned long f_bsize = BLOCK_SIZE_KB * 1024; // 4096
-    
-    // f_blocks: 파일 시스템 내 전체 블록 개수
-    fsblkcnt_t f_blocks = VOLUME_SIZE_MB * 1024 / BLOCK_SIZE_KB; // 25600
-    
-    // f_favail: 사용 가능한 파일 시리얼 넘버 (inode) 개수
-    fsfilcnt_t f_favail = (fsfilcnt_t)(f_blocks * (f_bsize / INODE_SIZE_BYTE)); // 204800
+// 채워 넣는 중인 pack에 압축된 내용 data의 size 바이트를 저장하고 압축 상태 반환, 블록이 없으면 0 (cut 안에서 호출)
+// 자리가 모자라면 새로운 pack 블록 할당
+static uint64_t zip_store(const char *data, uint32_t size) {
+    if (volume->zipPack == 0 || volume->zipPackUsed + size > DATA_BLOCK_SIZE) {
+        if (!space_take(1)) {
+            return 0;
+        }
+        block_ref pack = data_arena_take(NULL);
+        if (pack == 0) {
+            space_give(1);
+            return 0;
+        }
+        block_ref old = volume->zipPack;
+        volume->zipPack = pack;
+        volume->zipPackUsed = 0;
+        data_arena_zip[pack] = ZIP_PACK;
+        dirty_range(&data_arena_zip[pack], sizeof(uint64_t));
+        __sync_fetch_and_add(&zip_counter.packs, 1);
 
-    superblock.f_bsize   = f_bsize;      // 파일 시스템 블록 크기
-    superblock.f_blocks  = f_blocks;     // 파일 시스템 내 전체 블록 개수
-    superblock.f_bfree   = f_blocks - 1; // 사용 가능한 블록 수, root만큼 제외
-    superblock.f_bavail  = f_blocks - 1; // 일반 권한 프로세스가 사용 가능한 블록 수, root만큼 제외
-    superblock.f_files   = 0;            // 전체 파일 시리얼 넘버 (inode) 개수
-    superblock.f_favail  = f_favail - 1; // 사용 가능한 파일 시리얼 넘버 (inode) 개수, root만큼 제외
-    superblock.f_namemax = MAX_FILENAME; // 최대 파일 이름 길이
-    // 나머지 값은 static이므로 전부 0.
+        // 채우는 동안 모두 빠진 이전 pack 반환
+        if (old != 0 && (uint32_t)data_arena_zip[old] == 0) {
+            zip_pack_retire(old);
+        }
+    }
+    block_ref pack = volume->zipPack;
+    uint32_t offset = volume->zipPackUsed;
+    memcpy(data_at(pack) + offset, data, size);
+    dirty_range(data_at(pack) + offset, size);
+    volume->zipPackUsed += size;
+    data_arena_zip[pack] += size;
+    dirty_range(&data_arena_zip[pack], sizeof(uint64_t));
+    return ZIP_PACKED | ((uint64_t)size << 48) | ((uint64_t)offset << 32) | pack;
 }
 
-// 파일 시스템 superblock 정보 반환
-struct statvfs get_superblock() {
-	return superblock;
-}
+// cut 밖에서 압축한 블록 ref (압축할 당시 마지막 사용 시간 touch)를 pack에 저장, 저장하면 1 반환 (cut 안에서 호출)
+// 압축하는 동안 블록을 읽거나 썼거나 (touch가 바뀜) 다른 위치가 공유하면 버림
+static int zip_commit(block_ref ref, uint32_t touch, const char *data, uint32_t size) {
+    if (data_arena_touch[ref] != touch || data_arena_owner[ref] == 0 || data_arena_zip[ref] != 0) {
+        return 0;
+    }
+    uint32_t refs = data_arena_refs[ref];
+    if (refs != 0 && !(refs == DEDUP_INDEXED && dedup_remove(ref))) {
+        return 0;
+    }
 
-// path에 해당하는 inode 검색, 결과 res 포인터로 반환
-asdfs_errno find_inode(const char *path, search_result *res) {
-    if (res == NULL) {
-        return GENERAL_ERROR;
+    // 압축할 때마다 번호를 쓰지 않고 잔여 블록이 늘어나므로, 남은 블록 번호가 잔여 블록 수보다 많을 때만 압축
+    uint64_t spare = (uint64_t)data_arena_max() - (volume->dataNext - 1) + volume->dataFreeCount;
+    if (spare <= (uint64_t)volume->superblock.f_bfree + 1) {
+        return 0;
+    }
+    uint64_t desc = zip_store(data, size);
+    if (desc == 0) {
+        return 0;
     }
 
-    // res 초기화
-    res->parent = NULL;
-    res->left = NULL;
-    res->exact = NULL;
-    res->right = NULL;
-    
-    // root를 찾는 경우
-    if (strcmp(path, "/")==0) {
-        // 위치 정보 반환
-        res->exact = &root;
+    // pack에 기록한 뒤 압축 상태를 바꿔야 읽기 요청이 기록 전의 pack을 읽지 않음
+    __sync_synchronize();
+    data_arena_zip[ref] = desc;
+    dirty_range(&data_arena_zip[ref], sizeof(uint64_t));
+    zip_credit(ref, desc, 1);
+    space_give(1);
+    __sync_fetch_and_add(&zip_counter.blocks, 1);
+    __sync_fetch_and_add(&zip_counter.bytes, size);
+    spill_forget(ref);
 
-        // 주요 오류 번호 및 비트 마스크 반환
-        asdfs_errno return_code = EXACT_FOUND;
-        return_code |= can_read(&root) ? CAN_READ_EXACT : 0;
-        return_code |= can_write(&root) ? CAN_WRITE_PARENT : 0;
-        return_code |= can_execute(&root) ? CAN_EXECUTE_EXACT : 0;
-        return return_code;
-    }
-    
-    // parent는 root에서 시작
-    inode *parent = &root;
-    asdfs_errno return_code = NO_ERROR;
+    // 블록 메모리는 읽기 요청이 아직 가리킬 수 있으므로 다음 주기에 반환
+    zip_pending[zip_pending_count] = ref;
+    zip_pending_desc[zip_pending_count] = desc;
+    zip_pending_count++;
+    return 1;
+}
 
-    // 문자열 path를 tok_path로 복사
-    unsigned long length = strlen(path);
-    char *tok_path = (char *)malloc(strlen(path) + 1);
-    if (tok_path == NULL) {
-        return GENERAL_ERROR;
+// 대부분 비어 있는 pack의 압축된 블록 ref (압축 상태 desc)를 채워 넣는 중인 pack으로 옮김, 옮기면 1 반환 (cut 안에서 호출)
+// 이전 pack은 읽기 요청이 아직 가리킬 수 있으므로 모두 비어도 두 주기 뒤에 반환
+static int zip_move(block_ref ref, uint64_t desc) {
+    if (data_arena_zip[ref] != desc || zip_pack_of(desc) == volume->zipPack) {
+        return 0;
+    }
+    uint64_t moved = zip_store(zip_data(desc), zip_size(desc));
+    if (moved == 0) {
+        return 0;
     }
-    strncpy(tok_path, path, length + 1);
+    __sync_synchronize();
+    data_arena_zip[ref] = moved;
+    dirty_range(&data_arena_zip[ref], sizeof(uint64_t));
+    zip_cache_drop(ref);
+    __sync_fetch_and_add(&zip_counter.moved, 1);
+    zip_pack_drop(zip_pack_of(desc), zip_size(desc));
+    return 1;
+}
 
-    // strtok을 사용하여 "/" 단위로 가져온 첫번째 path component
-    char * curr_comp = strtok(tok_path, "/");    
-    while (curr_comp != NULL) {
-        // parent가 디렉터리가 아닌 경우 탐색 불가
-        if (!(parent->attr.st_mode & S_IFDIR)) {
-            // tree path 중간에 디렉터리가 아닌 inode 있음
-            return HEAD_NOT_DIRECTORY;
-        }
+// 이전 주기에 압축한 블록의 메모리와 두 주기 전에 비워진 pack 반환 (ZIP_BATCH개씩 cut 안에서)
+static void zip_reclaim() {
+    unsigned done = 0;
+    do {
+        pthread_mutex_lock(&checkpoint_run_lock);
+        volume_cut();
+        if (done == 0) {
+            pthread_mutex_lock(&zip_lock);
+            block_ref pack = zip_retired;
+            zip_retired = zip_retiring;
+            zip_retiring = 0;
+            pthread_mutex_unlock(&zip_lock);
+            while (pack != 0) {
+                block_ref next = (block_ref)data_arena_zip[pack];
+                data_arena_zip[pack] = 0;
+                dirty_range(&data_arena_zip[pack], sizeof(uint64_t));
+                data_arena_put(pack);
+                pack = next;
+            }
 
-        // superuser가 아닌 사용자면서 상위 폴더에 EXECUTE 권한이 없을 경우 탐색 불가
-        if (!is_root() && !can_execute(parent)) {
-            // tree path 탐색 권한 없음
-            return HEAD_NO_PERMISSION;
+            // 채워 넣는 중인 pack도 모두 비었으면 반환
+            if (volume->zipPack != 0 && (uint32_t)data_arena_zip[volume->zipPack] == 0) {
+                zip_pack_retire(volume->zipPack);
+                volume->zipPack = 0;
+                volume->zipPackUsed = 0;
+            }
         }
-        
-        // parent 아래에 curr_comp에 해당하는 inode가 있는지 검색
-        return_code = child_search(parent, curr_comp, res);
 
-        // 다음 처리할 path component
-        char *next_comp = strtok(NULL, "/");
-        
-        // curr_comp inode가 있었을 경우,
-        if (return_code == EXACT_FOUND) {
-            // parent를 exact로 교체
-            parent = res->exact;
-        }
-        // curr_comp inode가 없었으나 다음 처리할 path component가 남은 경우
-        else if (next_comp != NULL) {
-            free(tok_path);
-            // 주어진 위치로의 tree path 없음
-            return HEAD_NOT_FOUND;
+        // 그 사이 압축을 풀었거나 반환한 블록은 제외
+        for (unsigned n=0; n<ZIP_BATCH && done<zip_pending_count; n++, done++) {
+            if (data_arena_zip[zip_pending[done]] == zip_pending_desc[done]) {
+                zip_release_block(zip_pending[done]);
+            }
         }
+        volume_resume();
+        pthread_mutex_unlock(&checkpoint_run_lock);
+    } while (done < zip_pending_count);
+    zip_pending_count = 0;
+}
 
-        // next_comp로 진행
-        curr_comp = next_comp;
-    }
+// 압축 주기 한 번: zip_interval초 동안 읽거나 쓰지 않은 블록을 찾아 압축, 대부분 비어 있는 pack의 블록은 옮김
+// 압축은 변경 요청과 함께 cut 밖에서 하고, ZIP_BATCH개씩 cut 안에서 확인한 뒤 반영
+// out은 압축한 내용을 담을 ZIP_BATCH * ZIP_MAX_SIZE 바이트 버퍼
+static void zip_pass(char *out) {
+    zip_reclaim();
 
-    free(tok_path);
+    uint32_t now = zip_now;
+    unsigned compressed = 0;
+    unsigned moved = 0;
+    unsigned total = 0;
+    block_ref ref = 1;
+    while (ref < volume->dataNext && total < ZIP_PASS_BLOCKS) {
+        block_ref refs[ZIP_BATCH];
+        uint32_t touch[ZIP_BATCH];
+        uint32_t sizes[ZIP_BATCH];
+        uint64_t descs[ZIP_BATCH];
+        unsigned count = 0;
+        for (; ref < volume->dataNext && count < ZIP_BATCH && total + count < ZIP_PASS_BLOCKS; ref++) {
+            uint64_t desc = data_arena_zip[ref];
+            uint32_t shared = data_arena_refs[ref];
 
-    // parent를 찾은 경우 해당하는 보조 비트 마스크 적용
-    if (res->parent) {
-        return_code |= can_read(res->parent) ? CAN_READ_PARENT : 0;
-        return_code |= can_write(res->parent) ? CAN_WRITE_PARENT : 0;
-        return_code |= can_execute(res->parent) ? CAN_EXECUTE_PARENT : 0;
-    }
+            // 대부분 비어 있는 pack (사용 중인 크기가 1/4 이하)의 블록
+            if (desc & ZIP_PACKED) {
+                block_ref pack = zip_pack_of(desc);
+                if (pack != volume->zipPack && (uint32_t)data_arena_zip[pack] * 4 <= DATA_BLOCK_SIZE) {
+                    refs[count] = ref;
+                    descs[count] = desc;
+                    count++;
+                }
+                continue;
+            }
 
-    // exact 찾은 경우 해당하는 보조 비트 마스크 적용
-    if (res->exact) {
-        return_code |= can_read(res->exact) ? CAN_READ_EXACT : 0;
-        return_code |= can_write(res->exact) ? CAN_WRITE_EXACT : 0;
-        return_code |= can_execute(res->exact) ? CAN_EXECUTE_EXACT : 0;
+            // 공유하지 않는 (소유 파일을 아는) 데이터 블록 중 오래 읽거나 쓰지 않은 블록
+            if (desc != 0 || data_arena_owner[ref] == 0 || (shared != 0 && shared != DEDUP_INDEXED)
+                || now - data_arena_touch[ref] < zip_interval) {
+                continue;
+            }
+            touch[count] = data_arena_touch[ref];
+            size_t size = compress_data(data_at(ref), DATA_BLOCK_SIZE, out + (size_t)count * ZIP_MAX_SIZE, ZIP_MAX_SIZE);
+            if (size == 0) {
+                // 압축되지 않는 블록은 zip_interval초 뒤에 다시 확인
+                data_arena_touch[ref] = now;
+                continue;
+            }
+            refs[count] = ref;
+            sizes[count] = (uint32_t)size;
+            descs[count] = 0;
+            count++;
+        }
+        if (count == 0) {
+            continue;
+        }
 
-        // 호출 프로세스가 exact의 소유자인 경우
-        if (res->exact->attr.st_uid == fuse_get_context()->uid) {
-            return_code |= IS_OWNER;
+        pthread_mutex_lock(&checkpoint_run_lock);
+        volume_cut();
+        for (unsigned i=0; i<count; i++) {
+            if (descs[i]) {
+                moved += zip_move(refs[i], descs[i]);
+            }
+            else {
+                compressed += zip_commit(refs[i], touch[i], out + (size_t)i * ZIP_MAX_SIZE, sizes[i]);
+            }
         }
+        volume_resume();
+        pthread_mutex_unlock(&checkpoint_run_lock);
+        total += count;
+    }
+    if (compressed > 0 || moved > 0) {
+        zip_stats stats = get_zip_stats();
+        fprintf(stderr, "asdfs_compress blocks %u moved %u total %lu bytes %lu packs %lu\n",
+                compressed, moved, stats.blocks, (unsigned long)stats.bytes, stats.packs);
     }
-
-    return return_code;
 }
 
-// 새로운 inode 생성, res 포인터로 반환
-asdfs_errno create_inode(const char *path, struct stat attr, inode **out) {
-    // 문자열 path를 tok_path로 복사
-    unsigned long length = strlen(path);
-    char *tok_path = (char *)malloc(strlen(path) + 1);
-    if (tok_path == NULL) {
-        return GENERAL_ERROR;
+// 1초마다 시간을 갱신하고 zip_interval초마다 압축, zip_stop이면 종료
+static void *zip_main(void *arg) {
+    (void)arg;
+    char *out = (char *)malloc((size_t)ZIP_BATCH * ZIP_MAX_SIZE);
+    if (out == NULL) {
+        fprintf(stderr, "asdfs_compress: out of memory\n");
+        return NULL;
     }
-    strncpy(tok_path, path, length + 1);
-    
-    // strtok을 사용하여 "/" 단위로 가져온 첫번째 path component
-    char *curr_comp = strtok(tok_path, "/");
-    while (curr_comp!=NULL) {
-        // 다음 처리할 path component
-        char *next_comp = strtok(NULL, "/");
-        // next_comp가 없으면 중단
-        if (next_comp == NULL) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint32_t last = 0;
+
+    pthread_mutex_lock(&zip_lock);
+    while (!zip_stop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += 1;
+        while (!zip_stop && pthread_cond_timedwait(&zip_wake, &zip_lock, &deadline) != ETIMEDOUT);
+        if (zip_stop) {
             break;
         }
-        // next_comp로 진행
-        curr_comp = next_comp;
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        zip_now = (uint32_t)(now.tv_sec - start.tv_sec);
+        if (zip_now - last < zip_interval) {
+            continue;
+        }
+        last = zip_now;
+        pthread_mutex_unlock(&zip_lock);
+        zip_pass(out);
+        pthread_mutex_lock(&zip_lock);
     }
-    // 이 때, curr_comp가 파일 이름 (tail)
-    if (curr_comp == NULL) {
-        return GENERAL_ERROR;
+    pthread_mutex_unlock(&zip_lock);
+    free(out);
+    return NULL;
+}
+
+// 블록을 압축하는 스레드 시작, 실패하면 -1 반환
+int start_compress() {
+    if (zip_interval == 0 || zip_started) {
+        return 0;
     }
+    // 볼륨을 만들기 전이면 블록 영역 생성
+    pthread_mutex_lock(&data_arena_lock);
+    int ready = data_arena_init();
+    pthread_mutex_unlock(&data_arena_lock);
+    if (ready != 0 || pthread_create(&zip_thread, NULL, zip_main, NULL) != 0) {
+        fprintf(stderr, "asdfs_start_compress: cannot start compress thread\n");
+        return -1;
+    }
+    zip_started = 1;
+    return 0;
+}
 
-    // 파일 시스템 잔여 블록 수 계산
-    unsigned long block_size = superblock.f_bsize;
-    unsigned long inodes_per_block = block_size / INODE_SIZE_BYTE;
+// 블록 압축 통계 반환
+zip_stats get_zip_stats() {
+    return zip_counter;
+}
 
-    // 현재 inode 개수에서 블록 당 inode 개수를 나눈
-    // 나머지가 0이면 새로운 블록 할당 필요
-    fsfilcnt_t remainder = superblock.f_files % inodes_per_block;
-    if (remainder == 0) {
-        // 이 때 남은 블록이 없다면 
-        if (superblock.f_bfree == 0) {
-            // 파일 시스템에 남은 용량 없음
-            return NO_FREE_SPACE;
-        }
+// 블록 ref가 내릴 수 있는 데이터 블록인지 여부 (파일이 가리키는 압축하지 않은 블록)
+static int spill_candidate(block_ref ref) {
+    return data_arena_zip[ref] == 0 && (data_arena_owner[ref] != 0 || data_arena_refs[ref] != 0);
+}
 
-        // 사용 가능한 블록 수 감소
-        superblock.f_bfree--;
-        superblock.f_bavail--;
+// first부터 count개 블록을 파일에 기록하고 메모리에서 내림
+// 공유 mapping에서 내린 page의 변경은 page cache에 남으므로, 그 사이 다시 쓴 page도 내용을 잃지 않음
+static void spill_write(block_ref first, unsigned count) {
+    if (count == 0) {
+        return;
     }
-    // 파일 개수 증가
-    superblock.f_files++;
+    char *ptr = data_at(first);
+    size_t size = (size_t)count * DATA_BLOCK_SIZE;
+    off_t pos = data_arena_pos + (off_t)first * DATA_BLOCK_SIZE;
+    madvise(ptr, size, MADV_DONTNEED);
 
-    // 새로운 inode 메모리 할당
-    inode *new = (inode*)calloc(1, sizeof(inode));
-    new->attr = attr;
-    attr.st_ino = (uint64_t)new; // 파일 시리얼 넘버는 포인터 값 사용
-
-    // 파일 이름 복사
-    strncpy(new->name, curr_comp, MAX_FILENAME + 1);
+    // 내용만 기록 (msync와 달리 파일 시스템 journal을 commit하지 않아 쓰기 요청을 오래 막지 않음)
+#ifdef SYNC_FILE_RANGE_WRITE
+    sync_file_range(data_arena_fd, pos, (off_t)size, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+#else
+    msync(ptr, size, MS_SYNC);
+#endif
+#ifdef POSIX_FADV_DONTNEED
+    // 파일에 기록된 page cache도 반환
+    posix_fadvise(data_arena_fd, pos, (off_t)size, POSIX_FADV_DONTNEED);
+#endif
+    __sync_fetch_and_add(&spill_counter.spilled, count);
+}
 
-    // res 포인터로 new 반환
-    *out = new;
+// 블록 메모리가 예산을 넘으면 CLOCK 순서로 사용 비트가 없는 블록을 내려 예산의 15/16까지 줄임
+// 사용 비트가 있는 블록은 비트만 지우고 넘어가며, 모두 사용 중이어도 두 바퀴 안에 멈춤
+static void spill_pass() {
+    uint64_t resident = spill_resident();
+    if (resident <= spill_budget) {
+        return;
+    }
+    uint64_t want = resident - (spill_budget - spill_budget / 16);
+    uint64_t limit = 2 * (uint64_t)volume->dataNext;
+    uint64_t done = 0;
+    block_ref first = 0;
+    unsigned count = 0;
+    for (uint64_t scanned = 0; done < want && scanned < limit; scanned++) {
+        block_ref ref = spill_hand;
+        if (ref == 0 || ref >= volume->dataNext) {
+            ref = 1;
+        }
+        spill_hand = ref + 1;
+        if (!spill_candidate(ref)) {
+            continue;
+        }
+        uint8_t state = spill_state[ref];
+        if (state & SPILL_USED) {
+            __sync_fetch_and_and(&spill_state[ref], (uint8_t)~SPILL_USED);
+            continue;
+        }
+        if (state != 0 || !__sync_bool_compare_and_swap(&spill_state[ref], 0, SPILL_OUT)) {
+            continue;
+        }
+        __sync_fetch_and_add(&spill_counter.out, 1);
+        done++;
 
-    free(tok_path);
-    return NO_ERROR;
+        // 이어진 블록은 모아서 한 번에 기록
+        if (count > 0 && (ref != first + count || count == SPILL_BATCH)) {
+            spill_write(first, count);
+            count = 0;
+        }
+        if (count == 0) {
+            first = ref;
+        }
+        count++;
+    }
+    spill_write(first, count);
+    __sync_fetch_and_add(&spill_counter.passes, 1);
 }
 
-// node에 data 공간 할당
-asdfs_errno alloc_data_inode(inode *node, off_t size) {
-    unsigned long block_size = superblock.f_bsize;
-
-    // 현재 node에 할당된 공간
-    off_t curr_size = node->attr.st_size;
-    blkcnt_t curr_blocks = node->attr.st_blocks;
-
-    // 요청에 따라 node에 할당될 공간
-    off_t new_size = size;
-    blkcnt_t new_blocks = (new_size / block_size) + !!(new_size % block_size);
-
-    // 현재 파일 시스템 잔여 블록 수에서
-    fsblkcnt_t f_bfree = superblock.f_bfree;
-    // node에 할당된 블록을 반환한 수가
-    f_bfree += curr_blocks;
-    // 요청에 따라 node에 할당될 블록 수보다 적으면
-    if (f_bfree < new_blocks) {
-        // 파일 시스템에 남은 용량 없음
-        return NO_FREE_SPACE;
+// SPILL_INTERVAL_MS마다 (또는 예산을 넘은 할당이 깨우면) 블록 메모리를 확인하여 내림, spill_stop이면 종료
+static void *spill_main(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&spill_lock);
+    while (!spill_stop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += SPILL_INTERVAL_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (!spill_stop && !spill_wanted && pthread_cond_timedwait(&spill_wake, &spill_lock, &deadline) != ETIMEDOUT);
+        if (spill_stop) {
+            break;
+        }
+        spill_wanted = 0;
+        pthread_mutex_unlock(&spill_lock);
+        spill_pass();
+        pthread_mutex_lock(&spill_lock);
     }
-    // 할당될 블록 수 감산
-    f_bfree -= new_blocks; 
+    pthread_mutex_unlock(&spill_lock);
+    return NULL;
+}
 
-    void *data = node->data;
-    // data가 할당되지 않은 경우 할당
-    if (data == NULL) {
-        data = calloc(1, new_blocks * block_size);
+// 블록을 내리는 스레드 시작, 실패하면 -1 반환
+int start_spill() {
+    if (spill_budget == 0 || spill_started) {
+        return 0;
     }
-    // data가 이전에 할당되었으나 요청 공간이 0인 경우
-    else if (size == 0) {
-        // 기존 data를 반환하고
-        free(data);
-        // 새로운 0 크기의 메모리 할당
-        data = calloc(1, 0);        
+    // checkpoint를 사용하는 이미지는 private mapping이라 내린 page의 변경 내용이 사라짐
+    if (volume_image != NULL && checkpoint_interval != 0) {
+        fprintf(stderr, "asdfs_start_spill: cannot spill a checkpointed image\n");
+        return -1;
     }
-    // data가 이전에 할당되었고 요청 공간이 현재 공간과 크기가 다른 경우
-    else if (curr_blocks != new_blocks) {
-        // 할당된 메모리 크기 조정
-        data = realloc(data, new_blocks * block_size);
+    // 볼륨을 만들기 전이면 블록 영역 생성
+    pthread_mutex_lock(&data_arena_lock);
+    int ready = data_arena_init();
+    pthread_mutex_unlock(&data_arena_lock);
+    if (ready != 0 || data_arena_fd < 0 || (volume_image == NULL && spill_dir == NULL)) {
+        fprintf(stderr, "asdfs_start_spill: no backing file\n");
+        return -1;
     }
-    node->data = data;
-
-    if (data == NULL) {
-        return GENERAL_ERROR;
+    if (pthread_create(&spill_thread, NULL, spill_main, NULL) != 0) {
+        fprintf(stderr, "asdfs_start_spill: cannot start spill thread\n");
+        return -1;
     }
-
-    // 새롭게 할당된 공간 크기 반영
-    node->attr.st_size = new_size;
-    node->attr.st_blocks = new_blocks;
-
-    // 새롭게 계산된 파일 시스템 잔여 블록 수 반영
-    superblock.f_bfree = f_bfree;
-    superblock.f_bavail = f_bfree;
-    return NO_ERROR;
+    spill_started = 1;
+    return 0;
 }
 
-// node의 data 공간 반환
-void dealloc_data_inode(inode *node) {
-    // data 메모리 반환
-    if (node->data) {
-        free(node->data);
-    }
+// 블록 내보내기 통계 반환
+spill_stats get_spill_stats() {
+    spill_stats stats = spill_counter;
+    stats.budget = spill_budget;
+    stats.resident = spill_resident();
+    return stats;
+}
 
-    // 현재 파일 시스템 잔여 블록 수 계산하여 반영
-    fsblkcnt_t f_bfree = superblock.f_bfree;
-    f_bfree += node->attr.st_blocks;
-    superblock.f_bfree = f_bfree;
-    superblock.f_bavail = f_bfree;
+// 블록 사용량과 중복 제거 통계 반환
+dedup_stats get_dedup_stats() {
+    dedup_stats stats = dedup_counter;
+    stats.logical = volume->logicalBlocks;
+    stats.physical = volume->superblock.f_blocks - volume->superblock.f_bfree;
+    stats.ratio = stats.physical ? (double)stats.logical / stats.physical : 1.0;
+    return stats;
 }
 
-// 새로운 inode를 res 위치에 삽입
+// 새로운 inode를 res.parent 아래 이름 순서에 맞는 위치에 삽입
 void insert_inode(search_result res, inode *new) {
     inode *parent = res.parent;
-    inode *left = res.left;
-    inode *right = res.right;
 
     // parent가 없을 경우 무시
     if (parent == NULL) {
         return;
     }
     // parent 지정
-    new->parent = parent;
+    new->parent = parent->id;
+
+    // parent 아래의 없는 path 항목 무효화
+    dcache_touch(parent);
+
+    // 이름 색인에 삽입하며 이름 순서 직전/직후 inode 확인
+    inode *left = NULL;
+    inode *right = NULL;
+    parent->indexRoot = index_insert(get_inode(parent->indexRoot), new, &left, &right)->id;
     
     // left 없고 right 없음
     if (left == NULL && right ==NULL){
-        parent->firstChild = new;
-        parent->lastChild = new;
+        parent->firstChild = new->id;
+        parent->lastChild = new->id;
     }
 
     // left 없고 right 있음
     if (left == NULL && right != NULL) {
-        right->leftSibling = new;
-        new->rightSibling = right;
+        right->leftSibling = new->id;
+        new->rightSibling = right->id;
         
-        parent->firstChild = new;
+        parent->firstChild = new->id;
     }
     
     // left 있고 right 없음
     if (left != NULL && right == NULL) {
-        left->rightSibling = new;
-        new->leftSibling = left;
+        left->rightSibling = new->id;
+        new->leftSibling = left->id;
         
-        parent->lastChild = new;
+        parent->lastChild = new->id;
     }
 
     // left 있고 right 있음
     if (left != NULL && right != NULL){
-        left->rightSibling = new;
-        right->leftSibling = new;
+        left->rightSibling = new->id;
+        right->leftSibling = new->id;
     
-        new->leftSibling = left;
-        new->rightSibling = right;
+        new->leftSibling = left->id;
+        new->rightSibling = right->id;
     }
+
+    // 이웃 사이의 readdir 순서 번호 부여
+    order_assign(new);
+
+    // 바뀐 inode 기록
+    dirty_range(parent, sizeof(inode));
+    dirty_range(new, sizeof(inode));
+    dirty_range(left, sizeof(inode));
+    dirty_range(right, sizeof(inode));
 }
 
 // node를 inode tree에서 분리
@@ -533,38 +4468,52 @@ void extract_inode(inode *node) {
         return;
     }
     
-    inode *parent = node->parent;
-    inode *left = node->leftSibling;
-    inode *right = node->rightSibling;
+    inode *parent = get_inode(node->parent);
+    inode *left = get_inode(node->leftSibling);
+    inode *right = get_inode(node->rightSibling);
+
+    // parent의 이름 색인에서 분리
+    if (parent != NULL) {
+        dcache_touch(parent);
+        parent->indexRoot = node_id(index_remove(get_inode(parent->indexRoot), node));
+    }
     
     // root를 제외하고, left 없고 right 없음
     if (parent != NULL && left == NULL && right == NULL){
-        parent->firstChild = NULL;
-        parent->lastChild = NULL;
+        parent->firstChild = 0;
+        parent->lastChild = 0;
     }
 
     // left 없고 right 있음    
     if (left == NULL && right != NULL) {
-        right->leftSibling = left;
+        right->leftSibling = 0;
         
-        parent->firstChild = right;
+        parent->firstChild = right->id;
     }
     
     // left 있고 right 없음
     if (left != NULL && right == NULL) {
-        left->rightSibling = right;
+        left->rightSibling = 0;
         
-        parent->lastChild = left;
+        parent->lastChild = left->id;
     }
     
     // left 있고 right 있음
     if (left != NULL && right != NULL){
-        left->rightSibling = right;
-        right->leftSibling = left;
+        left->rightSibling = right->id;
+        right->leftSibling = left->id;
     }
     
-    // parent 해제
-    node->parent = NULL;
+    // parent 및 sibling 해제
+    node->parent = 0;
+    node->leftSibling = 0;
+    node->rightSibling = 0;
+
+    // 바뀐 inode 기록
+    dirty_range(parent, sizeof(inode));
+    dirty_range(node, sizeof(inode));
+    dirty_range(left, sizeof(inode));
+    dirty_range(right, sizeof(inode));
 }
 
 // inode 삭제
@@ -575,33 +4524,155 @@ void destroy_inode(inode *node) {
 
     // 재귀적으로 firstChild 삭제
     while (node->firstChild) {
-        destroy_inode(node->firstChild);
+        destroy_inode(get_inode(node->firstChild));
     }
     
     // node를 inode tree에서 분리
     extract_inode(node);
 
+    // node 아래의 없는 path 항목 무효화
+    if (node->mode & S_IFDIR) {
+        dcache_invalidate_negative();
+    }
 
     // node의 data 공간 반환
     dealloc_data_inode(node);
 
-    // root가 아닌 node에 대해서 메모리 반환
-    if (node != &root) {
-        free(node);
+    // root가 아닌 node는 inode table에 반환
+    if (node->id != ROOT_INODE_ID) {
+        free_inode(node);
+        dirty_range(node, sizeof(inode));
     }
 
     // 파일 시스템 잔여 블록 수 계산
-    unsigned long block_size = superblock.f_bsize;
+    unsigned long block_size = volume->superblock.f_bsize;
     unsigned long inodes_per_block = block_size / INODE_SIZE_BYTE;
 
-    // 현재 inode 개수에서 블록 당 inode 개수를 나눈
+    // node를 포함한 inode 개수에서 블록 당 inode 개수를 나눈
     // 나머지가 1이면 기존 블록 해제 필요
-    fsfilcnt_t remainder = superblock.f_files % inodes_per_block;
+    fsfilcnt_t remainder = (volume->superblock.f_files + 1) % inodes_per_block;
     if (remainder == 1) { 
         // 사용 가능한 블록 수 증가
-        superblock.f_bfree++;
-        superblock.f_bavail++;
+        space_give(1);
+    }
+}
+
+
+// node의 이름 변경 (inode tree에서 분리된 상태에서만 호출)
+// 새로운 이름이 같은 크기의 slot에 들어가면 그 자리에서 변경
+asdfs_errno rename_inode(inode *node, path_comp name) {
+    if (node == NULL || name.name == NULL) {
+        return GENERAL_ERROR;
+    }
+
+    // 최대 파일 이름 길이까지만 복사
+    size_t length = name.length < MAX_FILENAME ? name.length : MAX_FILENAME;
+    int class = name_class(length);
+
+    // slot 크기가 다르면 새로운 slot 할당
+    name_ref ref = node->name;
+    if (ref == 0 || name_class(node->nameLength) != class) {
+        ref = name_alloc(class);
+        if (ref == 0) {
+            return GENERAL_ERROR;
+        }
+    }
+
+    char *copy = name_at(ref);
+    memmove(copy, name.name, length);
+    copy[length] = '\0';
+    dirty_range(copy, length + 1);
+
+    // 새로운 slot에 복사했으면 기존 slot 반환
+    if (ref != node->name) {
+        name_release(node->name, name_class(node->nameLength));
+        node->name = ref;
+    }
+    node->nameLength = (uint8_t)length;
+    node->nameHash = name_hash(copy, length);
+    dirty_range(node, sizeof(inode));
+    return NO_ERROR;
+}
+
+// 현재 마운트에서 커널이 참조하는 cold의 lookup 횟수
+static uint64_t lookup_count(inode_cold *cold) {
+    if (__atomic_load_n(&cold->mount, __ATOMIC_ACQUIRE) != volume->mounts) {
+        return 0;
+    }
+    return __atomic_load_n(&cold->nlookup, __ATOMIC_ACQUIRE);
+}
+
+// 이전 마운트에서 기록된 cold의 lookup 횟수를 0으로 초기화
+// 0으로 만든 뒤 mount를 바꾸므로 현재 마운트 번호가 보이면 nlookup도 현재 마운트의 값
+static void lookup_reset(inode_cold *cold) {
+    if (__atomic_load_n(&cold->mount, __ATOMIC_ACQUIRE) == volume->mounts) {
+        return;
+    }
+    pthread_mutex_lock(&lookup_lock);
+    if (cold->mount != volume->mounts) {
+        __atomic_store_n(&cold->nlookup, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&cold->mount, volume->mounts, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&lookup_lock);
+}
+
+// 커널이 참조하는 node의 lookup 횟수 증가
+// lookup 횟수는 다음 마운트에서 무효이므로 checkpoint에 기록하지 않음
+void ref_inode(inode *node) {
+    inode_cold *cold = get_cold(node);
+    lookup_reset(cold);
+    __atomic_add_fetch(&cold->nlookup, 1, __ATOMIC_ACQ_REL);
+}
+
+// 커널이 참조하는 node의 lookup 횟수를 nlookup만큼 감소 (0 아래로는 감소하지 않음)
+// inode tree에서 분리된 node는 더 이상 참조되지 않으면 삭제
+// 횟수를 0으로 만든 스레드만 삭제를 시도하고, 이름 공간 잠금 안에서 orphan 목록에 남아 있을 때만 삭제
+// (remove_inode가 먼저 0을 보고 삭제했으면 orphan 목록에 없음)
+void forget_inode(inode *node, uint64_t nlookup) {
+    inode_cold *cold = get_cold(node);
+    lookup_reset(cold);
+    uint64_t count = __atomic_load_n(&cold->nlookup, __ATOMIC_ACQUIRE);
+    uint64_t left;
+    do {
+        left = count - (nlookup < count ? nlookup : count);
+    } while (!__atomic_compare_exchange_n(&cold->nlookup, &count, left, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    if (count == 0 || left != 0 || node->id == ROOT_INODE_ID) {
+        return;
+    }
+
+    // 삭제가 끝날 때까지 checkpoint 대기 (lookup 횟수만 바뀌는 경우는 기록하지 않음)
+    CHECKPOINT_HOLD();
+    NAMESPACE_WRITE();
+    if (node->parent != 0 || lookup_count(cold) != 0) {
+        return;
+    }
+
+    // orphan 목록에서 제거, 목록에 없으면 아직 분리되지 않았거나 이미 삭제됨
+    inode_id *link = &volume->orphans;
+    while (*link && *link != node->id) {
+        link = &get_cold(get_inode(*link))->orphan;
+    }
+    if (*link == 0) {
+        return;
+    }
+    *link = cold->orphan;
+    cold->orphan = 0;
+    dirty_range(link, sizeof(inode_id));
+    dirty_range(cold, sizeof(inode_cold));
+    destroy_inode(node);
+}
+
+// node를 inode tree에서 분리하고, 커널이 참조하지 않으면 삭제
+// 커널이 참조하면 orphan 목록에 두어 다음 마운트에서 삭제할 수 있게 함
+void remove_inode(inode *node) {
+    extract_inode(node);
+    inode_cold *cold = get_cold(node);
+    if (lookup_count(cold) == 0) {
+        destroy_inode(node);
+    }
+    else {
+        cold->orphan = volume->orphans;
+        volume->orphans = node->id;
+        dirty_range(cold, sizeof(inode_cold));
     }
-    // 파일 개수 감소
-    superblock.f_files--;
 }
@@ -2,9 +2,39 @@
 #define __ASDFS_INTERNAL_H__
 
 #define BLOCK_SIZE_KB   4     // 블록 크기 (KB)
-#define VOLUME_SIZE_MB  100   // 파일 시스템 볼륨 크기 (MB)
+#define DATA_BLOCK_SIZE (BLOCK_SIZE_KB * 1024) // 파일 데이터 블록 크기 (B)
+#define DATA_FANOUT_SHIFT 10  // 파일 데이터 radix tree 노드 (블록 하나) 당 자식 개수 (2^10 = 1024)
+#ifndef VOLUME_SIZE_MB
+#define VOLUME_SIZE_MB  100   // 파일 시스템 볼륨 크기 (MB), -DVOLUME_SIZE_MB=로 변경 가능
+#endif
 #define MAX_FILENAME    255   // 최대 파일 이름 길이 (B)
 #define INODE_SIZE_BYTE 512   // 각 inode당 메모리 크기 (B)
+#define DCACHE_SIZE     4096  // dentry cache 항목 개수 (2의 거듭제곱)
+#define DCACHE_PATH_MAX 256   // dentry cache에 저장하는 최대 path 길이 (B)
+#define DCACHE_HELD_SIZE 16   // 목록을 읽는 중인 디렉터리를 고정하는 dentry cache 항목 개수
+#define GROUPS_MAX      512   // 조회하는 최대 supplementary groups 개수
+#define CRED_CACHE_SIZE 256   // pid별 supplementary groups cache 항목 개수
+#define CRED_CACHE_GROUPS 32  // cache 항목에 저장하는 최대 supplementary groups 개수
+#define CRED_CACHE_TTL_MS 1000 // supplementary groups cache 유효 시간 (ms)
+#define INODE_CHUNK_SHIFT 12  // inode table chunk 당 inode 개수 (2^12 = 4096)
+#define ROOT_INODE_ID   1     // root inode 번호 (FUSE_ROOT_ID와 같음)
+#define INODE_MAGAZINE_SIZE 64 // 스레드별로 cache하는 최대 inode 번호 개수
+#define NAME_PAGE_SHIFT 16    // 이름 arena page 크기 (2^16 = 64 KB)
+#define NAME_SLOT_MIN   16    // 이름 arena의 가장 작은 slot 크기 (B), slot은 2의 거듭제곱 크기
+#define DIR_COOKIE_BASE 3     // 첫 자식 항목의 readdir offset (1은 ".", 2는 ".." 다음)
+#define DEDUP_LOCKS     64    // 중복 제거 색인 bucket lock 개수 (2의 거듭제곱)
+#define DATA_REF_FACTOR 8     // 블록 번호 개수 / 전체 블록 개수 (압축된 블록도 번호를 유지하므로 여유를 둠)
+#define DATA_EXTENT_SLOTS 64  // 파일 끝에 이어 쓰는 파일별로 블록 번호를 미리 예약하는 자리 개수
+#define DATA_EXTENT_MAX 64    // 한 번에 예약하는 최대 블록 번호 개수 (2개부터 두 배씩)
+#define ZIP_CACHE_SIZE  64    // 압축을 푼 블록 cache 항목 개수
+#define ZIP_BATCH       64    // 압축 스레드가 변경 요청을 한 번 막는 동안 반영하는 최대 블록 개수
+#define ZIP_PASS_BLOCKS 4096  // 압축 스레드가 한 주기에 압축하거나 옮기는 최대 블록 개수
+#define SPILL_INTERVAL_MS 100 // 블록 메모리가 예산을 넘는지 확인하는 간격 (ms)
+#define SPILL_BATCH     256   // 이어진 블록을 한 번에 파일에 기록하고 내리는 최대 개수
+
+#ifndef FUSE_USE_VERSION
+#define FUSE_USE_VERSION 29   // 사용할 FUSE API 버전
+#endif
 
 #include <fuse.h>
 #include <stdio.h>
@@ -12,22 +42,84 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <fuse_lowlevel.h>
+#include <sys/uio.h>
+
+// fallocate 모드 (linux/falloc.h와 같은 값)
+#ifndef FALLOC_FL_KEEP_SIZE
+#define FALLOC_FL_KEEP_SIZE  0x01 // 파일 크기 유지
+#endif
+#ifndef FALLOC_FL_PUNCH_HOLE
+#define FALLOC_FL_PUNCH_HOLE 0x02 // 범위를 hole로 변경
+#endif
 
-// inode 구조체
+// inode 번호: inode table 안의 위치, 0은 없음을 의미
+typedef uint32_t inode_id;
+
+// 이름 번호: 이름 arena 안의 위치 (상위 16비트 page, 하위 16비트 page 안의 위치), 0은 없음
+typedef uint32_t name_ref;
+
+// 블록 번호: 블록 영역 안의 위치 (DATA_BLOCK_SIZE 단위), 0은 없음을 의미
+typedef uint32_t block_ref;
+
+// inode 구조체: 경로 탐색과 권한 확인에 쓰는 값만 모은 부분 (cache line 하나, 64 B)
+// 나머지 파일 정보는 같은 번호의 inode_cold에 저장
 typedef struct inode inode;
 struct inode {
-    struct stat attr;    // 파일의 상태 정보 메타데이터
-    
-    char name[MAX_FILENAME + 1]; // 파일 이름
-    
-    inode *parent;       // 상위 inode 객체 포인터
-    inode *leftSibling;  // 왼쪽 inode 객체 포인터
-    inode *rightSibling; // 오른쪽 inode 객체 포인터
-    inode *firstChild;   // 하위 첫번째 inode 객체 포인터
-    inode *lastChild;    // 하위 마지막 inode 객체 포인터
-                         // fistChild에서 lastChild까지는 ABC순으로 유지
-    
-    void *data;          // 실제 파일 데이터
+    inode_id id;           // 이 inode의 번호
+    mode_t mode;           // 파일 종류 및 권한 (st_mode)
+    uid_t uid;             // 소유자 uid (st_uid)
+    gid_t gid;             // 그룹 gid (st_gid)
+
+    inode_id parent;       // 상위 inode 번호
+    inode_id leftSibling;  // 왼쪽 inode 번호
+    inode_id rightSibling; // 오른쪽 inode 번호
+    inode_id firstChild;   // 하위 첫번째 inode 번호
+    inode_id lastChild;    // 하위 마지막 inode 번호
+                           // fistChild에서 lastChild까지는 이름 순서로 유지
+                           // 이름 순서: 바이트 값 순 (앞부분이 같으면 짧은 이름이 앞)
+
+    inode_id indexRoot;    // 하위 inode 이름 색인 (AVL tree)의 root
+    inode_id indexLeft;    // 색인에서 이름 순서가 앞인 하위 트리
+    inode_id indexRight;   // 색인에서 이름 순서가 뒤인 하위 트리
+    uint8_t indexHeight;   // 색인에서 이 inode를 root로 하는 하위 트리의 높이
+
+    uint8_t nameLength;    // 파일 이름 길이 (최대 MAX_FILENAME)
+    uint32_t nameHash;     // 파일 이름 해시 값 (FNV-1a)
+    name_ref name;         // 이름 arena 안의 파일 이름 (NUL로 끝남)
+} __attribute__((aligned(64)));
+
+// inode에서 자주 쓰지 않는 파일 정보
+typedef struct inode_cold inode_cold;
+struct inode_cold {
+    off_t size;          // 파일 크기 (st_size)
+    blkcnt_t blocks;     // 실제로 할당된 data 블록 수 (hole 제외)
+    nlink_t nlink;       // 링크 개수 (st_nlink)
+    dev_t rdev;          // 기기 ID (st_rdev)
+    time_t atime;        // 파일 최근 사용 시간 (st_atime)
+    time_t mtime;        // 파일 최근 수정 시간 (st_mtime)
+    time_t ctime;        // 파일 최근 상태 변화 시간 (st_ctime)
+
+    uint64_t nlookup;    // low-level FUSE에서 커널이 참조하는 lookup 횟수
+    uint64_t version;    // 하위 inode가 추가될 때마다 갱신 (dentry cache negative 항목 확인용)
+    uint64_t order;      // 형제 사이의 순서 번호 (이름 순서대로 증가, readdir offset)
+
+    blkcnt_t zipSaved;   // 압축으로 줄어든 크기 (512 B 단위, st_blocks에서 뺌)
+
+    block_ref data;      // 실제 파일 데이터: DATA_BLOCK_SIZE 블록의 radix tree root
+                         // dataHeight가 0이면 첫 블록, 아니면 자식 블록 번호 2^DATA_FANOUT_SHIFT개를 담은 노드 블록
+    int dataHeight;      // 파일 데이터 radix tree 높이
+    uint32_t mount;      // nlookup을 기록한 마운트 번호, 현재 마운트와 다르면 nlookup은 0
+    inode_id orphan;     // 삭제되었지만 커널이 참조하는 inode 목록의 다음 inode 번호
+};
+
+// path component: path 문자열 안의 위치와 길이 (NUL로 끝나지 않음)
+typedef struct path_comp path_comp;
+struct path_comp {
+    const char *name; // component 시작 위치
+    size_t length;    // component 길이
 };
 
 // find_inode에서 반환되는 inode 검색 결과
@@ -38,6 +130,79 @@ struct search_result {
     inode *left;   // exact의 왼쪽 inode 객체 포인터
     inode *exact;  // 요청된 path에 해당하는 inode 객체 포인터
     inode *right;  // exact의 오른쪽 inode 객체 포인터
+
+    path_comp tail; // path의 마지막 component (exact 또는 새로 생성될 inode의 이름)
+};
+
+// dentry cache 통계
+typedef struct dcache_stats dcache_stats;
+struct dcache_stats {
+    unsigned long hit;      // dentry cache에서 찾은 횟수
+    unsigned long negative; // dentry cache에서 없는 path로 찾은 횟수
+    unsigned long miss;     // tree를 탐색한 횟수
+    unsigned long held;     // tree 탐색 중 고정된 상위 디렉터리에서 시작한 횟수
+};
+
+// supplementary groups cache 통계
+typedef struct cred_stats cred_stats;
+struct cred_stats {
+    unsigned long hit;  // cache에서 찾은 횟수
+    unsigned long miss; // fuse_getgroups로 조회한 횟수
+};
+
+// inode 할당 통계
+typedef struct inode_stats inode_stats;
+struct inode_stats {
+    unsigned long live;     // 사용 중인 inode 개수 (root 포함)
+    unsigned long cached;   // 스레드별 magazine에 있는 inode 개수
+    unsigned long free;     // slab에 남은 빈 자리 개수
+    unsigned long slabs;    // 할당된 slab 개수
+    unsigned long released; // 모두 비어서 메모리를 OS에 반환한 slab 개수
+};
+
+// checkpoint 통계
+typedef struct checkpoint_stats checkpoint_stats;
+struct checkpoint_stats {
+    unsigned long cycles; // 이미지 파일에 기록한 checkpoint 횟수
+    uint64_t bytes;       // 기록한 바뀐 page 크기 합계 (B)
+    uint64_t lastBytes;   // 마지막 checkpoint에서 기록한 크기 (B)
+    double lastMs;        // 마지막 checkpoint에 걸린 시간 (ms)
+    double lastStallMs;   // 마지막 checkpoint가 변경 요청을 막은 시간 (ms)
+    double maxStallMs;    // 변경 요청을 막은 가장 긴 시간 (ms)
+};
+
+// 블록 사용량과 중복 제거 통계
+typedef struct dedup_stats dedup_stats;
+struct dedup_stats {
+    uint64_t logical;      // 파일들이 가리키는 데이터 블록 개수 합계 (공유한 블록은 파일 위치마다 셈)
+    uint64_t physical;     // 볼륨에서 사용 중인 블록 개수 (radix tree 노드 포함)
+    double ratio;          // logical / physical
+    unsigned long hashed;  // 중복 제거 색인을 검색한 블록 개수
+    unsigned long hit;     // 같은 내용의 블록을 찾아 공유한 횟수
+    unsigned long indexed; // 색인에 있는 블록 개수
+};
+
+// 블록 압축 통계
+typedef struct zip_stats zip_stats;
+struct zip_stats {
+    unsigned long blocks;   // 압축되어 pack에 저장된 블록 개수
+    uint64_t bytes;         // 압축된 블록 크기 합계 (B)
+    unsigned long packs;    // 압축된 블록을 모아 저장하는 pack 블록 개수
+    unsigned long hit;      // 압축을 푼 블록 cache에서 읽은 횟수
+    unsigned long miss;     // 압축을 풀어 읽은 횟수
+    unsigned long expanded; // 쓰기 전에 압축을 풀어 블록 메모리를 다시 할당한 횟수
+    unsigned long moved;    // 비어 가는 pack에서 다른 pack으로 옮긴 블록 개수
+};
+
+// 블록 내보내기 (spill) 통계
+typedef struct spill_stats spill_stats;
+struct spill_stats {
+    uint64_t budget;        // 블록 메모리 예산 (블록 단위)
+    uint64_t resident;      // 메모리에 있는 것으로 보는 사용 중인 블록 개수
+    unsigned long out;      // 메모리에서 내린 블록 개수
+    unsigned long spilled;  // 파일에 기록하고 메모리에서 내린 횟수 (블록 단위)
+    unsigned long fetched;  // 내린 블록을 다시 읽거나 쓴 횟수
+    unsigned long passes;   // 예산을 넘어 블록을 내린 주기 수
 };
 
 // asdFS 에러 코드
@@ -52,6 +217,7 @@ typedef enum {
     EXACT_NOT_FOUND,    // 주어진 위치에 inode 없음
                         // exact는 NULL이나 parent/left/right는 NULL이 아님
                         // 새로운 inode가 추가될 경우의 위치 정보 반환
+                        // (dentry cache에서 찾은 경우 left/right는 NULL)
     
     HEAD_NOT_FOUND,     // 주어진 위치로의 tree path 없음
     HEAD_NOT_DIRECTORY, // tree path 중간에 디렉터리가 아닌 inode 있음
@@ -71,24 +237,177 @@ typedef enum {
 } asdfs_errno;
 
 // 파일 시스템 root inode, superblock 초기화
-void init_root_superblock();
+// root는 uid, gid 소유이며 umask를 적용한 권한을 가짐
+void init_root_superblock(uid_t uid, gid_t gid, mode_t umask);
+
+// path의 이미지 파일을 볼륨으로 사용, 파일이 없거나 비어 있으면 새로 생성
+// checkpoint가 0이 아니면 checkpoint초마다 바뀐 page만 이미지 파일에 기록 (start_checkpoint)
+// init_root_superblock 전에 호출, 실패하면 GENERAL_ERROR 반환
+asdfs_errno open_volume(const char *path, unsigned checkpoint);
+
+// 블록 전체를 쓸 때 같은 내용의 블록을 찾아 공유 (중복 제거)
+// open_volume, init_root_superblock 전에 호출, 실패하면 GENERAL_ERROR 반환
+asdfs_errno enable_dedup();
+
+// interval초 동안 읽거나 쓰지 않은 데이터 블록을 백그라운드에서 압축 (start_compress)
+// open_volume, init_root_superblock 전에 호출, 실패하면 GENERAL_ERROR 반환
+asdfs_errno enable_compress(unsigned interval);
+
+// 블록을 압축하는 스레드 시작 (데몬이 된 뒤 호출), 실패하면 -1 반환
+int start_compress();
+
+// 데이터 블록 메모리가 budget MB를 넘으면 오래 쓰지 않은 블록을 파일에 기록하고 메모리에서 내림 (start_spill)
+// dir이 있으면 블록 영역을 dir의 이름 없는 파일에 두고, 없으면 이미지 파일 사용 (checkpoint는 사용할 수 없음)
+// open_volume, init_root_superblock 전에 호출, dir에 파일을 만들 수 없으면 GENERAL_ERROR 반환
+asdfs_errno enable_spill(const char *dir, unsigned budget);
+
+// 블록을 내리는 스레드 시작 (데몬이 된 뒤 호출), 실패하면 -1 반환
+int start_spill();
+
+// 볼륨 닫기: 이미지 파일을 사용하면 디스크에 기록
+void close_volume();
+
+// 주기적으로 checkpoint하는 스레드 시작 (데몬이 된 뒤 호출), 실패하면 -1 반환
+// 각 checkpoint가 디스크에 기록되면 cut 시점의 journal 기록 번호로 done 호출
+int start_checkpoint(void (*done)(uint64_t lsn));
+
+// 마지막 checkpoint 이후 바뀐 page만 이미지 파일에 기록
+// checkpoint를 사용하지 않으면 아무것도 하지 않음, 실패하면 GENERAL_ERROR 반환
+asdfs_errno checkpoint_volume();
+
+// 볼륨을 변경하는 요청 시작: checkpoint (또는 압축 스레드)의 cut이 끝날 때까지 대기, 항상 1 반환
+int checkpoint_hold();
+
+// checkpoint_hold로 시작한 볼륨 변경 끝
+void checkpoint_release(int *held);
+
+// 요청 함수 안에서 볼륨 변경 전에 호출, 함수가 끝나면 자동으로 checkpoint_release
+#define CHECKPOINT_HOLD() int checkpoint_held __attribute__((cleanup(checkpoint_release))) = checkpoint_hold()
+
+// 이름 공간 (inode tree, 이름 색인, sibling 목록) 사용 시작: write이면 쓰기, 아니면 읽기로 잠금, 항상 1 반환
+// 같은 스레드에서 중첩하면 바깥의 잠금을 그대로 사용
+int namespace_hold(int write);
+
+// namespace_hold로 시작한 이름 공간 사용 끝, 이미 끝낸 held (0)이면 무시
+// 요청 함수 안에서 namespace_release(&namespace_held)로 먼저 끝내면 함수가 끝날 때 다시 해제하지 않음
+void namespace_release(int *held);
+
+// 요청 함수 안에서 이름을 찾거나 목록을 읽기 전 (NAMESPACE_READ), 항목을 만들거나 지우거나 옮기기 전 (NAMESPACE_WRITE) 호출
+// CHECKPOINT_HOLD 다음에 호출, 함수가 끝나면 자동으로 namespace_release
+#define NAMESPACE_READ()  int namespace_held __attribute__((cleanup(namespace_release))) = namespace_hold(0)
+#define NAMESPACE_WRITE() int namespace_held __attribute__((cleanup(namespace_release))) = namespace_hold(1)
+
+// node의 inode 정보가 바뀌었음을 다음 checkpoint에 기록
+void dirty_inode(inode *node);
+
+// checkpoint 통계 반환
+checkpoint_stats get_checkpoint_stats();
+
+// 볼륨에 반영된 마지막 journal 기록 번호 반환
+// 이미지 파일을 쓰지 않으면 마운트할 때마다 0부터 시작
+uint64_t get_applied_lsn();
+
+// lsn까지의 journal 기록이 볼륨에 반영되었음을 기록 (더 작은 번호는 무시)
+void set_applied_lsn(uint64_t lsn);
+
+// 이미지 파일의 볼륨 정보, inode, 이름 영역을 디스크에 기록
+// 이미지 파일을 쓰지 않으면 아무것도 하지 않음
+asdfs_errno sync_volume();
 
 // 파일 시스템 superblock 정보 반환
 struct statvfs get_superblock();
 
+// 파일 시스템 root inode 반환
+inode *get_root();
+
+// 번호 id의 inode 반환, 0이면 NULL
+inode *get_inode(inode_id id);
+
+// node의 자주 쓰지 않는 파일 정보 반환
+inode_cold *get_cold(inode *node);
+
+// node의 파일 정보를 stat 구조체로 반환
+struct stat get_attr(inode *node);
+
+// node의 파일 이름 반환 (NUL로 끝남)
+const char *get_name(inode *node);
+
+// 현재 스레드가 처리 중인 low-level 요청 지정, NULL이면 high-level fuse context 사용
+void set_request(fuse_req_t req);
+
+// journal 기록을 다시 적용하는 동안 권한 확인 생략, 끝나면 dentry cache 전체 무효화
+void set_replay(int on);
+
+// cursor 위치부터 다음 path component를 comp에 기록하고 cursor 이동
+// 남은 component가 없으면 0 반환
+int next_path_comp(const char **cursor, path_comp *comp);
+
 // path에 해당하는 inode 검색, 결과 res 포인터로 반환
 asdfs_errno find_inode(const char *path, search_result *res);
 
-// 새로운 inode 생성, res 포인터로 반환
-asdfs_errno create_inode(const char *path, struct stat attr, inode **out);
+// parent 아래에서 name에 해당하는 inode 검색, 결과 res 포인터로 반환
+asdfs_errno lookup_inode(inode *parent, const char *name, search_result *res);
 
-// node에 data 공간 할당
+// parent의 자식 중 readdir offset cookie 항목 다음 자식 반환, 없으면 NULL
+// cookie가 DIR_COOKIE_BASE보다 작으면 첫 자식 반환
+inode *seek_child(inode *parent, off_t cookie);
+
+// child 다음 자식부터 이어서 읽을 수 있는 readdir offset 반환
+// 다른 자식이 추가/삭제되어도 같은 값 유지 (이웃 사이에 빈 번호가 없어 번호를 다시 붙이는 경우 제외)
+off_t child_cookie(inode *child);
+
+// node의 위치 정보 및 보조 비트 마스크를 포함한 검색 결과 res 포인터로 반환
+asdfs_errno access_inode(inode *node, search_result *res);
+
+// find_inode 결과 res의 tail 이름으로 새로운 inode 생성, out 포인터로 반환
+asdfs_errno create_inode(const search_result *res, struct stat attr, inode **out);
+
+// node의 data 크기 변경, 늘어난 부분은 블록을 차지하지 않는 hole
 asdfs_errno alloc_data_inode(inode *node, off_t size);
 
 // node의 data 공간 반환
 void dealloc_data_inode(inode *node);
 
-// 새로운 inode를 res 위치에 삽입
+// node 파일을 닫음: 이어 쓰기용으로 예약하고 쓰지 않은 블록 번호 반환
+void release_data_inode(inode *node);
+
+// node data의 off부터 최대 size 바이트를 mem으로 복사, 복사한 바이트 수 반환
+// 파일 크기를 넘는 부분은 읽지 않음
+size_t read_data_inode(inode *node, char *mem, size_t size, off_t off);
+
+// node data의 off부터 최대 size 바이트를 가리키는 iovec을 최대 count개 iov에 기록, 기록한 개수 반환
+// 파일 크기를 넘는 부분은 제외, 할당되지 않은 블록은 0으로 채워진 블록을 가리킴
+// 압축된 블록은 가리킬 메모리가 없으므로 그 앞에서 멈춤 (나머지는 read_data_inode로 복사)
+int map_data_inode(inode *node, off_t off, size_t size, struct iovec *iov, int count);
+
+// node data의 off부터 최대 size 바이트를 가리키는 fuse_buf를 최대 count개 bufs에 기록, 기록한 개수 반환
+// 블록 영역에 fd가 있으면 블록은 (fd, 위치)로, 없으면 메모리 주소로 가리킴
+// 할당되지 않은 블록은 0으로 채워진 블록의 메모리 주소를 가리킴, 압축된 블록 앞에서 멈춤
+int map_buf_data_inode(inode *node, off_t off, size_t size, struct fuse_buf *bufs, int count);
+
+// node의 데이터 블록을 이미지 파일에 기록
+// 이미지 파일을 쓰지 않으면 아무것도 하지 않음
+asdfs_errno sync_data_inode(inode *node);
+
+// node data의 off부터 mem의 size 바이트 쓰기, 파일 크기를 넘으면 크기 증가, 쓴 바이트 수는 written 포인터로 반환
+// 중간에 블록이 모자라면 그 앞까지 쓴 뒤 오류 반환
+asdfs_errno write_data_inode(inode *node, const char *mem, size_t size, off_t off, size_t *written);
+
+// node data의 off부터 buf의 내용 쓰기, 파일 크기를 넘으면 크기 증가, 쓴 바이트 수는 written 포인터로 반환
+// buf가 pipe인 경우 (splice) 중간 버퍼 없이 블록으로 바로 읽어옴
+asdfs_errno write_buf_data_inode(inode *node, struct fuse_bufvec *buf, off_t off, size_t *written);
+
+// node data의 off부터 length 바이트 범위의 블록을 0으로 채워 할당, 파일 크기는 유지
+asdfs_errno fill_data_inode(inode *node, off_t off, off_t length);
+
+// node data의 off부터 length 바이트 범위를 hole로 변경, 파일 크기는 유지
+asdfs_errno punch_data_inode(inode *node, off_t off, off_t length);
+
+// src data의 src_off부터 length 바이트의 블록을 dst data의 dst_off 위치에서 공유 (reflink)
+// 위치와 길이는 블록 단위, 공유한 블록은 어느 한쪽이 쓸 때 복사, 범위가 dst 크기를 넘으면 크기 증가
+asdfs_errno clone_data_inode(inode *dst, off_t dst_off, inode *src, off_t src_off, off_t length);
+
+// 새로운 inode를 res.parent 아래 이름 순서에 맞는 위치에 삽입
 void insert_inode(search_result res, inode *new);
 
 // node를 inode tree에서 분리
@@ -97,4 +416,46 @@ void extract_inode(inode *node);
 // inode 삭제
 void destroy_inode(inode *node);
 
+// node의 이름 변경 (inode tree에서 분리된 상태에서만 호출)
+// 이름을 저장할 공간이 없으면 이름을 바꾸지 않고 GENERAL_ERROR 반환
+asdfs_errno rename_inode(inode *node, path_comp name);
+
+// 커널이 참조하는 node의 lookup 횟수 증가
+void ref_inode(inode *node);
+
+// 커널이 참조하는 node의 lookup 횟수를 nlookup만큼 감소
+// inode tree에서 분리된 node는 더 이상 참조되지 않으면 삭제
+void forget_inode(inode *node, uint64_t nlookup);
+
+// node를 inode tree에서 분리하고, 커널이 참조하지 않으면 삭제
+void remove_inode(inode *node);
+
+// path에 해당하는 dentry cache 항목 무효화
+void dcache_invalidate(const char *path);
+
+// dentry cache 전체 무효화
+void dcache_invalidate_all();
+
+// 목록을 읽는 디렉터리 dir의 path를 dentry cache에 고정
+// 이후 dir 바로 아래 path 검색은 root가 아닌 dir에서 시작
+void dcache_hold(const char *path, inode *dir);
+
+// dentry cache 통계 반환
+dcache_stats get_dcache_stats();
+
+// supplementary groups cache 통계 반환
+cred_stats get_cred_stats();
+
+// inode 할당 통계 반환
+inode_stats get_inode_stats();
+
+// 블록 사용량과 중복 제거 통계 반환
+dedup_stats get_dedup_stats();
+
+// 블록 압축 통계 반환
+zip_stats get_zip_stats();
+
+// 블록 내보내기 통계 반환
+spill_stats get_spill_stats();
+
 #endif
@@ -0,0 +1,46 @@
+#ifndef __ASDFS_IOCTL_H__
+#define __ASDFS_IOCTL_H__
+
+#include <stdint.h>
+#include <sys/ioctl.h>
+
+// 블록을 공유하는 파일 복제 (reflink) 요청
+// 커널은 FICLONE/FICLONERANGE를 FUSE 파일 시스템에 전달하지 않고, FUSE 서버는 호출 프로세스의 fd를 쓸 수 없으므로
+// FICLONERANGE와 같은 번호 체계와 인자에서 원본 fd 대신 마운트 위치 기준 path를 전달
+//
+// 예) 마운트 위치 아래 /a를 /b로 복제 (FICLONE과 같음)
+//     struct asdfs_clone_range range = { 0, 0, 0, "/a" };
+//     int fd = open("MOUNTPOINT/b", O_WRONLY | O_CREAT, 0644);
+//     ioctl(fd, ASDFS_IOC_CLONE_RANGE, &range);
+
+#define ASDFS_CLONE_PATH_MAX 4096 // 원본 path 최대 길이 (NUL 포함)
+
+struct asdfs_clone_range {
+    uint64_t src_offset;                 // 원본 시작 위치 (블록 크기 단위)
+    uint64_t src_length;                 // 길이 (블록 크기 단위, 원본 끝까지인 경우 제외), 0이면 원본 끝까지
+    uint64_t dest_offset;                // 대상 시작 위치 (블록 크기 단위)
+    char src_path[ASDFS_CLONE_PATH_MAX]; // 원본 파일 path (마운트 위치 기준, "/"로 시작)
+};
+
+// FICLONERANGE (_IOW(0x94, 13, struct file_clone_range))와 같은 의미
+#define ASDFS_IOC_CLONE_RANGE _IOW(0x94, 13, struct asdfs_clone_range)
+
+// 블록 사용량과 중복 제거 통계 요청 (statfs 로그와 같은 값, 마운트할 때 -f 없이도 조회 가능)
+// 마운트 위치 아래 어느 파일이든 열어서 요청, 권한 확인 없음
+//
+// 예) struct asdfs_block_stats stats;
+//     int fd = open("MOUNTPOINT/a", O_RDONLY);
+//     ioctl(fd, ASDFS_IOC_BLOCK_STATS, &stats);
+
+struct asdfs_block_stats {
+    uint64_t logical;  // 파일들이 가리키는 데이터 블록 개수 합계 (공유한 블록은 파일 위치마다 셈)
+    uint64_t physical; // 볼륨에서 사용 중인 블록 개수 (radix tree 노드 포함)
+    double ratio;      // logical / physical, 공유와 중복 제거로 줄어든 비율
+    uint64_t hashed;   // 중복 제거 색인을 검색한 블록 개수
+    uint64_t hit;      // 같은 내용의 블록을 찾아 공유한 횟수
+    uint64_t indexed;  // 색인에 있는 블록 개수
+};
+
+#define ASDFS_IOC_BLOCK_STATS _IOR(0x94, 0xA0, struct asdfs_block_stats)
+
+#endif
@@ -0,0 +1,382 @@
+#include "asdfs_journal.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// journal 파일 안의 기록: journal_entry 뒤에 path, newpath (NUL 포함), 8 B 단위로 맞춤
+// 마지막 기록이 일부만 기록된 경우 check가 맞지 않으므로 그 앞까지만 사용
+typedef struct journal_entry journal_entry;
+struct journal_entry {
+    uint32_t check;         // check 다음부터 기록 끝까지의 해시 값
+    uint32_t length;        // 기록 전체 크기 (B)
+    uint64_t lsn;           // 기록 번호
+    uint32_t op;            // 변경 종류
+    uint32_t mode;          // 파일 모드
+    uint32_t uid;           // 소유자 uid
+    uint32_t gid;           // 소유자 gid
+    uint64_t rdev;          // 기기 ID
+    int64_t size;           // 파일 크기
+    int64_t atime;          // 파일 최근 사용 시간
+    int64_t mtime;          // 파일 최근 수정 시간
+    uint32_t pathLength;    // path 길이 (NUL 제외)
+    uint32_t newpathLength; // newpath 길이 (NUL 제외)
+};
+
+// 버퍼: 추가한 뒤 아직 파일에 쓰지 않은 기록
+typedef struct journal_buffer journal_buffer;
+struct journal_buffer {
+    char *data;
+    size_t length;
+    size_t capacity;
+};
+
+static int journal_fd = -1;              // journal 파일 fd, 없으면 -1
+static char *journal_path;               // journal 파일 path
+static int journal_started;              // journal_replay 이후 기록 추가 여부
+static int journal_failed;               // 파일 쓰기에 실패하면 이후 commit 전부 실패
+static uint64_t journal_next = 1;        // 다음 기록 번호
+static uint64_t journal_durable;         // 디스크에 기록된 마지막 기록 번호
+static int journal_syncing;              // 한 스레드가 파일에 쓰는 중인지 여부
+static journal_buffer journal_pending;   // 다음 fdatasync에 함께 기록할 기록
+static journal_buffer journal_writing;   // 파일에 쓰는 중인 기록 (쓰는 스레드만 사용)
+static journal_stats journal_counter;    // 기록/commit/fdatasync 횟수
+static pthread_mutex_t journal_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t journal_cond = PTHREAD_COND_INITIALIZER; // 파일 쓰기 완료 알림
+
+// data의 length 바이트 해시 값 (FNV-1a)
+static uint32_t journal_hash(const char *data, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i=0; i<length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// path의 journal 파일 열기, 없으면 생성
+int journal_open(const char *path) {
+    journal_fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0600);
+    if (journal_fd < 0) {
+        fprintf(stderr, "asdfs_journal_open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    journal_path = strdup(path);
+    return 0;
+}
+
+// journal에 기록을 추가하는 중인지 여부
+int journal_active() {
+    return journal_started;
+}
+
+// lsn이 applied보다 큰 기록을 순서대로 apply에 전달, 전달한 개수 반환
+unsigned long journal_replay(uint64_t applied, void (*apply)(const journal_record *rec)) {
+    if (journal_fd < 0) {
+        return 0;
+    }
+
+    // 파일 전체 읽기, 읽지 못하면 기록을 지우지 않고 이후 commit 전부 실패
+    struct stat st;
+    char *data = NULL;
+    size_t length = 0;
+    if (fstat(journal_fd, &st) != 0) {
+        st.st_size = 0;
+        journal_failed = 1;
+    }
+    if (st.st_size > 0) {
+        data = (char *)malloc((size_t)st.st_size);
+        if (data != NULL && pread(journal_fd, data, (size_t)st.st_size, 0) == st.st_size) {
+            length = (size_t)st.st_size;
+        }
+        else {
+            fprintf(stderr, "asdfs_journal_replay: cannot read journal\n");
+            journal_failed = 1;
+        }
+    }
+
+    // 올바른 기록을 순서대로 전달
+    unsigned long count = 0;
+    uint64_t last = 0;
+    size_t pos = 0;
+    while (length - pos >= sizeof(journal_entry)) {
+        journal_entry entry;
+        memcpy(&entry, data + pos, sizeof(entry));
+        if (entry.length < sizeof(entry) || entry.length > length - pos || entry.length % 8 != 0
+            || (uint64_t)entry.pathLength + entry.newpathLength + 2 > entry.length - sizeof(entry)
+            || entry.check != journal_hash(data + pos + sizeof(entry.check), entry.length - sizeof(entry.check))
+            || entry.lsn <= last) {
+            break;
+        }
+
+        journal_record rec;
+        rec.lsn = entry.lsn;
+        rec.op = (journal_op)entry.op;
+        rec.mode = entry.mode;
+        rec.uid = entry.uid;
+        rec.gid = entry.gid;
+        rec.rdev = entry.rdev;
+        rec.size = entry.size;
+        rec.atime = entry.atime;
+        rec.mtime = entry.mtime;
+        rec.path = data + pos + sizeof(entry);
+        rec.newpath = rec.path + entry.pathLength + 1;
+        if (rec.lsn > applied) {
+            apply(&rec);
+            count++;
+        }
+        last = entry.lsn;
+        pos += entry.length;
+    }
+
+    // 일부만 기록된 마지막 기록 제거
+    if (pos < length) {
+        fprintf(stderr, "asdfs_journal_replay: discarding %zu bytes of incomplete records\n", length - pos);
+        if (ftruncate(journal_fd, (off_t)pos) != 0) {
+            journal_failed = 1;
+        }
+    }
+    free(data);
+
+    // 이후 기록 번호는 journal과 볼륨에 반영된 기록 번호 다음부터
+    journal_next = (last > applied ? last : applied) + 1;
+    journal_durable = journal_next - 1;
+    journal_started = 1;
+    return count;
+}
+
+// buffer 뒤에 length 바이트 공간 확보, 실패하면 NULL
+static char *journal_reserve(journal_buffer *buffer, size_t length) {
+    if (buffer->length + length > buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+        while (capacity < buffer->length + length) {
+            capacity *= 2;
+        }
+        char *data = (char *)realloc(buffer->data, capacity);
+        if (data == NULL) {
+            return NULL;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+    char *out = buffer->data + buffer->length;
+    buffer->length += length;
+    return out;
+}
+
+// rec를 journal 버퍼에 추가하고 기록 번호 반환
+uint64_t journal_append(journal_record *rec) {
+    journal_entry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.op = rec->op;
+    entry.mode = rec->mode;
+    entry.uid = rec->uid;
+    entry.gid = rec->gid;
+    entry.rdev = rec->rdev;
+    entry.size = rec->size;
+    entry.atime = rec->atime;
+    entry.mtime = rec->mtime;
+    entry.pathLength = (uint32_t)strlen(rec->path);
+    entry.newpathLength = rec->newpath ? (uint32_t)strlen(rec->newpath) : 0;
+    entry.length = (uint32_t)((sizeof(entry) + entry.pathLength + entry.newpathLength + 2 + 7) / 8 * 8);
+
+    pthread_mutex_lock(&journal_lock);
+    char *out = journal_reserve(&journal_pending, entry.length);
+    if (out == NULL) {
+        // 기록할 수 없으면 이후 commit 전부 실패
+        journal_failed = 1;
+        pthread_mutex_unlock(&journal_lock);
+        return rec->lsn = journal_next;
+    }
+
+    // 기록 번호는 버퍼에 추가한 순서
+    entry.lsn = journal_next++;
+    memset(out, 0, entry.length);
+    memcpy(out, &entry, sizeof(entry));
+    memcpy(out + sizeof(entry), rec->path, entry.pathLength);
+    if (rec->newpath) {
+        memcpy(out + sizeof(entry) + entry.pathLength + 1, rec->newpath, entry.newpathLength);
+    }
+    uint32_t check = journal_hash(out + sizeof(entry.check), entry.length - sizeof(entry.check));
+    memcpy(out, &check, sizeof(check));
+    journal_counter.records++;
+    pthread_mutex_unlock(&journal_lock);
+
+    return rec->lsn = entry.lsn;
+}
+
+// buffer 내용을 journal 파일에 쓰고 디스크에 기록, 실패하면 -1 반환
+static int journal_flush(journal_buffer *buffer) {
+    size_t done = 0;
+    while (done < buffer->length) {
+        ssize_t written = write(journal_fd, buffer->data + done, buffer->length - done);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            fprintf(stderr, "asdfs_journal_flush: %s\n", strerror(errno));
+            return -1;
+        }
+        done += (size_t)written;
+    }
+    if (fdatasync(journal_fd) != 0) {
+        fprintf(stderr, "asdfs_journal_flush: %s\n", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+// lsn까지의 기록이 디스크에 기록될 때까지 대기
+int journal_commit(uint64_t lsn) {
+    if (!journal_started) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&journal_lock);
+    journal_counter.commits++;
+    while (journal_durable < lsn && !journal_failed) {
+        // 다른 스레드가 쓰는 중이면 끝날 때까지 대기, 그동안 추가된 기록은 다음 쓰기에 함께 기록
+        if (journal_syncing) {
+            pthread_cond_wait(&journal_cond, &journal_lock);
+            continue;
+        }
+
+        // 지금까지 추가된 기록 전부를 이 스레드가 기록
+        journal_syncing = 1;
+        uint64_t last = journal_next - 1;
+        journal_buffer buffer = journal_writing;
+        journal_writing = journal_pending;
+        journal_pending = buffer;
+        journal_pending.length = 0;
+        pthread_mutex_unlock(&journal_lock);
+
+        int result = journal_flush(&journal_writing);
+
+        pthread_mutex_lock(&journal_lock);
+        journal_writing.length = 0;
+        journal_syncing = 0;
+        journal_counter.syncs++;
+        if (result == 0) {
+            journal_durable = last;
+        }
+        else {
+            journal_failed = 1;
+        }
+        pthread_cond_broadcast(&journal_cond);
+    }
+    int result = journal_durable >= lsn ? 0 : -1;
+    pthread_mutex_unlock(&journal_lock);
+    return result;
+}
+
+// 마지막으로 추가한 기록 번호 반환
+uint64_t journal_last() {
+    pthread_mutex_lock(&journal_lock);
+    uint64_t last = journal_next - 1;
+    pthread_mutex_unlock(&journal_lock);
+    return last;
+}
+
+// 볼륨이 디스크에 기록된 뒤 journal 비우기
+void journal_reset() {
+    if (journal_fd < 0) {
+        return;
+    }
+    pthread_mutex_lock(&journal_lock);
+    while (journal_syncing) {
+        pthread_cond_wait(&journal_cond, &journal_lock);
+    }
+    // 기록 번호는 볼륨에 반영된 번호에 이어서 계속 증가
+    journal_pending.length = 0;
+    journal_durable = journal_next - 1;
+    if (ftruncate(journal_fd, 0) != 0 || fdatasync(journal_fd) != 0) {
+        fprintf(stderr, "asdfs_journal_reset: %s\n", strerror(errno));
+    }
+    pthread_mutex_unlock(&journal_lock);
+}
+
+// lsn까지의 기록이 볼륨과 함께 디스크에 기록된 뒤 journal에서 제거
+// 이후 기록이 있으면 임시 파일에 옮겨 쓴 뒤 journal 파일과 교체
+void journal_trim(uint64_t lsn) {
+    if (journal_fd < 0 || journal_path == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&journal_lock);
+    while (journal_syncing) {
+        pthread_cond_wait(&journal_cond, &journal_lock);
+    }
+
+    // 파일 전체 읽기
+    struct stat st;
+    char *data = NULL;
+    size_t length = 0;
+    if (fstat(journal_fd, &st) == 0 && st.st_size > 0) {
+        data = (char *)malloc((size_t)st.st_size);
+        if (data != NULL && pread(journal_fd, data, (size_t)st.st_size, 0) == st.st_size) {
+            length = (size_t)st.st_size;
+        }
+    }
+
+    // lsn보다 큰 첫 기록 위치
+    size_t pos = 0;
+    while (length - pos >= sizeof(journal_entry)) {
+        journal_entry entry;
+        memcpy(&entry, data + pos, sizeof(entry));
+        if (entry.lsn > lsn || entry.length < sizeof(entry) || entry.length > length - pos) {
+            break;
+        }
+        pos += entry.length;
+    }
+
+    if (pos > 0 && pos == length) {
+        // 남은 기록이 없으면 비우기
+        if (ftruncate(journal_fd, 0) != 0 || fdatasync(journal_fd) != 0) {
+            fprintf(stderr, "asdfs_journal_trim: %s\n", strerror(errno));
+        }
+    }
+    else if (pos > 0) {
+        // 남은 기록을 임시 파일에 기록한 뒤 journal 파일과 교체
+        size_t size = strlen(journal_path);
+        char *temp = (char *)malloc(size + sizeof(".tmp"));
+        int fd = -1;
+        if (temp != NULL) {
+            memcpy(temp, journal_path, size);
+            memcpy(temp + size, ".tmp", sizeof(".tmp"));
+            fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        }
+        if (fd >= 0 && write(fd, data + pos, length - pos) == (ssize_t)(length - pos) && fdatasync(fd) == 0
+            && rename(temp, journal_path) == 0) {
+            close(fd);
+            fd = open(journal_path, O_RDWR | O_APPEND);
+            if (fd >= 0) {
+                close(journal_fd);
+                journal_fd = fd;
+            }
+            else {
+                // 교체한 파일을 열지 못하면 이후 기록이 남지 않으므로 commit 전부 실패
+                journal_failed = 1;
+            }
+        }
+        else {
+            fprintf(stderr, "asdfs_journal_trim: %s\n", strerror(errno));
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+        free(temp);
+    }
+    free(data);
+    pthread_mutex_unlock(&journal_lock);
+}
+
+// journal 통계 반환
+journal_stats get_journal_stats() {
+    pthread_mutex_lock(&journal_lock);
+    journal_stats stats = journal_counter;
+    pthread_mutex_unlock(&journal_lock);
+    return stats;
+}
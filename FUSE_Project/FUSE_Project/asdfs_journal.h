@@ -0,0 +1,75 @@
+#ifndef __ASDFS_JOURNAL_H__
+#define __ASDFS_JOURNAL_H__
+
+#include <stdint.h>
+
+// 메타데이터 변경 종류
+typedef enum journal_op {
+    JOURNAL_MKDIR = 1, // 디렉터리 생성: path, mode, uid, gid, time
+    JOURNAL_MKNOD,     // 파일 생성: path, mode, rdev, uid, gid, time
+    JOURNAL_UNLINK,    // 파일 삭제: path
+    JOURNAL_RMDIR,     // 디렉터리 삭제: path
+    JOURNAL_RENAME,    // 파일 이동: path, newpath
+    JOURNAL_CHMOD,     // 파일 권한 변경: path, mode
+    JOURNAL_CHOWN,     // 파일 소유자 변경: path, uid, gid
+    JOURNAL_TRUNCATE,  // 파일 크기 변경: path, size
+    JOURNAL_UTIMENS,   // 시간 변경: path, atime, mtime
+    JOURNAL_EXTEND     // 쓰기로 늘어난 파일 크기: path, size (다시 적용할 때 더 작아지지는 않음)
+} journal_op;
+
+// 메타데이터 변경 기록 하나
+typedef struct journal_record journal_record;
+struct journal_record {
+    uint64_t lsn;        // 기록 번호, journal_append에서 지정
+    journal_op op;       // 변경 종류
+    uint32_t mode;       // 파일 모드
+    uint32_t uid;        // 소유자 uid
+    uint32_t gid;        // 소유자 gid
+    uint64_t rdev;       // 기기 ID
+    int64_t size;        // 파일 크기
+    int64_t atime;       // 파일 최근 사용 시간 (생성 시 생성 시간)
+    int64_t mtime;       // 파일 최근 수정 시간 (생성 시 생성 시간)
+    const char *path;    // 변경한 path
+    const char *newpath; // 이동한 path (JOURNAL_RENAME)
+};
+
+// journal 통계
+typedef struct journal_stats journal_stats;
+struct journal_stats {
+    unsigned long records; // 추가한 기록 개수
+    unsigned long commits; // 디스크 기록을 기다린 요청 개수
+    unsigned long syncs;   // fdatasync 횟수
+};
+
+// path의 journal 파일 열기, 없으면 생성, 실패하면 -1 반환
+// journal_replay 전까지는 기록을 추가하지 않음
+int journal_open(const char *path);
+
+// journal에 기록을 추가하는 중인지 여부
+int journal_active();
+
+// lsn이 applied보다 큰 기록을 순서대로 apply에 전달, 전달한 개수 반환
+// 이후 journal_append로 기록 추가 가능
+unsigned long journal_replay(uint64_t applied, void (*apply)(const journal_record *rec));
+
+// rec를 journal 버퍼에 추가하고 기록 번호 반환
+// 디스크에 기록된 것은 아니므로 응답 전에 journal_commit 필요
+uint64_t journal_append(journal_record *rec);
+
+// lsn까지의 기록이 디스크에 기록될 때까지 대기, 실패하면 -1 반환
+// 동시에 기다리는 요청의 기록은 fdatasync 한 번으로 함께 기록 (group commit)
+int journal_commit(uint64_t lsn);
+
+// 마지막으로 추가한 기록 번호 반환
+uint64_t journal_last();
+
+// 볼륨이 디스크에 기록된 뒤 journal 비우기 (checkpoint)
+void journal_reset();
+
+// lsn까지의 기록이 볼륨과 함께 디스크에 기록된 뒤 journal에서 제거 (incremental checkpoint)
+void journal_trim(uint64_t lsn);
+
+// journal 통계 반환
+journal_stats get_journal_stats();
+
+#endif
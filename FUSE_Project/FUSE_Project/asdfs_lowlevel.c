@@ -0,0 +1,909 @@
+#include "asdfs_lowlevel.h"
+#include "asdfs_internal.h"
+#include "asdfs_ioctl.h"
+#include <unistd.h>
+
+#define LL_ENTRY_TIMEOUT 1.0 // 커널이 lookup 결과를 캐시하는 시간 (초)
+#define LL_ATTR_TIMEOUT  1.0 // 커널이 파일 정보를 캐시하는 시간 (초)
+
+static struct asdfs_ll_config ll_config;     // 마운트 옵션으로 받은 설정
+static unsigned long ll_negative_entries;    // 커널에 없는 이름으로 응답한 횟수
+static int ll_read_splice;                   // 읽기 응답을 splice로 보낼 수 있는지 여부
+
+// fuse_ino_t를 inode 객체 포인터로 변환
+// fuse_ino_t는 inode 번호 (root는 ROOT_INODE_ID == FUSE_ROOT_ID)
+static inode *ll_inode(fuse_ino_t ino) {
+    return get_inode((inode_id)ino);
+}
+
+// inode 객체 포인터를 fuse_ino_t로 변환
+static fuse_ino_t ll_ino(inode *node) {
+    return node->id;
+}
+
+// asdfs 에러 코드의 주요 오류 번호를 errno로 변환
+static int ll_errno(asdfs_errno code) {
+    switch (code & 0xFFFF) {
+        case NO_ERROR:           // 오류 없음
+        case EXACT_FOUND:        // 위치에 inode 있음
+            return 0;
+
+        case EXACT_NOT_FOUND:    // 위치에 inode 없음
+        case HEAD_NOT_FOUND:     // head 없음
+            return ENOENT;       // No such file or directory
+
+        case HEAD_NOT_DIRECTORY: // head가 디렉터리가 아님
+            return ENOTDIR;      // Not a directory
+
+        case HEAD_NO_PERMISSION: // head를 탐색할 권한이 없음
+            return EACCES;       // Permission denied
+
+        case NO_FREE_SPACE:      // 남은 용량 없음
+            return ENOSPC;       // No space left on device
+
+        case GENERAL_ERROR:      // 그 외
+        default:
+            return EIO;          // Input/output error
+    }
+}
+
+// node를 lookup 결과로 응답하고 커널 참조 횟수 증가
+static void ll_reply_entry(fuse_req_t req, inode *node) {
+    struct fuse_entry_param entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.ino = ll_ino(node);
+    entry.attr = get_attr(node);
+    entry.attr_timeout = LL_ATTR_TIMEOUT;
+    entry.entry_timeout = LL_ENTRY_TIMEOUT;
+
+    ref_inode(node);
+    // 요청이 중단되어 응답이 전달되지 않은 경우 참조 취소
+    if (fuse_reply_entry(req, &entry) != 0) {
+        forget_inode(node, 1);
+    }
+}
+
+// 파일 시스템 초기화
+void asdfs_ll_init (void *userdata, struct fuse_conn_info *conn) {
+    fprintf(stderr, "asdfs_ll_init\n");
+
+    // 마운트 옵션 설정 저장
+    if (userdata) {
+        ll_config = *(struct asdfs_ll_config *)userdata;
+    }
+
+    // 마운트한 프로세스의 umask
+    mode_t mask = umask(0);
+    umask(mask);
+
+    // 내부 root/superblock 초기화 함수 호출
+    init_root_superblock(getuid(), getgid(), mask);
+
+    // 주기적으로 바뀐 부분만 이미지 파일에 기록
+    start_checkpoint(NULL);
+
+    // 오래 사용하지 않은 블록을 주기적으로 압축
+    start_compress();
+
+    // 블록 메모리가 예산을 넘으면 오래 사용하지 않은 블록을 파일로 내림
+    start_spill();
+
+    // 쓰기 요청의 데이터를 /dev/fuse에서 pipe로 splice하여 write_buf로 전달
+    // 읽기 응답은 블록 영역 fd에서 /dev/fuse로 splice
+    conn->want |= conn->capable & (FUSE_CAP_SPLICE_READ | FUSE_CAP_SPLICE_MOVE | FUSE_CAP_SPLICE_WRITE);
+    ll_read_splice = (conn->want & FUSE_CAP_SPLICE_WRITE) != 0;
+}
+
+// 파일 시스템 해제
+void asdfs_ll_destroy (void *userdata) {
+    fprintf(stderr, "asdfs_ll_destroy\n");
+
+    // 이미지 파일을 사용하면 디스크에 기록
+    close_volume();
+}
+
+// 파일 시스템 정보 조회
+void asdfs_ll_statfs (fuse_req_t req, fuse_ino_t ino) {
+    fprintf(stderr, "asdfs_ll_statfs\n");
+
+    // 내부 superblock 메타데이터 반환
+    struct statvfs buf = get_superblock();
+    fuse_reply_statfs(req, &buf);
+
+    // 없는 이름 응답 통계 출력
+    fprintf(stderr, "asdfs_ll_statfs negative entries %lu\n", ll_negative_entries);
+
+    // 블록 사용량 출력: 파일 기준 (logical)과 볼륨 기준 (physical), 공유와 중복 제거로 줄어든 비율
+    dedup_stats dstats = get_dedup_stats();
+    fprintf(stderr, "asdfs_ll_statfs blocks logical %lu physical %lu ratio %.2f dedup hashed %lu hit %lu indexed %lu\n",
+            (unsigned long)dstats.logical, (unsigned long)dstats.physical, dstats.ratio,
+            dstats.hashed, dstats.hit, dstats.indexed);
+
+    // 블록 압축 통계 출력
+    zip_stats zstats = get_zip_stats();
+    fprintf(stderr, "asdfs_ll_statfs compress blocks %lu bytes %lu packs %lu cache hit %lu miss %lu expanded %lu moved %lu\n",
+            zstats.blocks, (unsigned long)zstats.bytes, zstats.packs, zstats.hit, zstats.miss, zstats.expanded, zstats.moved);
+
+    // 블록 내보내기 통계 출력
+    spill_stats sstats = get_spill_stats();
+    fprintf(stderr, "asdfs_ll_statfs spill budget %lu resident %lu out %lu spilled %lu fetched %lu passes %lu\n",
+            (unsigned long)sstats.budget, (unsigned long)sstats.resident, sstats.out, sstats.spilled, sstats.fetched, sstats.passes);
+}
+
+// parent 아래의 name 검색
+void asdfs_ll_lookup (fuse_req_t req, fuse_ino_t parent, const char *name) {
+    fprintf(stderr, "asdfs_ll_lookup %lu %s\n", parent, name);
+    set_request(req);
+
+    // 검색과 응답이 끝날 때까지 이름 공간 변경 대기
+    NAMESPACE_READ();
+
+    // parent 아래에서 name에 해당하는 inode 검색
+    search_result res;
+    asdfs_errno code = lookup_inode(ll_inode(parent), name, &res);
+
+    // 없는 이름은 negative_timeout 동안 커널이 캐시하도록 inode 번호 0으로 응답
+    if ((code & 0xFFFF) == EXACT_NOT_FOUND && ll_config.negative_timeout > 0) {
+        struct fuse_entry_param entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.ino = 0;
+        entry.entry_timeout = ll_config.negative_timeout;
+        __sync_fetch_and_add(&ll_negative_entries, 1);
+        fuse_reply_entry(req, &entry);
+        return;
+    }
+
+    if ((code & 0xFFFF) != EXACT_FOUND) {
+        fuse_reply_err(req, ll_errno(code));
+        return;
+    }
+
+    // 찾은 inode 반환
+    ll_reply_entry(req, res.exact);
+}
+
+// 커널의 inode 참조 해제
+void asdfs_ll_forget (fuse_req_t req, fuse_ino_t ino, unsigned long nlookup) {
+    fprintf(stderr, "asdfs_ll_forget %lu %lu\n", ino, nlookup);
+
+    forget_inode(ll_inode(ino), nlookup);
+    fuse_reply_none(req);
+}
+
+// 커널의 여러 inode 참조 해제
+void asdfs_ll_forget_multi (fuse_req_t req, size_t count, struct fuse_forget_data *forgets) {
+    fprintf(stderr, "asdfs_ll_forget_multi %zu\n", count);
+
+    for (size_t i=0; i<count; i++) {
+        forget_inode(ll_inode(forgets[i].ino), forgets[i].nlookup);
+    }
+    fuse_reply_none(req);
+}
+
+// 파일 정보 조회
+void asdfs_ll_getattr (fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+    fprintf(stderr, "asdfs_ll_getattr %lu\n", ino);
+
+    // inode의 attr 구조체 반환
+    struct stat attr = get_attr(ll_inode(ino));
+    fuse_reply_attr(req, &attr, LL_ATTR_TIMEOUT);
+}
+
+// 파일 권한, 소유자, 크기, 시간 변경
+void asdfs_ll_setattr (fuse_req_t req, fuse_ino_t ino, struct stat *attr, int to_set, struct fuse_file_info *fi) {
+    fprintf(stderr, "asdfs_ll_setattr %lu %X\n", ino, to_set);
+    set_request(req);
+
+    // 변경이 끝날 때까지 checkpoint 대기
+    CHECKPOINT_HOLD();
+
+    // inode에 대한 권한 확인
+    inode *node = ll_inode(ino);
+    search_result res;
+    asdfs_errno code = access_inode(node, &res);
+
+    // 변경 전에 모든 요청 항목에 대한 권한 검사
+    if ((to_set & FUSE_SET_ATTR_MODE)       // 권한 변경 요청이며
+        && !(code & IS_OWNER)) {            // 호출 프로세스가 owner가 아니면
+        fuse_reply_err(req, EPERM);         // Operation not permitted
+        return;
+    }
+
+    if ((to_set & (FUSE_SET_ATTR_UID | FUSE_SET_ATTR_GID)) // 소유자 변경 요청이며
+        && fuse_req_ctx(req)->uid != 0) {                  // 호출 프로세스가 superuser가 아닌 경우
+        fuse_reply_err(req, EPERM);                        // Operation not permitted
+        return;
+    }
+
+    if (to_set & FUSE_SET_ATTR_SIZE) {         // 크기 변경 요청이며
+        if (node->mode & S_IFDIR) {    // node가 디렉터리인 경우
+            fuse_reply_err(req, EISDIR);       // Is a directory
+            return;
+        }
+        if (!(code & CAN_WRITE_EXACT)) {       // node에 쓰기 권한이 없는 경우
+            fuse_reply_err(req, EACCES);       // Permission denied
+            return;
+        }
+    }
+
+    // 크기 변경: node에 data 공간 할당
+    if (to_set & FUSE_SET_ATTR_SIZE) {
+        code = alloc_data_inode(node, attr->st_size);
+        if ((code & 0xFFFF) != NO_ERROR) {
+            fuse_reply_err(req, ll_errno(code));
+            return;
+        }
+    }
+
+    // 권한 변경: 파일 종류는 유지
+    if (to_set & FUSE_SET_ATTR_MODE) {
+        node->mode = (node->mode & S_IFMT) | (attr->st_mode & ~S_IFMT);
+    }
+
+    // 소유자 변경
+    if (to_set & FUSE_SET_ATTR_UID) {
+        node->uid = attr->st_uid;
+    }
+    if (to_set & FUSE_SET_ATTR_GID) {
+        node->gid = attr->st_gid;
+    }
+
+    // 디렉터리 탐색 권한이 바뀌므로 하위 path의 dentry cache 무효화
+    if ((to_set & (FUSE_SET_ATTR_MODE | FUSE_SET_ATTR_UID | FUSE_SET_ATTR_GID)) && (node->mode & S_IFDIR)) {
+        dcache_invalidate_all();
+    }
+
+    // 시간 변경
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    if (to_set & FUSE_SET_ATTR_ATIME) {
+        get_cold(node)->atime = attr->st_atime;  // 파일 최근 사용 시간
+    }
+    if (to_set & FUSE_SET_ATTR_ATIME_NOW) {
+        get_cold(node)->atime = now.tv_sec;
+    }
+    if (to_set & FUSE_SET_ATTR_MTIME) {
+        get_cold(node)->mtime = attr->st_mtime;  // 파일 최근 수정 시간
+    }
+    if (to_set & FUSE_SET_ATTR_MTIME_NOW) {
+        get_cold(node)->mtime = now.tv_sec;
+    }
+
+    // 변경된 attr 구조체 반환
+    dirty_inode(node);
+    struct stat new_attr = get_attr(node);
+    fuse_reply_attr(req, &new_attr, LL_ATTR_TIMEOUT);
+}
+
+// parent 아래에 name, attr로 새로운 inode 생성 후 응답
+// 일반 파일이면 data 공간도 할당
+static void ll_create(fuse_req_t req, fuse_ino_t parent, const char *name, struct stat attr) {
+    // 변경이 끝날 때까지 checkpoint, 다른 요청의 이름 검색과 변경 대기
+    CHECKPOINT_HOLD();
+    NAMESPACE_WRITE();
+
+    // parent 아래에서 name에 해당하는 inode 검색
+    search_result res;
+    asdfs_errno code = lookup_inode(ll_inode(parent), name, &res);
+
+    // code 주요 오류 번호 검사
+    switch (code & 0xFFFF) {
+        case EXACT_FOUND:               // name 위치에 inode 있음
+            fuse_reply_err(req, EEXIST); // File exists
+            return;
+
+        case EXACT_NOT_FOUND:           // name 위치에 inode 없음
+            break;                      // 계속 진행 ->
+
+        default:
+            fuse_reply_err(req, ll_errno(code));
+            return;
+    }
+
+    // code 보조 비트 마스크 검사
+    if (!(code & CAN_WRITE_PARENT)) {   // parent에 쓰기 권한이 없는 경우
+        fuse_reply_err(req, EACCES);    // Permission denied
+        return;
+    }
+
+    // 새로운 inode 생성
+    inode *node = NULL;
+    code = create_inode(&res, attr, &node);
+    if ((code & 0xFFFF) != NO_ERROR) {
+        fuse_reply_err(req, ll_errno(code));
+        return;
+    }
+
+    // 일반 파일인 경우 node에 data 공간 할당
+    if (!(attr.st_mode & S_IFDIR)) {
+        code = alloc_data_inode(node, 0);
+        if ((code & 0xFFFF) != NO_ERROR) {
+            destroy_inode(node); // inode 삭제
+            fuse_reply_err(req, ll_errno(code));
+            return;
+        }
+    }
+
+    // 새로운 inode를 res 위치에 삽입
+    insert_inode(res, node);
+    ll_reply_entry(req, node);
+}
+
+// 디렉터리 생성
+void asdfs_ll_mkdir (fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode) {
+    fprintf(stderr, "asdfs_ll_mkdir %lu %s %X\n", parent, name, mode);
+    set_request(req);
+
+    // 요청의 호출 프로세스 uid, gid.
+    const struct fuse_ctx *context = fuse_req_ctx(req);
+
+    // 현재 시간 가져오기
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    // 파일 메타데이터 생성
+    struct stat attr;
+    memset(&attr, 0, sizeof(struct stat)); // 0으로 리셋
+    attr.st_mode = S_IFDIR | mode; // 주어진 권한에 디렉터리 플래그 포함
+    attr.st_nlink = 1;             // 최초 링크는 1개
+    attr.st_uid = context->uid;    // 호출 프로세스의 uid를 소유자로 지정
+    attr.st_gid = context->gid;    // 호출 프로세스의 gid를 그룹으로 지정
+    attr.st_atime = now.tv_sec;    // 파일 최근 사용 시간
+    attr.st_mtime = now.tv_sec;    // 파일 최근 수정 시간
+    attr.st_ctime = now.tv_sec;    // 파일 최근 상태 변화 시간
+
+    ll_create(req, parent, name, attr);
+}
+
+// parent 아래의 name 삭제, 디렉터리 여부 is_dir
+static void ll_remove(fuse_req_t req, fuse_ino_t parent, const char *name, int is_dir) {
+    // 변경이 끝날 때까지 checkpoint, 다른 요청의 이름 검색과 변경 대기
+    CHECKPOINT_HOLD();
+    NAMESPACE_WRITE();
+
+    // parent 아래에서 name에 해당하는 inode 검색
+    search_result res;
+    asdfs_errno code = lookup_inode(ll_inode(parent), name, &res);
+    if ((code & 0xFFFF) != EXACT_FOUND) {
+        fuse_reply_err(req, ll_errno(code));
+        return;
+    }
+
+    // code 보조 비트 마스크 검사
+    if (!(code & CAN_WRITE_PARENT)) {   // parent에 쓰기 권한이 없는 경우
+        fuse_reply_err(req, EACCES);    // Permission denied
+        return;
+    }
+
+    // inode 상태 검사
+    inode *exact = res.exact;
+
+    if (is_dir && !(exact->mode & S_IFDIR)) { // 디렉터리가 아닌 경우
+        fuse_reply_err(req, ENOTDIR);                 // Not a directory
+        return;
+    }
+
+    if (!is_dir && (exact->mode & S_IFDIR)) { // 디렉터리인 경우
+        fuse_reply_err(req, EISDIR);                  // Is a directory
+        return;
+    }
+
+    if (exact->firstChild) {            // exact에 자식 inode가 있을 경우
+        fuse_reply_err(req, ENOTEMPTY); // Directory not empty
+        return;
+    }
+
+    // path로 검색하는 요청 (복제 ioctl의 원본)이 삭제된 inode를 찾지 않도록 dentry cache 무효화
+    // low-level 요청에는 path가 없으므로 전체 무효화
+    dcache_invalidate_all();
+
+    // inode tree에서 분리, 커널이 참조하지 않으면 삭제
+    remove_inode(exact);
+    fuse_reply_err(req, 0);
+}
+
+// 디렉터리 삭제
+void asdfs_ll_rmdir (fuse_req_t req, fuse_ino_t parent, const char *name) {
+    fprintf(stderr, "asdfs_ll_rmdir %lu %s\n", parent, name);
+    set_request(req);
+
+    ll_remove(req, parent, name, 1);
+}
+
+// 디렉터리 열기
+void asdfs_ll_opendir (fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+    fprintf(stderr, "asdfs_ll_opendir %lu\n", ino);
+    set_request(req);
+
+    // inode에 대한 권한 확인
+    search_result res;
+    asdfs_errno code = access_inode(ll_inode(ino), &res);
+
+    if (!(res.exact->mode & S_IFDIR)) { // exact가 디렉터리가 아닌 경우
+        fuse_reply_err(req, ENOTDIR);           // Not a directory
+        return;
+    }
+
+    // code 보조 비트 마스크 검사
+    if (!(code & CAN_READ_EXACT)) {  // exact에 읽기 권한이 없는 경우
+        fuse_reply_err(req, EACCES); // Permission denied
+        return;
+    }
+
+    fuse_reply_open(req, fi);
+}
+
+// 디렉터리 읽기
+void asdfs_ll_readdir (fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info *fi) {
+    fprintf(stderr, "asdfs_ll_readdir %lu %zu %zu\n", ino, size, off);
+
+    // 목록을 다 읽을 때까지 이름 공간 변경 대기
+    NAMESPACE_READ();
+
+    inode *node = ll_inode(ino);
+    char *buf = (char *)malloc(size);
+    if (buf == NULL) {
+        fuse_reply_err(req, ENOMEM);
+        return;
+    }
+
+    // ".", ".." 다음 node의 자식을 rightSibling 순서로
+    // off 다음 항목부터 buf가 찰 때까지 추가
+    // 각 항목의 offset은 다음 readdir에서 이어서 읽을 위치 (cookie)
+    size_t pos = 0;
+    inode *child = off < 2 ? get_inode(node->firstChild) : seek_child(node, off);
+    for (off_t index = off < 2 ? off : 2; ; index++) {
+        const char *name;
+        off_t next;
+        struct stat attr;
+        memset(&attr, 0, sizeof(attr));
+
+        if (index == 0) {
+            name = ".";
+            next = 1;
+            attr.st_ino = ll_ino(node);
+            attr.st_mode = S_IFDIR;
+        }
+        else if (index == 1) {
+            name = "..";
+            next = 2;
+            attr.st_ino = node->parent ? node->parent : node->id;
+            attr.st_mode = S_IFDIR;
+        }
+        else if (child) {
+            name = get_name(child);
+            next = child_cookie(child);
+            attr = get_attr(child);
+            attr.st_ino = ll_ino(child);
+            child = get_inode(child->rightSibling);
+        }
+        else {
+            break;
+        }
+
+        // buf가 가득 차면 중단
+        size_t entry_size = fuse_add_direntry(req, buf + pos, size - pos, name, &attr, next);
+        if (entry_size > size - pos) {
+            break;
+        }
+        pos += entry_size;
+    }
+
+    fuse_reply_buf(req, buf, pos);
+    free(buf);
+}
+
+// 파일 생성
+void asdfs_ll_mknod (fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode, dev_t rdev) {
+    fprintf(stderr, "asdfs_ll_mknod %lu %s %X\n", parent, name, mode);
+    set_request(req);
+
+    // 요청 상태 검사
+    if (!(mode & S_IFREG)) {          // 요청된 파일 mode가 일반 파일이 아닌 경우
+        fuse_reply_err(req, ENOSYS);  // Function not implemented
+        return;
+    }
+
+    // 요청의 호출 프로세스 uid, gid.
+    const struct fuse_ctx *context = fuse_req_ctx(req);
+
+    // 현재 시간 가져오기
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    // 파일 메타데이터 생성
+    struct stat attr;
+    memset(&attr, 0, sizeof(struct stat)); // 0으로 리셋
+    attr.st_mode = mode;        // 주어진 권한 지정
+    attr.st_nlink = 1;          // 최초 링크는 1개
+    attr.st_uid = context->uid; // 호출 프로세스의 uid를 소유자로 지정
+    attr.st_gid = context->gid; // 호출 프로세스의 gid를 그룹으로 지정
+    attr.st_rdev = rdev;        // 지정된 기기 ID 지정
+    attr.st_atime = now.tv_sec; // 파일 최근 사용 시간
+    attr.st_mtime = now.tv_sec; // 파일 최근 수정 시간
+    attr.st_ctime = now.tv_sec; // 파일 최근 상태 변화 시간
+
+    ll_create(req, parent, name, attr);
+}
+
+// 파일 삭제
+void asdfs_ll_unlink (fuse_req_t req, fuse_ino_t parent, const char *name) {
+    fprintf(stderr, "asdfs_ll_unlink %lu %s\n", parent, name);
+    set_request(req);
+
+    ll_remove(req, parent, name, 0);
+}
+
+// 파일 열기
+void asdfs_ll_open (fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+    fprintf(stderr, "asdfs_ll_open %lu\n", ino);
+    set_request(req);
+
+    // inode에 대한 권한 확인
+    search_result res;
+    asdfs_errno code = access_inode(ll_inode(ino), &res);
+
+    if (res.exact->mode & S_IFDIR) { // exact가 디렉터리인 경우
+        fuse_reply_err(req, EISDIR);         // Is a directory
+        return;
+    }
+
+    // open 요청 파일 상태 flag에 필요한 권한 확인
+    int accmode = fi->flags & O_ACCMODE;
+    int can_read = code & CAN_READ_EXACT;
+    int can_write = code & CAN_WRITE_EXACT;
+    if (!(
+            // 읽기 전용 요청이며 exact에 읽기 권한이 있거나
+            (accmode == O_RDONLY && can_read)
+            // 쓰기 전용 요청이며 exact에 쓰기 권한이 있거나
+            || (accmode == O_WRONLY && can_write)
+            // 읽기 및 쓰기 요청이며 exact에 읽기 권한과 쓰기 권한이 있는 경우가
+            || (accmode == O_RDWR && can_read && can_write)
+        )) { // 아닌 경우,
+        fuse_reply_err(req, EACCES); // Permission denied
+        return;
+    }
+
+    fuse_reply_open(req, fi);
+}
+
+// node data의 off부터 size 바이트를 버퍼 하나로 복사하여 응답
+static void ll_read_copy(fuse_req_t req, inode *node, size_t size, off_t off) {
+    char *mem = (char *)malloc(size ? size : 1);
+    if (mem == NULL) {
+        fuse_reply_err(req, ENOMEM);
+        return;
+    }
+    fuse_reply_buf(req, mem, read_data_inode(node, mem, size, off));
+    free(mem);
+}
+
+// 파일 읽기
+void asdfs_ll_read (fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info *fi) {
+    fprintf(stderr, "asdfs_ll_read %lu %zu %zu\n", ino, size, off);
+
+    inode *node = ll_inode(ino);
+    if (node->mode & S_IFDIR) { // node가 디렉터리인 경우
+        fuse_reply_err(req, EISDIR);    // Is a directory
+        return;
+    }
+
+    // 파일 크기를 넘는 부분은 읽지 않음
+    off_t file_size = get_cold(node)->size;
+    if (off >= file_size) {
+        size = 0;
+    }
+    else if ((off_t)size > file_size - off) {
+        size = (size_t)(file_size - off);
+    }
+
+    // data의 offset부터 (offset + size)까지 블록 영역의 (fd, 위치)를 splice로 응답
+    // 압축된 블록은 가리킬 수 없으므로 버퍼 하나로 복사하여 응답
+    int count = (int)(size / DATA_BLOCK_SIZE) + 2;
+    if (ll_read_splice) {
+        struct fuse_bufvec *vec = (struct fuse_bufvec *)malloc(sizeof(struct fuse_bufvec) + sizeof(struct fuse_buf) * (count - 1));
+        if (vec == NULL) {
+            fuse_reply_err(req, ENOMEM);
+            return;
+        }
+        *vec = (struct fuse_bufvec)FUSE_BUFVEC_INIT(0);
+        vec->count = map_buf_data_inode(node, off, size, vec->buf, count);
+        if (fuse_buf_size(vec) < size) {
+            ll_read_copy(req, node, size, off);
+        }
+        else {
+            fuse_reply_data(req, vec, FUSE_BUF_SPLICE_MOVE);
+        }
+        free(vec);
+        return;
+    }
+
+    // splice할 수 없으면 블록을 복사하지 않고 바로 응답
+    struct iovec *iov = (struct iovec *)malloc(sizeof(struct iovec) * count);
+    if (iov == NULL) {
+        fuse_reply_err(req, ENOMEM);
+        return;
+    }
+    count = map_data_inode(node, off, size, iov, count);
+    size_t length = 0;
+    for (int i=0; i<count; i++) {
+        length += iov[i].iov_len;
+    }
+    if (length < size) {
+        ll_read_copy(req, node, size, off);
+    }
+    else {
+        fuse_reply_iov(req, iov, count);
+    }
+    free(iov);
+}
+
+// 파일 쓰기
+void asdfs_ll_write (fuse_req_t req, fuse_ino_t ino, const char *mem, size_t size, off_t off, struct fuse_file_info *fi) {
+    fprintf(stderr, "asdfs_ll_write %lu %zu %zu\n", ino, size, off);
+
+    // 변경이 끝날 때까지 checkpoint 대기
+    CHECKPOINT_HOLD();
+
+    // data의 offset부터 (offset + size)까지 data로 복사
+    // 쓰기에서 요청한 (off + size)가 파일 크기보다 크면 크기 증가
+    inode *node = ll_inode(ino);
+    size_t written;
+    asdfs_errno code = write_data_inode(node, mem, size, off, &written);
+    // 일부라도 썼으면 쓴 바이트 수 반환 (남은 부분을 다시 요청하면 오류 반환)
+    if (written == 0 && (code & 0xFFFF) != NO_ERROR) {
+        fuse_reply_err(req, ll_errno(code));
+        return;
+    }
+
+    // 쓴 바이트 수 반환
+    fuse_reply_write(req, written);
+}
+
+// 파일 쓰기 (fuse_bufvec)
+void asdfs_ll_write_buf (fuse_req_t req, fuse_ino_t ino, struct fuse_bufvec *buf, off_t off, struct fuse_file_info *fi) {
+    fprintf(stderr, "asdfs_ll_write_buf %lu %zu %zu\n", ino, fuse_buf_size(buf), off);
+
+    // 변경이 끝날 때까지 checkpoint 대기
+    CHECKPOINT_HOLD();
+
+    // buf의 내용을 data의 offset부터 블록으로 바로 복사
+    // 쓰기에서 요청한 (off + size)가 파일 크기보다 크면 크기 증가
+    inode *node = ll_inode(ino);
+    size_t written;
+    asdfs_errno code = write_buf_data_inode(node, buf, off, &written);
+    // 일부라도 썼으면 쓴 바이트 수 반환 (남은 부분을 다시 요청하면 오류 반환)
+    if (written == 0 && (code & 0xFFFF) != NO_ERROR) {
+        fuse_reply_err(req, ll_errno(code));
+        return;
+    }
+
+    // 쓴 바이트 수 반환
+    fuse_reply_write(req, written);
+}
+
+// 파일 공간 할당 또는 hole 생성
+void asdfs_ll_fallocate (fuse_req_t req, fuse_ino_t ino, int mode, off_t off, off_t length, struct fuse_file_info *fi) {
+    fprintf(stderr, "asdfs_ll_fallocate %lu %X %zu %zu\n", ino, mode, off, length);
+
+    // 변경이 끝날 때까지 checkpoint 대기
+    CHECKPOINT_HOLD();
+
+    // 요청 상태 검사
+    inode *node = ll_inode(ino);
+    if (node->mode & S_IFDIR) {            // node가 디렉터리인 경우
+        fuse_reply_err(req, EISDIR);               // Is a directory
+        return;
+    }
+    if (off < 0 || length <= 0) {          // 범위가 잘못된 경우
+        fuse_reply_err(req, EINVAL);               // Invalid argument
+        return;
+    }
+    if ((mode & ~(FALLOC_FL_KEEP_SIZE | FALLOC_FL_PUNCH_HOLE))            // 지원하지 않는 모드이거나
+        || ((mode & FALLOC_FL_PUNCH_HOLE) && !(mode & FALLOC_FL_KEEP_SIZE))) { // 크기를 바꾸는 hole 생성인 경우
+        fuse_reply_err(req, EOPNOTSUPP);           // Operation not supported
+        return;
+    }
+
+    asdfs_errno code;
+    if (mode & FALLOC_FL_PUNCH_HOLE) {
+        code = punch_data_inode(node, off, length);
+    }
+    else {
+        // 범위의 블록 할당 후 파일 크기 유지 요청이 아니면 크기 증가
+        code = fill_data_inode(node, off, length);
+        if (code == NO_ERROR && !(mode & FALLOC_FL_KEEP_SIZE) && off + length > get_cold(node)->size) {
+            code = alloc_data_inode(node, off + length);
+        }
+    }
+
+    fuse_reply_err(req, ll_errno(code));
+}
+
+// 블록 공유로 src의 src_off부터 *length 바이트를 dst의 dst_off 위치에 복제할 수 있는지 검사
+// *length가 0이면 src 끝까지로 바꿈, 가능하면 0, 아니면 errno 반환 (FICLONERANGE와 같은 조건)
+static int ll_clone_check(inode *dst, off_t dst_off, inode *src, off_t src_off, off_t *length) {
+    off_t src_size = get_cold(src)->size;
+    off_t dst_size = get_cold(dst)->size;
+
+    if ((src->mode & S_IFDIR) || (dst->mode & S_IFDIR)) { // 디렉터리인 경우
+        return EISDIR;                   // Is a directory
+    }
+    if (src_off < 0 || dst_off < 0 || *length < 0 || src_off > src_size) { // 범위가 잘못된 경우
+        return EINVAL;                   // Invalid argument
+    }
+    if (*length == 0) {
+        *length = src_size - src_off;
+    }
+    if (*length > src_size - src_off) {  // 원본 끝을 넘는 경우
+        return EINVAL;                   // Invalid argument
+    }
+
+    // 시작 위치는 블록 단위, 끝은 블록 단위이거나 원본 끝이면서 대상 끝 이후여야 함
+    if (src_off % DATA_BLOCK_SIZE || dst_off % DATA_BLOCK_SIZE
+        || (*length % DATA_BLOCK_SIZE && (src_off + *length != src_size || dst_off + *length < dst_size))) {
+        return EINVAL;                   // Invalid argument
+    }
+
+    // 같은 파일에서 범위가 겹치는 경우
+    if (src == dst && src_off < dst_off + *length && dst_off < src_off + *length) {
+        return EINVAL;                   // Invalid argument
+    }
+    return 0;
+}
+
+// 블록 사용량과 중복 제거 통계를 ASDFS_IOC_BLOCK_STATS 응답 형식으로 반환
+static struct asdfs_block_stats ll_block_stats() {
+    dedup_stats dstats = get_dedup_stats();
+    struct asdfs_block_stats stats = { .logical = dstats.logical, .physical = dstats.physical, .ratio = dstats.ratio,
+                                       .hashed = dstats.hashed, .hit = dstats.hit, .indexed = dstats.indexed };
+    return stats;
+}
+
+// 파일 제어 요청: ASDFS_IOC_CLONE_RANGE (블록을 공유하는 파일 복제), ASDFS_IOC_BLOCK_STATS (블록 사용량 조회)
+void asdfs_ll_ioctl (fuse_req_t req, fuse_ino_t ino, int cmd, void *arg, struct fuse_file_info *fi, unsigned flags,
+                     const void *in_buf, size_t in_bufsz, size_t out_bufsz) {
+    fprintf(stderr, "asdfs_ll_ioctl %lu %X\n", ino, (unsigned)cmd);
+    set_request(req);
+
+    // 블록 사용량 조회
+    if ((unsigned)cmd == ASDFS_IOC_BLOCK_STATS) {
+        if (out_bufsz < sizeof(struct asdfs_block_stats)) {
+            fuse_reply_err(req, EINVAL);           // Invalid argument
+            return;
+        }
+        struct asdfs_block_stats stats = ll_block_stats();
+        fuse_reply_ioctl(req, 0, &stats, sizeof(stats));
+        return;
+    }
+
+    // 지원하지 않는 요청이거나 인자가 짧은 경우
+    if ((unsigned)cmd != ASDFS_IOC_CLONE_RANGE) {
+        fuse_reply_err(req, ENOTTY);               // Inappropriate ioctl for device
+        return;
+    }
+    if (in_bufsz < sizeof(struct asdfs_clone_range)) {
+        fuse_reply_err(req, EINVAL);               // Invalid argument
+        return;
+    }
+
+    // 변경이 끝날 때까지 checkpoint 대기, path 검색 중에는 이름 공간 변경 대기
+    CHECKPOINT_HOLD();
+    NAMESPACE_READ();
+
+    // 대상 파일 쓰기 권한 확인
+    inode *node = ll_inode(ino);
+    search_result res;
+    if (!(access_inode(node, &res) & CAN_WRITE_EXACT)) {
+        fuse_reply_err(req, EACCES);               // Permission denied
+        return;
+    }
+
+    // 원본 path에 해당하는 inode 검색
+    struct asdfs_clone_range range;
+    memcpy(&range, in_buf, sizeof(range));
+    range.src_path[sizeof(range.src_path) - 1] = '\0';
+    asdfs_errno code = find_inode(range.src_path, &res);
+    if ((code & 0xFFFF) != EXACT_FOUND) {
+        fuse_reply_err(req, ll_errno(code));
+        return;
+    }
+    if (!(code & CAN_READ_EXACT)) {                // 원본 읽기 권한이 없는 경우
+        fuse_reply_err(req, EACCES);               // Permission denied
+        return;
+    }
+
+    // 범위 검사
+    off_t length = (off_t)range.src_length;
+    int err = ll_clone_check(node, (off_t)range.dest_offset, res.exact, (off_t)range.src_offset, &length);
+    if (err != 0) {
+        fuse_reply_err(req, err);
+        return;
+    }
+
+    // 원본 블록을 대상 위치에서 공유
+    code = clone_data_inode(node, (off_t)range.dest_offset, res.exact, (off_t)range.src_offset, length);
+    if (code != NO_ERROR) {
+        fuse_reply_err(req, ll_errno(code));
+        return;
+    }
+    fuse_reply_ioctl(req, 0, NULL, 0);
+}
+
+// 파일 닫기 (파일을 연 마지막 file handle)
+void asdfs_ll_release (fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
+    fprintf(stderr, "asdfs_ll_release %lu\n", ino);
+
+    // 변경이 끝날 때까지 checkpoint 대기
+    CHECKPOINT_HOLD();
+
+    // 이어 쓰기용으로 예약하고 쓰지 않은 블록 반환
+    release_data_inode(ll_inode(ino));
+    fuse_reply_err(req, 0);
+}
+
+// 파일 이동
+void asdfs_ll_rename (fuse_req_t req, fuse_ino_t parent, const char *name, fuse_ino_t newparent, const char *newname) {
+    fprintf(stderr, "asdfs_ll_rename %lu %s %lu %s\n", parent, name, newparent, newname);
+    set_request(req);
+
+    // 변경이 끝날 때까지 checkpoint, 다른 요청의 이름 검색과 변경 대기
+    CHECKPOINT_HOLD();
+    NAMESPACE_WRITE();
+
+    // parent 아래에서 name에 해당하는 inode 검색
+    search_result oldres;
+    asdfs_errno oldcode = lookup_inode(ll_inode(parent), name, &oldres);
+    if ((oldcode & 0xFFFF) != EXACT_FOUND) {
+        fuse_reply_err(req, ll_errno(oldcode));
+        return;
+    }
+
+    // oldcode 보조 비트 마스크 검사
+    if (!(oldcode & CAN_WRITE_PARENT)) { // parent에 쓰기 권한이 없는 경우
+        fuse_reply_err(req, EACCES);     // Permission denied
+        return;
+    }
+
+    // newparent 아래에서 newname에 해당하는 inode 검색
+    search_result newres;
+    asdfs_errno newcode = lookup_inode(ll_inode(newparent), newname, &newres);
+
+    // newcode 주요 오류 번호 검사
+    switch (newcode & 0xFFFF) {
+        case EXACT_FOUND:                // newname 위치에 inode 있음
+            fuse_reply_err(req, EEXIST); // File exists
+            return;
+
+        case EXACT_NOT_FOUND:            // newname 위치에 inode 없음
+            break;                       // 계속 진행 ->
+
+        default:
+            fuse_reply_err(req, ll_errno(newcode));
+            return;
+    }
+
+    // newcode 보조 비트 마스크 검사
+    if (!(newcode & CAN_WRITE_PARENT)) { // newparent에 쓰기 권한이 없는 경우
+        fuse_reply_err(req, EACCES);     // Permission denied
+        return;
+    }
+
+    // 이동한 inode와 그 아래의 이전 path dentry cache 무효화 (low-level 요청에는 path가 없으므로 전체)
+    dcache_invalidate_all();
+
+    // oldres.exact를 inode tree에서 분리
+    extract_inode(oldres.exact);
+
+    // newname으로 이름 변경
+    // 이름 공간이 없으면 이전 이름 그대로 원래 위치에 다시 삽입
+    if (rename_inode(oldres.exact, newres.tail) != NO_ERROR) {
+        insert_inode(oldres, oldres.exact);
+        fuse_reply_err(req, ENOSPC);     // No space left on device
+        return;
+    }
+
+    // oldres.exact를 newres 위치에 삽입
+    insert_inode(newres, oldres.exact);
+    fuse_reply_err(req, 0);
+}
@@ -0,0 +1,85 @@
+#ifndef __ASDFS_LOWLEVEL_H__
+#define __ASDFS_LOWLEVEL_H__
+
+#define FUSE_USE_VERSION 29   // 사용할 FUSE API 버전
+
+#include <fuse_lowlevel.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+
+// low-level FUSE 설정 (fuse_lowlevel_new의 userdata로 전달)
+struct asdfs_ll_config {
+    double negative_timeout; // 커널이 없는 이름을 캐시하는 시간 (초), 0이면 캐시하지 않음
+};
+
+// 파일 시스템 초기화
+void asdfs_ll_init (void *userdata, struct fuse_conn_info *conn);
+
+// 파일 시스템 해제
+void asdfs_ll_destroy (void *userdata);
+
+// 파일 시스템 정보 조회
+void asdfs_ll_statfs (fuse_req_t req, fuse_ino_t ino);
+
+// parent 아래의 name 검색
+void asdfs_ll_lookup (fuse_req_t req, fuse_ino_t parent, const char *name);
+
+// 커널의 inode 참조 해제
+void asdfs_ll_forget (fuse_req_t req, fuse_ino_t ino, unsigned long nlookup);
+
+// 커널의 여러 inode 참조 해제
+void asdfs_ll_forget_multi (fuse_req_t req, size_t count, struct fuse_forget_data *forgets);
+
+// 파일 정보 조회
+void asdfs_ll_getattr (fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi);
+
+// 파일 권한, 소유자, 크기, 시간 변경
+void asdfs_ll_setattr (fuse_req_t req, fuse_ino_t ino, struct stat *attr, int to_set, struct fuse_file_info *fi);
+
+// 디렉터리 생성
+void asdfs_ll_mkdir (fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode);
+
+// 디렉터리 삭제
+void asdfs_ll_rmdir (fuse_req_t req, fuse_ino_t parent, const char *name);
+
+// 디렉터리 열기
+void asdfs_ll_opendir (fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi);
+
+// 디렉터리 읽기
+void asdfs_ll_readdir (fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info *fi);
+
+// 파일 생성
+void asdfs_ll_mknod (fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode, dev_t rdev);
+
+// 파일 삭제
+void asdfs_ll_unlink (fuse_req_t req, fuse_ino_t parent, const char *name);
+
+// 파일 열기
+void asdfs_ll_open (fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi);
+
+// 파일 읽기
+void asdfs_ll_read (fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info *fi);
+
+// 파일 쓰기
+void asdfs_ll_write (fuse_req_t req, fuse_ino_t ino, const char *mem, size_t size, off_t off, struct fuse_file_info *fi);
+
+// 파일 쓰기 (fuse_bufvec)
+void asdfs_ll_write_buf (fuse_req_t req, fuse_ino_t ino, struct fuse_bufvec *buf, off_t off, struct fuse_file_info *fi);
+
+// 파일 공간 할당 또는 hole 생성
+void asdfs_ll_fallocate (fuse_req_t req, fuse_ino_t ino, int mode, off_t off, off_t length, struct fuse_file_info *fi);
+
+// 파일 제어 요청 (블록을 공유하는 파일 복제)
+void asdfs_ll_ioctl (fuse_req_t req, fuse_ino_t ino, int cmd, void *arg, struct fuse_file_info *fi, unsigned flags,
+                     const void *in_buf, size_t in_bufsz, size_t out_bufsz);
+
+// 파일 닫기 (파일을 연 마지막 file handle)
+void asdfs_ll_release (fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi);
+
+// 파일 이동
+void asdfs_ll_rename (fuse_req_t req, fuse_ino_t parent, const char *name, fuse_ino_t newparent, const char *newname);
+
+#endif
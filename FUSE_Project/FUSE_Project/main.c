@@ -1,31 +1,214 @@
 #include "asdfs.h"
+#include "asdfs_lowlevel.h"
 #include <fuse.h>
+#include <fuse_lowlevel.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 static struct fuse_operations asdfs_oper = {
-    .init     = asdfs_init,     // 파일 시스템 초기화
-    .statfs   = asdfs_statfs,   // 파일 시스템 정보 조회
-    .getattr  = asdfs_getattr,  // 파일 정보 조회
-
-    .mkdir    = asdfs_mkdir,    // 디렉터리 생성
-    .rmdir    = asdfs_rmdir,    // 디렉터리 삭제
-    .opendir  = asdfs_opendir,  // 디렉터리 열기
-    .readdir  = asdfs_readdir,  // 디렉터리 읽기
-
-    .mknod    = asdfs_mknod,    // 파일 생성
-    .utimens  = asdfs_utimens,  // 생성 및 수정 시간 변경
-    .unlink   = asdfs_unlink,   // 파일 삭제
-
-    .open     = asdfs_open,     // 파일 열기
-    .read     = asdfs_read,     // 파일 읽기
-    .truncate = asdfs_truncate, // 이미 있는 파일 크기 변경
-    .write    = asdfs_write,    // 파일 쓰기
-
-    .chmod    = asdfs_chmod,    // 파일 권한 변경
-    .chown    = asdfs_chown,    // 파일 소유자 변경
-    .rename   = asdfs_rename,   // 파일 이동
+    .init      = asdfs_init,       // 파일 시스템 초기화
+    .destroy   = asdfs_destroy,    // 파일 시스템 해제
+    .statfs    = asdfs_statfs,     // 파일 시스템 정보 조회
+    .getattr   = asdfs_getattr,    // 파일 정보 조회
+
+    .mkdir     = asdfs_mkdir,      // 디렉터리 생성
+    .rmdir     = asdfs_rmdir,      // 디렉터리 삭제
+    .opendir   = asdfs_opendir,    // 디렉터리 열기
+    .readdir   = asdfs_readdir,    // 디렉터리 읽기
+
+    .mknod     = asdfs_mknod,      // 파일 생성
+    .utimens   = asdfs_utimens,    // 생성 및 수정 시간 변경
+    .unlink    = asdfs_unlink,     // 파일 삭제
+
+    .open      = asdfs_open,       // 파일 열기
+    .read      = asdfs_read,       // 파일 읽기
+    .read_buf  = asdfs_read_buf,   // 파일 읽기 (블록 영역에서 바로 splice)
+    .truncate  = asdfs_truncate,   // 이미 있는 파일 크기 변경
+    .write     = asdfs_write,      // 파일 쓰기
+    .write_buf = asdfs_write_buf,  // 파일 쓰기 (splice된 pipe에서 바로 복사)
+    .fallocate = asdfs_fallocate,  // 파일 공간 할당 또는 hole 생성
+    .ioctl     = asdfs_ioctl,      // 파일 제어 요청 (블록을 공유하는 파일 복제)
+    .release   = asdfs_release,    // 파일 닫기
+
+    .chmod     = asdfs_chmod,      // 파일 권한 변경
+    .chown     = asdfs_chown,      // 파일 소유자 변경
+    .rename    = asdfs_rename,     // 파일 이동
+
+    .fsync     = asdfs_fsync,      // 파일 내용과 메타데이터를 디스크에 기록
+    .fsyncdir  = asdfs_fsyncdir,   // 디렉터리 메타데이터를 디스크에 기록
+};
+
+static struct fuse_lowlevel_ops asdfs_ll_oper = {
+    .init         = asdfs_ll_init,         // 파일 시스템 초기화
+    .destroy      = asdfs_ll_destroy,      // 파일 시스템 해제
+    .statfs       = asdfs_ll_statfs,       // 파일 시스템 정보 조회
+    .lookup       = asdfs_ll_lookup,       // parent 아래의 name 검색
+    .forget       = asdfs_ll_forget,       // 커널의 inode 참조 해제
+    .forget_multi = asdfs_ll_forget_multi, // 커널의 여러 inode 참조 해제
+    .getattr      = asdfs_ll_getattr,      // 파일 정보 조회
+    .setattr      = asdfs_ll_setattr,      // 파일 권한, 소유자, 크기, 시간 변경
+
+    .mkdir        = asdfs_ll_mkdir,        // 디렉터리 생성
+    .rmdir        = asdfs_ll_rmdir,        // 디렉터리 삭제
+    .opendir      = asdfs_ll_opendir,      // 디렉터리 열기
+    .readdir      = asdfs_ll_readdir,      // 디렉터리 읽기
+
+    .mknod        = asdfs_ll_mknod,        // 파일 생성
+    .unlink       = asdfs_ll_unlink,       // 파일 삭제
+
+    .open         = asdfs_ll_open,         // 파일 열기
+    .read         = asdfs_ll_read,         // 파일 읽기
+    .write        = asdfs_ll_write,        // 파일 쓰기
+    .write_buf    = asdfs_ll_write_buf,    // 파일 쓰기 (splice된 pipe에서 바로 복사)
+    .fallocate    = asdfs_ll_fallocate,    // 파일 공간 할당 또는 hole 생성
+    .ioctl        = asdfs_ll_ioctl,        // 파일 제어 요청 (블록을 공유하는 파일 복제)
+    .release      = asdfs_ll_release,      // 파일 닫기
+
+    .rename       = asdfs_ll_rename,       // 파일 이동
+};
+
+// asdfs 마운트 옵션
+struct asdfs_options {
+    int lowlevel;            // -o lowlevel: low-level FUSE API 사용
+    double negative_timeout; // -o negative_timeout=T: 커널이 없는 이름을 캐시하는 시간 (초)
+    int listing_cache;       // -o listing_cache: 목록을 읽은 디렉터리 아래 path 검색 시 tree 탐색 생략
+    char *image;             // -o image=FILE: 볼륨을 저장하는 이미지 파일
+    char *journal;           // -o journal=FILE: 메타데이터 변경을 기록하는 journal 파일 (high-level만)
+    unsigned checkpoint;     // -o checkpoint=SEC: 이미지 파일에 바뀐 부분만 기록하는 주기 (초)
+    int dedup;               // -o dedup: 블록 전체를 쓸 때 같은 내용의 블록을 공유
+    unsigned compress;       // -o compress=SEC: SEC초 동안 읽거나 쓰지 않은 블록을 압축
+    char *spill;             // -o spill=DIR: 블록 영역을 DIR의 파일에 두고 내린 블록을 기록
+    unsigned budget;         // -o budget=MB: 블록 메모리가 MB를 넘으면 오래 쓰지 않은 블록을 파일로 내림
+};
+
+static struct fuse_opt asdfs_opts[] = {
+    { "lowlevel", offsetof(struct asdfs_options, lowlevel), 1 },
+    { "negative_timeout=%lf", offsetof(struct asdfs_options, negative_timeout), 0 },
+    { "listing_cache", offsetof(struct asdfs_options, listing_cache), 1 },
+    { "image=%s", offsetof(struct asdfs_options, image), 0 },
+    { "journal=%s", offsetof(struct asdfs_options, journal), 0 },
+    { "checkpoint=%u", offsetof(struct asdfs_options, checkpoint), 0 },
+    { "dedup", offsetof(struct asdfs_options, dedup), 1 },
+    { "compress=%u", offsetof(struct asdfs_options, compress), 0 },
+    { "spill=%s", offsetof(struct asdfs_options, spill), 0 },
+    { "budget=%u", offsetof(struct asdfs_options, budget), 0 },
+    FUSE_OPT_END
 };
 
+// low-level FUSE API로 파일 시스템 마운트 및 요청 처리
+static int ll_main(struct fuse_args *args, struct asdfs_ll_config *config) {
+    char *mountpoint = NULL;
+    int multithreaded = 0;
+    int foreground = 0;
+    int err = -1;
+
+    // 마운트 위치 및 -s, -f 옵션 확인
+    if (fuse_parse_cmdline(args, &mountpoint, &multithreaded, &foreground) == -1) {
+        return 1;
+    }
+
+    // 마운트
+    struct fuse_chan *ch = fuse_mount(mountpoint, args);
+    if (ch == NULL) {
+        free(mountpoint);
+        return 1;
+    }
+
+    // low-level 세션 생성 후 요청 처리
+    struct fuse_session *se = fuse_lowlevel_new(args, &asdfs_ll_oper, sizeof(asdfs_ll_oper), config);
+    if (se != NULL) {
+        if (fuse_set_signal_handlers(se) != -1) {
+            fuse_session_add_chan(se, ch);
+            fuse_daemonize(foreground);
+            err = multithreaded ? fuse_session_loop_mt(se) : fuse_session_loop(se);
+            fuse_remove_signal_handlers(se);
+            fuse_session_remove_chan(ch);
+        }
+        fuse_session_destroy(se);
+    }
+
+    // 마운트 해제
+    fuse_unmount(mountpoint, ch);
+    free(mountpoint);
+    return err ? 1 : 0;
+}
+
 int main(int argc, char *argv[]) {
-    // fuse 파일 시스템 시작
-    return fuse_main(argc, argv, &asdfs_oper, NULL);
+    // asdfs 마운트 옵션 확인
+    struct fuse_args args = FUSE_ARGS_INIT(argc, argv);
+    struct asdfs_options options = { 0 };
+    if (fuse_opt_parse(&args, &options, asdfs_opts, NULL) == -1) {
+        return 1;
+    }
+
+    // checkpoint는 이미지 파일에 기록
+    if (options.checkpoint && !options.image) {
+        fprintf(stderr, "asdfs: -o checkpoint requires -o image\n");
+        fuse_opt_free_args(&args);
+        return 1;
+    }
+
+    // 이미지 파일의 색인된 블록을 다시 색인하도록 이미지 파일보다 먼저 설정
+    if (options.dedup && asdfs_enable_dedup() != 0) {
+        fuse_opt_free_args(&args);
+        return 1;
+    }
+    if (options.compress && asdfs_enable_compress(options.compress) != 0) {
+        fuse_opt_free_args(&args);
+        return 1;
+    }
+
+    // 내린 블록은 spill 디렉터리의 파일이나 공유 mapping한 이미지 파일에 기록
+    if (options.budget && !options.spill && (!options.image || options.checkpoint)) {
+        fprintf(stderr, "asdfs: -o budget requires -o spill or -o image without -o checkpoint\n");
+        fuse_opt_free_args(&args);
+        return 1;
+    }
+    if ((options.spill || options.budget) && asdfs_enable_spill(options.spill, options.budget) != 0) {
+        fuse_opt_free_args(&args);
+        return 1;
+    }
+
+    // 마운트 전에 이미지 파일 mapping
+    if (options.image && asdfs_open_image(options.image, options.checkpoint) != 0) {
+        fuse_opt_free_args(&args);
+        return 1;
+    }
+
+    // journal은 path 단위로 기록하므로 high-level API에서만 사용
+    if (options.journal && options.lowlevel) {
+        fprintf(stderr, "asdfs: -o journal is not supported with -o lowlevel\n");
+        fuse_opt_free_args(&args);
+        return 1;
+    }
+    if (options.journal && asdfs_open_journal(options.journal) != 0) {
+        fuse_opt_free_args(&args);
+        return 1;
+    }
+
+    int ret;
+    if (options.lowlevel) {
+        // low-level fuse 파일 시스템 시작
+        struct asdfs_ll_config config = { options.negative_timeout };
+        ret = ll_main(&args, &config);
+    }
+    else {
+        // high-level FUSE 라이브러리의 negative_timeout 옵션으로 전달
+        if (options.negative_timeout > 0) {
+            char opt[64];
+            snprintf(opt, sizeof(opt), "-onegative_timeout=%g", options.negative_timeout);
+            fuse_opt_add_arg(&args, opt);
+        }
+
+        // fuse 파일 시스템 시작
+        struct asdfs_config config = { options.listing_cache };
+        ret = fuse_main(args.argc, args.argv, &asdfs_oper, &config);
+    }
+
+    fuse_opt_free_args(&args);
+    free(options.image);
+    free(options.journal);
+    free(options.spill);
+    return ret;
 }
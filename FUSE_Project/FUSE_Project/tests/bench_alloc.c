@@ -0,0 +1,89 @@
+// 연산마다 heap 할당 횟수 (user-003)
+// tests/fuse_stub.c가 malloc, calloc, realloc 호출을 세므로 연산 전후의 차이를 연산 횟수로 나눔
+
+#include "../asdfs.h"
+#include "../asdfs_internal.h"
+#include "stub.h"
+#include <sys/stat.h>
+
+#define OPS 10000 // 연산마다 반복 횟수 (dentry cache 항목 개수보다 많음)
+
+// 연산 ops회의 할당 횟수 출력
+static void report(const char *label, unsigned long before, long ops) {
+    printf("%-24s %6.2f allocs/op\n", label, (double)(stub_allocs - before) / ops);
+}
+
+int main(int argc, char **argv) {
+    setvbuf(stderr, NULL, _IOFBF, 1 << 20);
+    stub_set_cred(1000, 1000, 42);
+    static struct fuse_conn_info conn;
+    asdfs_init(&conn);
+    if (asdfs_mkdir("/a", 0755) != 0) {
+        printf("mkdir /a failed\n");
+        return 1;
+    }
+
+    char path[64];
+    struct stat st;
+    unsigned long before = stub_allocs;
+    for (int i=0; i<OPS; i++) {
+        sprintf(path, "/a/d%d", i);
+        if (asdfs_mkdir(path, 0755) != 0) {
+            printf("mkdir %s failed\n", path);
+            return 1;
+        }
+    }
+    report("mkdir", before, OPS);
+
+    before = stub_allocs;
+    for (int i=0; i<OPS; i++) {
+        sprintf(path, "/a/f%d", i);
+        if (asdfs_mknod(path, S_IFREG | 0644, 0) != 0) {
+            printf("mknod %s failed\n", path);
+            return 1;
+        }
+    }
+    report("mknod", before, OPS);
+
+    // 같은 path 반복 (dentry cache가 있으면 cache에서 찾음)
+    before = stub_allocs;
+    for (int i=0; i<OPS; i++) {
+        if (asdfs_getattr("/a/f0", &st) != 0) {
+            printf("getattr /a/f0 failed\n");
+            return 1;
+        }
+    }
+    report("getattr, same path", before, OPS);
+
+    // 매번 다른 path (dentry cache에 없으므로 tree 탐색)
+    before = stub_allocs;
+    for (int i=0; i<OPS; i++) {
+        sprintf(path, "/a/f%d", (i * 7919) % OPS);
+        if (asdfs_getattr(path, &st) != 0) {
+            printf("getattr %s failed\n", path);
+            return 1;
+        }
+    }
+    report("getattr, distinct paths", before, OPS);
+
+    before = stub_allocs;
+    for (int i=0; i<OPS; i++) {
+        sprintf(path, "/a/f%d", i);
+        if (asdfs_unlink(path) != 0) {
+            printf("unlink %s failed\n", path);
+            return 1;
+        }
+    }
+    report("unlink", before, OPS);
+
+    before = stub_allocs;
+    for (int i=0; i<OPS; i++) {
+        sprintf(path, "/a/d%d", i);
+        if (asdfs_rmdir(path) != 0) {
+            printf("rmdir %s failed\n", path);
+            return 1;
+        }
+    }
+    report("rmdir", before, OPS);
+    return 0;
+}
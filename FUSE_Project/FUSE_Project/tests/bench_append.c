@@ -0,0 +1,192 @@
+// 작은 이어 쓰기 처리량과 파일 크기의 관계, 여러 파일에 번갈아 이어 쓴 파일의 읽기 (user-024)
+// 1) 100 B, 1000 B, 4096 B 단위로 64 MB까지 이어 쓰며 1, 4, 16, 64 MB 구간별 ns/op
+// 2) 인자로 interleave FILES RECORD를 주면 새 볼륨에서 파일 FILES개에 RECORD 바이트씩 번갈아
+//    16 MB씩 이어 쓴 뒤 128 KB read_buf 한 번에 필요한 buf 개수와 splice 처리량
+//    (앞선 측정이 해제한 블록을 다시 쓰지 않도록 경우마다 따로 실행)
+
+#define _GNU_SOURCE
+#include "../asdfs.h"
+#include "../asdfs_internal.h"
+#include "stub.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+
+#define INTERLEAVE_SIZE ((size_t)16 << 20) // 번갈아 쓰는 파일마다 크기 (B)
+#define READ_SIZE       ((size_t)128 << 10) // 읽기 요청 크기 (B)
+#define INTERLEAVE_MAX  8                   // 번갈아 쓰는 파일의 최대 개수
+
+static int pipes[2];    // 응답을 쓰는 pipe
+static int null_fd;     // pipe를 비우는 /dev/null
+
+// path 파일을 만들고 쓰기용으로 열기, 실패하면 -1
+static int create(const char *path, struct fuse_file_info *fi) {
+    memset(fi, 0, sizeof(*fi));
+    fi->flags = O_WRONLY;
+    return asdfs_mknod(path, S_IFREG | 0644, 0) == 0 && asdfs_open(path, fi) == 0 ? 0 : -1;
+}
+
+// record 바이트 단위 이어 쓰기, 구간별 ns/op 출력
+static int append_records(size_t record) {
+    static char buf[DATA_BLOCK_SIZE];
+    memset(buf, 'x', sizeof(buf));
+    struct fuse_file_info fi;
+    if (create("/log", &fi) != 0) {
+        return -1;
+    }
+
+    const off_t marks[] = { 1 << 20, 4 << 20, 16 << 20, 64 << 20 };
+    printf("%4zu B appends:", record);
+    off_t off = 0;
+    for (int m=0; m<4; m++) {
+        long ops = 0;
+        double start = stub_now();
+        while (off < marks[m]) {
+            if (asdfs_write("/log", buf, record, off, &fi) != (int)record) {
+                return -1;
+            }
+            off += (off_t)record;
+            ops++;
+        }
+        printf("  %2ld MB %5.0f ns/op", (long)(marks[m] >> 20), (stub_now() - start) / ops * 1e9);
+    }
+    printf("\n");
+    asdfs_release("/log", &fi);
+    return asdfs_unlink("/log");
+}
+
+// pipe에 쓴 size 바이트를 /dev/null로 비움
+static int drain(size_t size) {
+    while (size > 0) {
+        ssize_t moved = splice(pipes[0], NULL, null_fd, NULL, size, SPLICE_F_MOVE);
+        if (moved <= 0) {
+            return -1;
+        }
+        size -= (size_t)moved;
+    }
+    return 0;
+}
+
+// buf 목록을 pipe에 쓰고 비움, 실패하면 -1
+static int send_bufvec(struct fuse_bufvec *bufv) {
+    size_t total = 0;
+    for (size_t i=0; i<bufv->count; i++) {
+        struct fuse_buf *buf = &bufv->buf[i];
+        if (buf->flags & FUSE_BUF_IS_FD) {
+            loff_t pos = buf->pos;
+            size_t left = buf->size;
+            while (left > 0) {
+                ssize_t moved = splice(buf->fd, &pos, pipes[1], NULL, left, SPLICE_F_MOVE);
+                if (moved <= 0) {
+                    return -1;
+                }
+                left -= (size_t)moved;
+            }
+        }
+        else {
+            if (write(pipes[1], buf->mem, buf->size) != (ssize_t)buf->size) {
+                return -1;
+            }
+            free(buf->mem);
+        }
+        total += buf->size;
+    }
+    return drain(total);
+}
+
+// files개 파일에 record 바이트씩 번갈아 이어 쓴 뒤 128 KB read_buf의 평균 buf 개수와 처리량 출력
+static int interleave(int files, size_t record) {
+    static char buf[DATA_BLOCK_SIZE];
+    memset(buf, 'a', sizeof(buf));
+    struct statvfs before, after;
+    asdfs_statfs("/", &before);
+    char paths[INTERLEAVE_MAX][8];
+    struct fuse_file_info fi[INTERLEAVE_MAX];
+    for (int i=0; i<files; i++) {
+        sprintf(paths[i], "/i%d", i);
+        if (create(paths[i], &fi[i]) != 0) {
+            return -1;
+        }
+    }
+    for (size_t off=0; off<INTERLEAVE_SIZE; off+=record) {
+        for (int i=0; i<files; i++) {
+            if (asdfs_write(paths[i], buf, record, (off_t)off, &fi[i]) != (int)record) {
+                return -1;
+            }
+        }
+    }
+    for (int i=0; i<files; i++) {
+        asdfs_release(paths[i], &fi[i]);
+    }
+
+    if (pipe(pipes) != 0 || (null_fd = open("/dev/null", O_WRONLY)) < 0) {
+        return -1;
+    }
+    fcntl(pipes[1], F_SETPIPE_SZ, 1 << 20);
+    size_t bufs = 0, reads = 0;
+    double best = 1e9;
+    for (int rep=0; rep<3; rep++) {
+        bufs = reads = 0;
+        double start = stub_now();
+        for (int i=0; i<files; i++) {
+            memset(&fi[i], 0, sizeof(fi[i]));
+            fi[i].flags = O_RDONLY;
+            if (asdfs_open(paths[i], &fi[i]) != 0) {
+                return -1;
+            }
+            for (size_t off=0; off<INTERLEAVE_SIZE; off+=READ_SIZE) {
+                struct fuse_bufvec *bufv;
+                if (asdfs_read_buf(paths[i], &bufv, READ_SIZE, (off_t)off, &fi[i]) != 0) {
+                    return -1;
+                }
+                bufs += bufv->count;
+                reads++;
+                int sent = send_bufvec(bufv);
+                free(bufv);
+                if (sent != 0) {
+                    return -1;
+                }
+            }
+            asdfs_release(paths[i], &fi[i]);
+        }
+        double took = stub_now() - start;
+        best = took < best ? took : best;
+    }
+    printf("%d file(s) x %4zu B appends in turn: %4.1f bufs per 128 KB read_buf, %6.2f GB/s\n", files, record,
+           (double)bufs / reads, files * INTERLEAVE_SIZE / best / 1e9);
+
+    // 예약하고 쓰지 않은 블록 번호는 f_bfree에 남지 않음
+    for (int i=0; i<files; i++) {
+        asdfs_unlink(paths[i]);
+    }
+    asdfs_statfs("/", &after);
+    return after.f_bfree == before.f_bfree ? 0 : -1;
+}
+
+int main(int argc, char **argv) {
+    setvbuf(stderr, NULL, _IOFBF, 1 << 20);
+    stub_set_cred(1000, 1000, 42);
+    static struct fuse_conn_info conn;
+    conn.capable = FUSE_CAP_SPLICE_READ | FUSE_CAP_SPLICE_MOVE | FUSE_CAP_SPLICE_WRITE;
+    asdfs_init(&conn);
+
+    if (argc > 3 && strcmp(argv[1], "interleave") == 0) {
+        int files = atoi(argv[2]);
+        size_t record = (size_t)atol(argv[3]);
+        if (files < 1 || files > INTERLEAVE_MAX || record < 1 || record > DATA_BLOCK_SIZE || interleave(files, record) != 0) {
+            printf("interleave failed\n");
+            return 1;
+        }
+        return 0;
+    }
+
+    const size_t records[] = { 100, 1000, 4096 };
+    for (int i=0; i<3; i++) {
+        if (append_records(records[i]) != 0) {
+            printf("append failed\n");
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+// 복사 방식별 크기에 따른 처리량 (user-014)
+// 256 KB (cache에 들어감), 64 MB 영역을 돌아가며 size 바이트씩 복사 (dst는 8 B 어긋남), GB/s
+// byte loop: 바이트 단위 복사, memcpy: glibc, cached: copy_data, stream: copy_data non-temporal store
+// 측정 전에 0~5000 B 크기와 여러 정렬에서 copy_data 결과를 memcpy와 비교
+
+#include "../asdfs_copy.h"
+#include "stub.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define AREA_SIZE ((size_t)64 << 20)  // 복사하는 영역의 최대 크기 (B)
+#define COPY_TOTAL ((size_t)256 << 20) // 방식과 크기마다 복사하는 양 (B)
+#define CHECK_SIZE_MAX 5000            // 결과를 확인하는 최대 크기 (B)
+
+static char *src;
+static char *dst;
+
+// 바이트 단위 복사 (컴파일러가 memcpy로 바꾸지 않도록 volatile)
+static void copy_bytes(void *to, const void *from, size_t size) {
+    volatile char *d = (volatile char *)to;
+    const char *s = (const char *)from;
+    for (size_t i=0; i<size; i++) {
+        d[i] = s[i];
+    }
+}
+
+// area 바이트 영역을 돌아가며 mode 방식으로 size 바이트씩 total 바이트 복사한 처리량 (GB/s) 반환
+static double measure(int mode, size_t size, size_t total, size_t area) {
+    size_t pos = 0;
+    double start = stub_now();
+    for (size_t done=0; done<total; done+=size) {
+        if (pos + size > area) {
+            pos = 0;
+        }
+        switch (mode) {
+            case 0: copy_bytes(dst + 8 + pos, src + pos, size); break;
+            case 1: memcpy(dst + 8 + pos, src + pos, size); break;
+            case 2: copy_data(dst + 8 + pos, src + pos, size, 0); break;
+            default: copy_data(dst + 8 + pos, src + pos, size, 1); break;
+        }
+        pos += size;
+    }
+    return total / (stub_now() - start) / 1e9;
+}
+
+// 크기 0~CHECK_SIZE_MAX와 src/dst 정렬 조합에서 copy_data 결과와 앞뒤 바이트 확인, 틀리면 -1
+static int check() {
+    static char want[CHECK_SIZE_MAX + 128];
+    for (int stream=0; stream<2; stream++) {
+        for (size_t size=0; size<=CHECK_SIZE_MAX; size++) {
+            for (int align=0; align<64; align+=7) {
+                memset(dst, 0x5A, CHECK_SIZE_MAX + 128);
+                memcpy(want, dst, CHECK_SIZE_MAX + 128);
+                memcpy(want + align, src + 64 - align, size);
+                copy_data(dst + align, src + 64 - align, size, stream);
+                if (memcmp(dst, want, CHECK_SIZE_MAX + 128) != 0) {
+                    printf("copy_data mismatch: size %zu, align %d, stream %d\n", size, align, stream);
+                    return -1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    copy_init();
+    src = malloc(AREA_SIZE + 64);
+    dst = malloc(AREA_SIZE + 64);
+    if (src == NULL || dst == NULL) {
+        printf("malloc failed\n");
+        return 1;
+    }
+    for (size_t i=0; i<AREA_SIZE + 64; i++) {
+        src[i] = (char)(i * 31 + (i >> 12));
+    }
+    memset(dst, 0, AREA_SIZE + 64);
+    if (check() != 0) {
+        return 1;
+    }
+
+    printf("engine %s, GB/s\n", copy_engine_name());
+    const size_t areas[] = { 256 << 10, AREA_SIZE };
+    const size_t sizes[] = { 64, 1024, 4096, 16384, 262144, 1048576 };
+    for (int a=0; a<2; a++) {
+        printf("%zu KiB working set\n", areas[a] >> 10);
+        printf("%8s %10s %10s %10s %10s\n", "size", "byte loop", "memcpy", "cached", "stream");
+        for (int i=0; i<6 && sizes[i]<=areas[a]; i++) {
+            char label[16];
+            if (sizes[i] >= 1024 * 1024) {
+                sprintf(label, "%zu MiB", sizes[i] >> 20);
+            }
+            else if (sizes[i] >= 1024) {
+                sprintf(label, "%zu KiB", sizes[i] >> 10);
+            }
+            else {
+                sprintf(label, "%zu B", sizes[i]);
+            }
+            printf("%8s", label);
+            for (int mode=0; mode<4; mode++) {
+                // byte loop은 느리므로 1/8만 복사
+                printf(" %10.2f", measure(mode, sizes[i], mode == 0 ? COPY_TOTAL / 8 : COPY_TOTAL, areas[a]));
+            }
+            printf("\n");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+// 파일 크기별 4 KB 이어 쓰기, 임의 위치 쓰기 처리량 (user-012)
+// 1 MB, 100 MB, 1 GB 파일을 4 KB씩 이어 쓴 뒤 같은 파일의 임의 위치에 4 KB씩 다시 씀
+
+#include "../asdfs.h"
+#include "../asdfs_internal.h"
+#include "stub.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#define RANDOM_WRITES 262144 // 파일마다 임의 위치에 쓰는 최대 횟수
+
+int main(int argc, char **argv) {
+    setvbuf(stderr, NULL, _IOFBF, 1 << 20);
+    stub_set_cred(1000, 1000, 42);
+    static struct fuse_conn_info conn;
+    asdfs_init(&conn);
+
+    static char buf[DATA_BLOCK_SIZE];
+    memset(buf, 'x', sizeof(buf));
+    const long sizes[] = { 1L << 20, 100L << 20, 1L << 30 };
+    const char *labels[] = { "1 MB", "100 MB", "1 GB" };
+
+    printf("%-8s %14s %16s %16s\n", "size", "append MB/s", "worst append ms", "random MB/s");
+    for (int k=0; k<3; k++) {
+        char path[32];
+        sprintf(path, "/f%d", k);
+        struct fuse_file_info fi;
+        memset(&fi, 0, sizeof(fi));
+        fi.flags = O_WRONLY;
+        if (asdfs_mknod(path, S_IFREG | 0644, 0) != 0 || asdfs_open(path, &fi) != 0) {
+            printf("create %s failed\n", path);
+            return 1;
+        }
+
+        // 이어 쓰기
+        long blocks = sizes[k] / DATA_BLOCK_SIZE;
+        double worst = 0;
+        double start = stub_now();
+        for (long i=0; i<blocks; i++) {
+            double before = stub_now();
+            if (asdfs_write(path, buf, sizeof(buf), i * DATA_BLOCK_SIZE, &fi) != (int)sizeof(buf)) {
+                printf("write %s failed\n", path);
+                return 1;
+            }
+            double took = stub_now() - before;
+            worst = took > worst ? took : worst;
+        }
+        double append = stub_now() - start;
+
+        // 임의 위치 쓰기
+        long writes = blocks < RANDOM_WRITES ? blocks : RANDOM_WRITES;
+        unsigned seed = 1;
+        start = stub_now();
+        for (long i=0; i<writes; i++) {
+            seed = seed * 1103515245 + 12345;
+            long index = (long)((seed * 2654435761u) % (unsigned long)blocks);
+            asdfs_write(path, buf, sizeof(buf), index * DATA_BLOCK_SIZE, &fi);
+        }
+        double random = stub_now() - start;
+
+        printf("%-8s %14.0f %16.2f %16.0f\n", labels[k], sizes[k] / append / 1e6, worst * 1e3,
+               writes * (double)DATA_BLOCK_SIZE / random / 1e6);
+        asdfs_release(path, &fi);
+        asdfs_unlink(path);
+    }
+    return 0;
+}
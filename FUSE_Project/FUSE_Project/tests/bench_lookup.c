@@ -0,0 +1,57 @@
+// 디렉터리 크기별 파일 생성, 조회 시간 (user-001)
+// 디렉터리 하나에 파일 N개를 만들며 생성 시간을 재고, 임의의 이름을 asdfs_getattr로 조회하는 시간을 잼
+// 100만 개 디렉터리가 들어가도록 -DVOLUME_SIZE_MB=8192로 빌드 (make bench)
+// 인자로 최대 항목 개수를 주면 그 크기까지만 측정 (기본 100만)
+
+#include "../asdfs.h"
+#include "../asdfs_internal.h"
+#include "stub.h"
+#include <sys/stat.h>
+
+#define LOOKUPS 200000 // 디렉터리마다 조회하는 횟수
+
+int main(int argc, char **argv) {
+    setvbuf(stderr, NULL, _IOFBF, 1 << 20);
+    stub_set_cred(1000, 1000, 42);
+    static struct fuse_conn_info conn;
+    asdfs_init(&conn);
+
+    long max = argc > 1 ? atol(argv[1]) : 1000000;
+    printf("%10s %14s %14s\n", "entries", "create ns/op", "lookup ns/op");
+    long entries = 10;
+    for (int dir=0; entries <= max; dir++, entries *= 10) {
+        char path[64];
+        sprintf(path, "/d%d", dir);
+        if (asdfs_mkdir(path, 0755) != 0) {
+            printf("mkdir %s failed\n", path);
+            return 1;
+        }
+
+        // 생성: 이름 순서와 무관한 순서로 추가
+        double start = stub_now();
+        for (long i=0; i<entries; i++) {
+            sprintf(path, "/d%d/file_%07ld", dir, (i * 7919) % entries);
+            if (asdfs_mknod(path, S_IFREG | 0644, 0) != 0) {
+                printf("mknod %s failed\n", path);
+                return 1;
+            }
+        }
+        double create = (stub_now() - start) / entries;
+
+        // 조회: 임의의 이름
+        unsigned seed = 12345;
+        struct stat st;
+        start = stub_now();
+        for (long i=0; i<LOOKUPS; i++) {
+            seed = seed * 1103515245 + 12345;
+            sprintf(path, "/d%d/file_%07ld", dir, (long)(seed >> 8) % entries);
+            if (asdfs_getattr(path, &st) != 0) {
+                printf("getattr %s failed\n", path);
+                return 1;
+            }
+        }
+        double lookup = (stub_now() - start) / LOOKUPS;
+        printf("%10ld %14.0f %14.0f\n", entries, create * 1e9, lookup * 1e9);
+    }
+    return 0;
+}
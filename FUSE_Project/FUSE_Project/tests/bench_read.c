@@ -0,0 +1,138 @@
+// 큰 파일 순차 읽기 처리량 (user-016)
+// 512 MB 파일을 128 KB씩 읽어 pipe에 쓰고 /dev/null로 비움 (pipe가 /dev/fuse 역할)
+// 1) asdfs_read로 버퍼에 복사한 뒤 write (high-level read)
+// 2) map_data_inode가 가리키는 블록을 writev (low-level iov 응답)
+// 3) asdfs_read_buf가 가리키는 블록 영역 fd에서 splice (high-level/low-level 응답)
+
+#define _GNU_SOURCE
+#include "../asdfs.h"
+#include "../asdfs_internal.h"
+#include "stub.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define FILE_SIZE ((size_t)512 << 20) // 읽는 파일 크기 (B)
+#define CHUNK     ((size_t)128 << 10) // 읽기 요청 크기 (B)
+#define IOV_MAX_COUNT 64              // map_data_inode에 전달하는 iovec 개수
+
+static int pipes[2];    // 응답을 쓰는 pipe
+static int null_fd;     // pipe를 비우는 /dev/null
+
+// pipe에 쓴 size 바이트를 /dev/null로 비움
+static int drain(size_t size) {
+    while (size > 0) {
+        ssize_t moved = splice(pipes[0], NULL, null_fd, NULL, size, SPLICE_F_MOVE);
+        if (moved <= 0) {
+            return -1;
+        }
+        size -= (size_t)moved;
+    }
+    return 0;
+}
+
+// buf 목록을 pipe에 쓰고 비움, 쓴 크기 반환
+static ssize_t send_bufvec(struct fuse_bufvec *bufv) {
+    size_t total = 0;
+    for (size_t i=0; i<bufv->count; i++) {
+        struct fuse_buf *buf = &bufv->buf[i];
+        if (buf->flags & FUSE_BUF_IS_FD) {
+            loff_t pos = buf->pos;
+            size_t left = buf->size;
+            while (left > 0) {
+                ssize_t moved = splice(buf->fd, &pos, pipes[1], NULL, left, SPLICE_F_MOVE);
+                if (moved <= 0) {
+                    return -1;
+                }
+                left -= (size_t)moved;
+            }
+        }
+        else {
+            if (write(pipes[1], buf->mem, buf->size) != (ssize_t)buf->size) {
+                return -1;
+            }
+            free(buf->mem);
+        }
+        total += buf->size;
+    }
+    return drain(total) == 0 ? (ssize_t)total : -1;
+}
+
+// mode 방식으로 파일 전체를 읽고 처리량 (GB/s) 반환, 실패하면 -1
+static double read_all(int mode, struct fuse_file_info *fi) {
+    static char mem[CHUNK];
+    double start = stub_now();
+    for (size_t off=0; off<FILE_SIZE; off+=CHUNK) {
+        if (mode == 0) {
+            int size = asdfs_read("/f", mem, CHUNK, (off_t)off, fi);
+            if (size != (int)CHUNK || write(pipes[1], mem, CHUNK) != (ssize_t)CHUNK || drain(CHUNK) != 0) {
+                return -1;
+            }
+        }
+        else if (mode == 1) {
+            struct iovec iov[IOV_MAX_COUNT];
+            int count = map_data_inode((inode *)fi->fh, (off_t)off, CHUNK, iov, IOV_MAX_COUNT);
+            if (writev(pipes[1], iov, count) != (ssize_t)CHUNK || drain(CHUNK) != 0) {
+                return -1;
+            }
+        }
+        else {
+            struct fuse_bufvec *bufv;
+            if (asdfs_read_buf("/f", &bufv, CHUNK, (off_t)off, fi) != 0 || send_bufvec(bufv) != (ssize_t)CHUNK) {
+                return -1;
+            }
+            free(bufv);
+        }
+    }
+    return FILE_SIZE / (stub_now() - start) / 1e9;
+}
+
+int main(int argc, char **argv) {
+    setvbuf(stderr, NULL, _IOFBF, 1 << 20);
+    stub_set_cred(1000, 1000, 42);
+    static struct fuse_conn_info conn;
+    conn.capable = FUSE_CAP_SPLICE_READ | FUSE_CAP_SPLICE_MOVE | FUSE_CAP_SPLICE_WRITE;
+    asdfs_init(&conn);
+
+    // 파일 준비
+    struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
+    fi.flags = O_WRONLY;
+    if (asdfs_mknod("/f", S_IFREG | 0644, 0) != 0 || asdfs_open("/f", &fi) != 0) {
+        printf("create /f failed\n");
+        return 1;
+    }
+    static char mem[CHUNK];
+    memset(mem, 'r', sizeof(mem));
+    for (size_t off=0; off<FILE_SIZE; off+=CHUNK) {
+        if (asdfs_write("/f", mem, CHUNK, (off_t)off, &fi) != (int)CHUNK) {
+            printf("write /f failed\n");
+            return 1;
+        }
+    }
+
+    if (pipe(pipes) != 0 || (null_fd = open("/dev/null", O_WRONLY)) < 0) {
+        printf("pipe failed\n");
+        return 1;
+    }
+    fcntl(pipes[1], F_SETPIPE_SZ, 1 << 20);
+
+    const char *labels[] = {
+        "asdfs_read into a buffer + write",
+        "map_data_inode + writev",
+        "read_buf, splice from the arena fd",
+    };
+    for (int mode=0; mode<3; mode++) {
+        double best = 0;
+        for (int rep=0; rep<3; rep++) {
+            double rate = read_all(mode, &fi);
+            if (rate < 0) {
+                printf("%s failed\n", labels[mode]);
+                return 1;
+            }
+            best = rate > best ? rate : best;
+        }
+        printf("%-40s %6.2f GB/s\n", labels[mode], best);
+    }
+    return 0;
+}
@@ -0,0 +1,95 @@
+// 100k 항목 디렉터리의 ls -l (user-011)
+// 커널처럼 4 KB 단위로 readdir를 반복한 뒤 항목마다 asdfs_getattr 호출
+// 인자로 listing_cache를 주면 -o listing_cache와 같은 설정으로 초기화
+
+#include "../asdfs.h"
+#include "../asdfs_internal.h"
+#include "stub.h"
+#include <sys/stat.h>
+
+#define ENTRIES   100000                    // 디렉터리 항목 개수
+#define DIR_PATH  "/home/user/src/big"      // 목록을 읽는 디렉터리
+#define READDIR_BUF 4096                    // readdir 한 번에 전달하는 크기 (B)
+
+static char (*names)[32]; // 읽은 이름
+static long count;        // 읽은 이름 개수
+static long typed;        // 종류 (d_type)가 채워진 항목 개수
+static size_t room;       // 이번 readdir에서 남은 크기
+static off_t last;        // 마지막으로 받은 항목의 offset
+
+// fuse_fill_dir_t: 커널 dirent 크기만큼 공간을 차지하고 가득 차면 1 반환
+static int fill(void *buf, const char *name, const struct stat *st, off_t off) {
+    size_t size = (24 + strlen(name) + 7) & ~(size_t)7;
+    if (room < size) {
+        return 1;
+    }
+    room -= size;
+    strcpy(names[count++], name);
+    if (st != NULL && (st->st_mode & S_IFMT)) {
+        typed++;
+    }
+    last = off;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    setvbuf(stderr, NULL, _IOFBF, 1 << 20);
+    static struct asdfs_config config;
+    config.listing_cache = argc > 1 && strcmp(argv[1], "listing_cache") == 0;
+    stub_set_private(&config);
+    stub_set_cred(1000, 1000, 42);
+    static struct fuse_conn_info conn;
+    asdfs_init(&conn);
+
+    asdfs_mkdir("/home", 0755);
+    asdfs_mkdir("/home/user", 0755);
+    asdfs_mkdir("/home/user/src", 0755);
+    asdfs_mkdir(DIR_PATH, 0755);
+    char path[128];
+    for (int i=0; i<ENTRIES; i++) {
+        sprintf(path, DIR_PATH "/file_%06d.c", i);
+        if (asdfs_mknod(path, S_IFREG | 0644, 0) != 0) {
+            printf("mknod %s failed\n", path);
+            return 1;
+        }
+    }
+    names = malloc(sizeof(*names) * (ENTRIES + 2));
+
+    struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
+    asdfs_opendir(DIR_PATH, &fi);
+    double best_list = 1e9, best_stat = 1e9;
+    for (int rep=0; rep<3; rep++) {
+        // readdir: 마지막 offset부터 이어서
+        double start = stub_now();
+        count = typed = 0;
+        last = 0;
+        for (;;) {
+            long before = count;
+            room = READDIR_BUF;
+            asdfs_readdir(DIR_PATH, NULL, fill, last, &fi);
+            if (count == before) {
+                break;
+            }
+        }
+        double list = stub_now() - start;
+
+        // 항목마다 getattr ("."와 ".." 제외)
+        struct stat st;
+        start = stub_now();
+        for (long i=2; i<count; i++) {
+            sprintf(path, DIR_PATH "/%s", names[i]);
+            if (asdfs_getattr(path, &st) != 0) {
+                printf("getattr %s failed\n", path);
+                return 1;
+            }
+        }
+        double stat = (stub_now() - start) / (count - 2);
+        best_list = list < best_list ? list : best_list;
+        best_stat = stat < best_stat ? stat : best_stat;
+    }
+
+    printf("ls -l %ld entries%s: readdir %.1f ms, getattr %.0f ns/entry, d_type filled %ld\n", count - 2,
+           config.listing_cache ? " (listing_cache)" : "", best_list * 1e3, best_stat * 1e9, typed);
+    return 0;
+}
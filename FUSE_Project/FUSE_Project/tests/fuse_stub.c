@@ -0,0 +1,222 @@
+#define FUSE_USE_VERSION 29
+#include <fuse.h>
+#include <fuse_lowlevel.h>
+#include <string.h>
+#include <unistd.h>
+#include "stub.h"
+
+// libfuse 대신 연결하는 함수: 요청 정보는 stub_set_cred로 지정한 값, 응답은 마지막 응답만 기록
+
+static struct fuse_context context;
+static struct fuse_ctx request_context;
+
+int stub_reply_errno;
+unsigned long stub_reply_ino;
+char stub_reply_data[1 << 20];
+size_t stub_reply_size;
+
+unsigned long stub_allocs;
+
+// glibc 할당 함수를 감싸서 호출 횟수를 셈
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) {
+    __sync_fetch_and_add(&stub_allocs, 1);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    __sync_fetch_and_add(&stub_allocs, 1);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    __sync_fetch_and_add(&stub_allocs, 1);
+    return __libc_realloc(ptr, size);
+}
+
+// 호출 프로세스 uid, gid, pid 지정
+void stub_set_cred(uid_t uid, gid_t gid, pid_t pid) {
+    context.uid = request_context.uid = uid;
+    context.gid = request_context.gid = gid;
+    context.pid = request_context.pid = pid;
+    context.umask = request_context.umask = 022;
+}
+
+// high-level fuse context의 private_data 지정
+void stub_set_private(void *data) {
+    context.private_data = data;
+}
+
+struct fuse_context *fuse_get_context(void) {
+    return &context;
+}
+
+int fuse_getgroups(int size, gid_t list[]) {
+    return 0;
+}
+
+const struct fuse_ctx *fuse_req_ctx(fuse_req_t req) {
+    return &request_context;
+}
+
+int fuse_req_getgroups(fuse_req_t req, int size, gid_t list[]) {
+    return 0;
+}
+
+size_t fuse_buf_size(const struct fuse_bufvec *bufv) {
+    size_t size = 0;
+    for (size_t i=0; i<bufv->count; i++) {
+        size += bufv->buf[i].size;
+    }
+    return size;
+}
+
+// 메모리 버퍼로만 복사 (원본은 메모리 또는 위치를 지정한 fd)
+ssize_t fuse_buf_copy(struct fuse_bufvec *dst, struct fuse_bufvec *src, enum fuse_buf_copy_flags flags) {
+    ssize_t copied = 0;
+    while (dst->idx < dst->count && src->idx < src->count) {
+        struct fuse_buf *to = &dst->buf[dst->idx];
+        struct fuse_buf *from = &src->buf[src->idx];
+        size_t length = to->size - dst->off;
+        if (length > from->size - src->off) {
+            length = from->size - src->off;
+        }
+
+        ssize_t done = (ssize_t)length;
+        if (from->flags & FUSE_BUF_IS_FD) {
+            done = pread(from->fd, (char *)to->mem + dst->off, length, from->pos + (off_t)src->off);
+            if (done < 0) {
+                return copied ? copied : -1;
+            }
+        }
+        else {
+            memcpy((char *)to->mem + dst->off, (char *)from->mem + src->off, length);
+        }
+        copied += done;
+        dst->off += (size_t)done;
+        src->off += (size_t)done;
+        if (dst->off == to->size) {
+            dst->idx++;
+            dst->off = 0;
+        }
+        if (src->off == from->size) {
+            src->idx++;
+            src->off = 0;
+        }
+        if ((size_t)done < length) {
+            break;
+        }
+    }
+    return copied;
+}
+
+// 응답 데이터 기록
+static void reply_copy(const void *data, size_t size) {
+    if (size > sizeof(stub_reply_data)) {
+        size = sizeof(stub_reply_data);
+    }
+    memcpy(stub_reply_data, data, size);
+    stub_reply_size = size;
+    stub_reply_errno = 0;
+}
+
+int fuse_reply_err(fuse_req_t req, int err) {
+    stub_reply_errno = err;
+    return 0;
+}
+
+void fuse_reply_none(fuse_req_t req) {
+    stub_reply_errno = 0;
+}
+
+int fuse_reply_entry(fuse_req_t req, const struct fuse_entry_param *e) {
+    stub_reply_errno = 0;
+    stub_reply_ino = e->ino;
+    return 0;
+}
+
+int fuse_reply_create(fuse_req_t req, const struct fuse_entry_param *e, const struct fuse_file_info *fi) {
+    return fuse_reply_entry(req, e);
+}
+
+int fuse_reply_attr(fuse_req_t req, const struct stat *attr, double attr_timeout) {
+    reply_copy(attr, sizeof(*attr));
+    return 0;
+}
+
+int fuse_reply_open(fuse_req_t req, const struct fuse_file_info *fi) {
+    stub_reply_errno = 0;
+    return 0;
+}
+
+int fuse_reply_write(fuse_req_t req, size_t count) {
+    stub_reply_errno = 0;
+    stub_reply_size = count;
+    return 0;
+}
+
+int fuse_reply_buf(fuse_req_t req, const char *buf, size_t size) {
+    reply_copy(buf, size);
+    return 0;
+}
+
+int fuse_reply_iov(fuse_req_t req, const struct iovec *iov, int count) {
+    size_t size = 0;
+    for (int i=0; i<count && size < sizeof(stub_reply_data); i++) {
+        size_t length = iov[i].iov_len;
+        if (length > sizeof(stub_reply_data) - size) {
+            length = sizeof(stub_reply_data) - size;
+        }
+        memcpy(stub_reply_data + size, iov[i].iov_base, length);
+        size += length;
+    }
+    stub_reply_size = size;
+    stub_reply_errno = 0;
+    return 0;
+}
+
+int fuse_reply_data(fuse_req_t req, struct fuse_bufvec *bufv, enum fuse_buf_copy_flags flags) {
+    size_t size = fuse_buf_size(bufv);
+    if (size > sizeof(stub_reply_data)) {
+        size = sizeof(stub_reply_data);
+    }
+    struct fuse_bufvec dst = FUSE_BUFVEC_INIT(size);
+    dst.buf[0].mem = stub_reply_data;
+    ssize_t copied = fuse_buf_copy(&dst, bufv, flags);
+    stub_reply_size = copied > 0 ? (size_t)copied : 0;
+    stub_reply_errno = 0;
+    return 0;
+}
+
+int fuse_reply_ioctl(fuse_req_t req, int result, const void *buf, size_t size) {
+    reply_copy(buf, size);
+    return 0;
+}
+
+int fuse_reply_statfs(fuse_req_t req, const struct statvfs *stbuf) {
+    stub_reply_errno = 0;
+    return 0;
+}
+
+// libfuse와 같은 형식 (inode 번호, 다음 offset, 이름 길이, 종류, 이름을 8 B 단위로)으로 기록
+size_t fuse_add_direntry(fuse_req_t req, char *buf, size_t bufsize, const char *name, const struct stat *stbuf, off_t off) {
+    size_t length = strlen(name);
+    size_t size = (24 + length + 7) & ~(size_t)7;
+    if (buf == NULL || size > bufsize) {
+        return size;
+    }
+    uint64_t ino = stbuf->st_ino;
+    uint64_t next = (uint64_t)off;
+    uint32_t namelen = (uint32_t)length;
+    uint32_t type = (stbuf->st_mode & S_IFMT) >> 12;
+    memcpy(buf, &ino, 8);
+    memcpy(buf + 8, &next, 8);
+    memcpy(buf + 16, &namelen, 4);
+    memcpy(buf + 20, &type, 4);
+    memset(buf + 24, 0, size - 24);
+    memcpy(buf + 24, name, length);
+    return size;
+}
@@ -0,0 +1,34 @@
+#ifndef __ASDFS_STUB_H__
+#define __ASDFS_STUB_H__
+
+// 벤치마크와 테스트 공용: libfuse 대신 fuse_stub.c와 연결하여 마운트 없이 연산 함수를 직접 호출
+// 연산 함수가 stderr에 남기는 로그는 실행할 때 2>/dev/null로 버림
+
+#include <sys/types.h>
+#include <stddef.h>
+#include <time.h>
+
+// 호출 프로세스 uid, gid, pid 지정 (high-level fuse context와 low-level 요청 모두)
+void stub_set_cred(uid_t uid, gid_t gid, pid_t pid);
+
+// high-level fuse context의 private_data 지정 (asdfs_init에 전달되는 설정)
+void stub_set_private(void *data);
+
+// 마지막 low-level 응답: 오류 번호 (0이면 성공), entry의 inode 번호, 데이터와 크기
+// readdir 응답의 데이터는 libfuse의 fuse_add_direntry와 같은 형식
+extern int stub_reply_errno;
+extern unsigned long stub_reply_ino;
+extern char stub_reply_data[1 << 20];
+extern size_t stub_reply_size;
+
+// 지금까지 malloc, calloc, realloc을 호출한 횟수 (fuse_stub.c가 glibc 함수를 감싸서 셈)
+extern unsigned long stub_allocs;
+
+// 현재 시간 (초, CLOCK_MONOTONIC)
+static inline double stub_now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+#endif
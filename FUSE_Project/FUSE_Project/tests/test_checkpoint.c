@@ -0,0 +1,201 @@
+// checkpoint 테스트 (user-019)
+// checkpoint 도중 fsync 뒤에 종료 (crash)한 뒤 다시 열면 이미지 파일이 이전 또는 이번 checkpoint 시점의 볼륨인지 확인
+// 1. 이중 기록 파일을 완료 표시 전에 중단: 이중 기록을 버리고 이전 checkpoint 시점
+// 2. 완료 표시 후 이미지 파일에 쓰기 전에 중단: 이중 기록을 다시 기록하여 이번 checkpoint 시점
+// 3. 이미지 파일에 쓴 뒤 이중 기록을 비우기 전에 중단: 다시 기록해도 이번 checkpoint 시점
+// journal과 함께 사용하면 checkpoint 뒤의 변경도 crash 후 모두 적용되는지 확인
+// 각 단계는 fork한 프로세스에서 실행 (프로세스마다 새로운 메모리 mapping)
+
+#include "../asdfs.h"
+#include "../asdfs_internal.h"
+#include "stub.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+
+#define UID    1000 // 파일을 만드는 uid
+#define GID    1000 // 파일을 만드는 gid
+#define WRITE  5000 // 처음 쓰는 크기
+#define RESIZE 12345 // 두 번째 checkpoint 전에 바꾸는 크기
+#define SYNCS  3    // checkpoint 한 번의 fsync 횟수 (이중 기록, 완료 표시, 이미지 파일)
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); \
+        return 1; \
+    } \
+} while (0)
+
+static char image_path[48];
+static char side_path[64];
+static char journal_path[64];
+
+static int crash_after; // 남은 fsync 횟수가 0이 되면 fsync 직후 종료, 0이면 사용 안 함
+
+// glibc fsync를 감싸서 지정한 횟수 뒤에 종료
+int fsync(int fd) {
+    int result = (int)syscall(SYS_fsync, fd);
+    if (crash_after > 0 && --crash_after == 0) {
+        _exit(0);
+    }
+    return result;
+}
+
+// 이미지 파일 (journal이 1이면 journal도) 열기, checkpoint는 checkpoint_volume으로만 실행
+static int mount_image(int journal) {
+    stub_set_cred(UID, GID, 42);
+    CHECK(asdfs_open_image(image_path, 3600) == 0);
+    if (journal) {
+        CHECK(asdfs_open_journal(journal_path) == 0);
+    }
+    static struct fuse_conn_info conn;
+    asdfs_init(&conn);
+    return 0;
+}
+
+// 첫 번째 checkpoint에 기록하는 변경: /a/f에 WRITE 바이트
+static int first_change() {
+    CHECK(asdfs_mkdir("/a", 0755) == 0);
+    CHECK(asdfs_mknod("/a/f", S_IFREG | 0644, 0) == 0);
+    struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
+    fi.flags = O_WRONLY;
+    CHECK(asdfs_open("/a/f", &fi) == 0);
+    static char data[WRITE];
+    memset(data, 'x', WRITE);
+    CHECK(asdfs_write("/a/f", data, WRITE, 0, &fi) == WRITE);
+    CHECK(asdfs_release("/a/f", &fi) == 0);
+    return 0;
+}
+
+// 두 번째 checkpoint에 기록하는 변경: /a/f를 /a/g로 이동, 크기 변경, /b 생성
+static int second_change() {
+    CHECK(asdfs_rename("/a/f", "/a/g") == 0);
+    CHECK(asdfs_truncate("/a/g", RESIZE) == 0);
+    CHECK(asdfs_mkdir("/b", 0700) == 0);
+    return 0;
+}
+
+// path의 크기가 size이고 처음 WRITE 바이트가 first_change의 내용인지 확인
+static int check_file(const char *path, off_t size) {
+    struct stat st;
+    CHECK(asdfs_getattr(path, &st) == 0);
+    CHECK(S_ISREG(st.st_mode) && st.st_size == size);
+    struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
+    fi.flags = O_RDONLY;
+    CHECK(asdfs_open(path, &fi) == 0);
+    static char data[WRITE];
+    CHECK(asdfs_read(path, data, WRITE, 0, &fi) == WRITE);
+    for (int i=0; i<WRITE; i++) {
+        CHECK(data[i] == 'x');
+    }
+    CHECK(asdfs_release(path, &fi) == 0);
+    return 0;
+}
+
+// 첫 번째 checkpoint 시점의 볼륨인지 확인
+static int check_first() {
+    struct stat st;
+    CHECK(check_file("/a/f", WRITE) == 0);
+    CHECK(asdfs_getattr("/a/g", &st) == -ENOENT);
+    CHECK(asdfs_getattr("/b", &st) == -ENOENT);
+    return 0;
+}
+
+// 두 번째 checkpoint 시점의 볼륨인지 확인
+static int check_second() {
+    struct stat st;
+    CHECK(check_file("/a/g", RESIZE) == 0);
+    CHECK(asdfs_getattr("/a/f", &st) == -ENOENT);
+    CHECK(asdfs_getattr("/b", &st) == 0);
+    CHECK(S_ISDIR(st.st_mode) && (st.st_mode & 0777) == 0700);
+    return 0;
+}
+
+// 첫 번째 checkpoint 후 두 번째 checkpoint의 syncs번째 fsync 직후 종료
+static int crash_checkpoint(int syncs) {
+    CHECK(mount_image(0) == 0);
+    CHECK(first_change() == 0);
+    CHECK(checkpoint_volume() == NO_ERROR);
+    CHECK(second_change() == 0);
+    crash_after = syncs;
+    checkpoint_volume();
+    return 1;
+}
+
+// 다시 열어 syncs번째 fsync에서 중단된 checkpoint의 결과 확인
+static int check_crash(int syncs) {
+    CHECK(mount_image(0) == 0);
+    return syncs == 1 ? check_first() : check_second();
+}
+
+// journal과 함께 checkpoint 후 변경하고 종료 (arg는 사용 안 함)
+static int crash_journal(int arg) {
+    (void)arg;
+    CHECK(mount_image(1) == 0);
+    CHECK(first_change() == 0);
+    CHECK(checkpoint_volume() == NO_ERROR);
+    CHECK(second_change() == 0);
+    return 0;
+}
+
+// 다시 열어 checkpoint 뒤의 변경까지 모두 있는지 확인 (arg는 사용 안 함)
+static int check_journal(int arg) {
+    (void)arg;
+    CHECK(mount_image(1) == 0);
+    return check_second();
+}
+
+// fork한 프로세스에서 step(arg) 실행 후 asdfs_destroy 없이 종료, 성공하면 0 반환
+static int run(int (*step)(int), int arg) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        _exit(step(arg) == 0 ? 0 : 1);
+    }
+    int status;
+    CHECK(pid > 0 && waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    return 0;
+}
+
+// path 파일 크기, 없으면 -1
+static off_t file_size(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? st.st_size : -1;
+}
+
+// 이미지, 이중 기록, journal 파일 삭제
+static void remove_files() {
+    unlink(image_path);
+    unlink(side_path);
+    unlink(journal_path);
+}
+
+int main(int argc, char **argv) {
+    snprintf(image_path, sizeof(image_path), "/tmp/asdfs_test_checkpoint.%d", (int)getpid());
+    snprintf(side_path, sizeof(side_path), "%s.ckpt", image_path);
+    snprintf(journal_path, sizeof(journal_path), "%s.journal", image_path);
+
+    // checkpoint의 각 fsync 직후 중단, 다시 열면 이중 기록을 정리하고 이전 또는 이번 checkpoint 시점
+    for (int syncs=1; syncs<=SYNCS; syncs++) {
+        remove_files();
+        CHECK(run(crash_checkpoint, syncs) == 0);
+        CHECK(file_size(side_path) > 0);
+        CHECK(run(check_crash, syncs) == 0);
+        CHECK(file_size(side_path) == 0);
+        CHECK(run(check_crash, syncs) == 0);
+    }
+
+    // checkpoint 뒤의 변경은 journal에서 다시 적용
+    remove_files();
+    CHECK(run(crash_journal, 0) == 0);
+    CHECK(run(check_journal, 0) == 0);
+
+    remove_files();
+    printf("test_checkpoint OK\n");
+    return 0;
+}
@@ -0,0 +1,117 @@
+// low-level 복제 ioctl 회귀 테스트 (user-020)
+// 삭제한 원본 path로 복제하면 그 inode 자리를 다시 쓰는 다른 파일의 블록을 공유하지 않고 ENOENT
+// 블록 사용량 ioctl (user-021): 복제한 블록은 logical에만 더해지고 high-level과 low-level 응답이 같은지 확인
+
+#include "../asdfs.h"
+#include "../asdfs_internal.h"
+#include "../asdfs_lowlevel.h"
+#include "../asdfs_ioctl.h"
+#include "stub.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static int dummy;
+static fuse_req_t req = (fuse_req_t)&dummy; // 응답은 stub이 기록하므로 내용 없는 요청
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); \
+        return 1; \
+    } \
+} while (0)
+
+// ROOT 아래에 name 파일을 만들고 data를 쓴 뒤 inode 번호 반환, 실패하면 0
+static fuse_ino_t create_file(const char *name, const char *data) {
+    asdfs_ll_mknod(req, FUSE_ROOT_ID, name, S_IFREG | 0644, 0);
+    if (stub_reply_errno != 0) {
+        return 0;
+    }
+    fuse_ino_t ino = stub_reply_ino;
+    struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
+    fi.flags = O_WRONLY;
+    asdfs_ll_write(req, ino, data, strlen(data), 0, &fi);
+    return stub_reply_errno == 0 ? ino : 0;
+}
+
+// ino 파일에 src 파일 전체를 복제하고 응답 오류 번호 반환
+static int clone_file(fuse_ino_t ino, const char *src) {
+    static struct asdfs_clone_range range;
+    memset(&range, 0, sizeof(range));
+    strcpy(range.src_path, src);
+    struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
+    asdfs_ll_ioctl(req, ino, (int)ASDFS_IOC_CLONE_RANGE, NULL, &fi, 0, &range, sizeof(range), 0);
+    return stub_reply_errno;
+}
+
+// low-level ioctl로 블록 사용량 조회, 실패하면 logical이 0
+static struct asdfs_block_stats block_stats(fuse_ino_t ino) {
+    struct asdfs_block_stats stats;
+    memset(&stats, 0, sizeof(stats));
+    struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
+    asdfs_ll_ioctl(req, ino, (int)ASDFS_IOC_BLOCK_STATS, NULL, &fi, 0, NULL, 0, sizeof(stats));
+    if (stub_reply_errno == 0 && stub_reply_size == sizeof(stats)) {
+        memcpy(&stats, stub_reply_data, sizeof(stats));
+    }
+    return stats;
+}
+
+// ino 파일이 data로 시작하는지 여부
+static int file_equals(fuse_ino_t ino, const char *data) {
+    struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
+    asdfs_ll_read(req, ino, DATA_BLOCK_SIZE, 0, &fi);
+    return stub_reply_errno == 0 && stub_reply_size >= strlen(data) && memcmp(stub_reply_data, data, strlen(data)) == 0;
+}
+
+int main(int argc, char **argv) {
+    stub_set_cred(getuid(), getgid(), 42);
+    static struct fuse_conn_info conn;
+    asdfs_ll_init(NULL, &conn);
+
+    // /a를 /b로 복제
+    fuse_ino_t a = create_file("a", "AAAAAAAA");
+    fuse_ino_t b = create_file("b", "");
+    CHECK(a != 0 && b != 0);
+    struct asdfs_block_stats before = block_stats(b);
+    CHECK(before.logical > 0 && before.physical > 0);
+    CHECK(clone_file(b, "/a") == 0);
+    CHECK(file_equals(b, "AAAAAAAA"));
+
+    // 공유한 블록은 logical에만 더해짐, high-level 응답도 같은 값
+    struct asdfs_block_stats after = block_stats(b);
+    CHECK(after.logical == before.logical + 1);
+    CHECK(after.ratio > before.ratio);
+    struct asdfs_block_stats high;
+    memset(&high, 0, sizeof(high));
+    struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
+    CHECK(asdfs_ioctl("/b", (int)ASDFS_IOC_BLOCK_STATS, NULL, &fi, 0, &high) == 0);
+    CHECK(high.logical == after.logical && high.physical == after.physical);
+    asdfs_ll_ioctl(req, b, (int)ASDFS_IOC_BLOCK_STATS, NULL, &fi, 0, NULL, 0, sizeof(high) - 1);
+    CHECK(stub_reply_errno == EINVAL);
+
+    // /a 삭제 후 같은 inode 자리에 /secret 생성
+    asdfs_ll_forget(req, a, 1);
+    asdfs_ll_unlink(req, FUSE_ROOT_ID, "a");
+    CHECK(stub_reply_errno == 0);
+    fuse_ino_t secret = create_file("secret", "SECRET!!");
+    CHECK(secret != 0);
+
+    // 삭제한 path로는 복제할 수 없고 /b의 내용은 그대로
+    CHECK(clone_file(b, "/a") == ENOENT);
+    CHECK(file_equals(b, "AAAAAAAA"));
+
+    // 이름을 바꾼 원본도 이전 path로는 찾지 않음
+    asdfs_ll_rename(req, FUSE_ROOT_ID, "secret", FUSE_ROOT_ID, "moved");
+    CHECK(stub_reply_errno == 0);
+    CHECK(clone_file(b, "/secret") == ENOENT);
+    CHECK(clone_file(b, "/moved") == 0);
+    CHECK(file_equals(b, "SECRET!!"));
+
+    printf("test_clone OK\n");
+    return 0;
+}
@@ -0,0 +1,240 @@
+// 블록 압축 테스트 (user-022)
+// 임의의 내용, 0, 반복되는 내용의 블록을 압축했다가 풀면 같은 내용인지 확인
+// 손상되거나 잘린 압축 내용, 크기가 다른 요청은 -1을 반환하고 출력 범위 밖에는 쓰지 않는지 확인
+// 압축된 블록의 메모리를 반환하고 pack을 정리한 (다른 pack으로 옮긴) 뒤에도 같은 내용을 읽는지 확인
+
+#include "../asdfs.h"
+#include "../asdfs_internal.h"
+#include "../asdfs_compress.h"
+#include "stub.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define BLOCK   4096 // 압축하는 블록 크기 (DATA_BLOCK_SIZE)
+#define GUARD   64   // 출력 버퍼 뒤에 두어 범위 밖 쓰기를 확인하는 바이트 수
+#define FLIPS   2000 // 임의로 바꿔 보는 압축 내용 개수
+#define BLOCKS  512  // 파일에 쓰는 블록 개수
+#define STEP    8    // 구멍을 낸 뒤 남기는 블록 간격
+#define WAIT_MS 20000 // 압축 스레드를 기다리는 최대 시간
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); \
+        return 1; \
+    } \
+} while (0)
+
+// 반복되는 단어로 채운 블록 (seed마다 다른 순서)
+static void text_block(char *block, unsigned seed) {
+    static const char *words[] = { "the ", "file ", "system ", "block ", "inode ", "pack ", "of ", "data\n" };
+    int pos = 0;
+    while (pos < BLOCK) {
+        seed = seed * 1103515245 + 12345;
+        const char *word = words[(seed >> 16) % 8];
+        int length = (int)strlen(word);
+        if (pos + length > BLOCK) {
+            length = BLOCK - pos;
+        }
+        memcpy(block + pos, word, length);
+        pos += length;
+    }
+}
+
+// 한 글자로 채우고 앞에 seed를 적은 블록 (매우 작게 압축되어 pack 하나에 많은 블록이 들어감)
+static void stamp_block(char *block, unsigned seed) {
+    memset(block, 'a' + seed % 26, BLOCK);
+    snprintf(block, 32, "%u", seed);
+}
+
+// 임의의 값으로 채운 블록
+static void random_block(char *block, unsigned seed) {
+    for (int i=0; i<BLOCK; i++) {
+        seed = seed * 1103515245 + 12345;
+        block[i] = (char)(seed >> 16);
+    }
+}
+
+// 압축 내용 zip (size 바이트)을 capacity 바이트로 풀고 결과 반환, 출력 버퍼 뒤가 그대로인지 guard로 반환
+static int unpack(const char *zip, size_t size, char *out, size_t capacity, int *guard) {
+    memset(out + capacity, 0xA5, GUARD);
+    int result = decompress_data(zip, size, out, capacity);
+    *guard = 1;
+    for (int i=0; i<GUARD; i++) {
+        if ((unsigned char)out[capacity + i] != 0xA5) {
+            *guard = 0;
+        }
+    }
+    return result;
+}
+
+// block을 압축했다가 풀어 같은 내용인지, 잘리거나 크기가 다르면 거부하는지 확인
+// 압축한 크기를 size 포인터로 반환
+static int check_round_trip(const char *block, size_t *size) {
+    static char zip[2 * BLOCK];
+    static char out[BLOCK + 1 + GUARD];
+    int guard;
+
+    *size = compress_data(block, BLOCK, zip, sizeof(zip));
+    CHECK(*size > 0);
+    CHECK(unpack(zip, *size, out, BLOCK, &guard) == 0 && guard);
+    CHECK(memcmp(out, block, BLOCK) == 0);
+
+    // 요청한 크기와 풀린 크기가 다르면 거부
+    CHECK(unpack(zip, *size, out, BLOCK - 1, &guard) == -1 && guard);
+    CHECK(unpack(zip, *size, out, BLOCK + 1, &guard) == -1 && guard);
+
+    // 잘린 내용은 거부 (마지막 sequence가 literal 없이 token만 있으면 마지막 1 B가 없어도 같은 내용)
+    for (size_t length = 0; length + 1 < *size; length++) {
+        CHECK(unpack(zip, length, out, BLOCK, &guard) == -1 && guard);
+    }
+    return 0;
+}
+
+// 압축 코덱 확인: 내용별 round-trip, 손상된 내용 거부
+static int check_codec() {
+    static char block[BLOCK];
+    static char zip[2 * BLOCK];
+    static char out[BLOCK + GUARD];
+    size_t size;
+    int guard;
+
+    // 임의의 내용은 압축되지 않아도 충분한 capacity면 그대로 풀림, 작은 capacity면 0
+    random_block(block, 1);
+    CHECK(check_round_trip(block, &size) == 0);
+    CHECK(compress_data(block, BLOCK, zip, BLOCK / 2) == 0);
+
+    // 0과 반복되는 내용은 작게 압축됨
+    memset(block, 0, BLOCK);
+    CHECK(check_round_trip(block, &size) == 0);
+    CHECK(size < BLOCK / 64);
+    text_block(block, 2);
+    CHECK(check_round_trip(block, &size) == 0);
+    CHECK(size < BLOCK / 2);
+
+    // 첫 일치의 거리를 0이나 이미 푼 크기보다 크게 바꾸면 거부
+    // 첫 sequence: token, literal 길이 추가 바이트 (literal 길이가 15 이상), literal, 거리 2 B
+    size = compress_data(block, BLOCK, zip, sizeof(zip));
+    size_t literal = (unsigned char)zip[0] >> 4;
+    size_t pos = 1;
+    if (literal == 15) {
+        unsigned char byte;
+        do {
+            byte = (unsigned char)zip[pos++];
+            literal += byte;
+        } while (byte == 255);
+    }
+    pos += literal;
+    CHECK(pos + 2 <= size);
+    char saved[2] = { zip[pos], zip[pos + 1] };
+    zip[pos] = 0;
+    zip[pos + 1] = 0;
+    CHECK(unpack(zip, size, out, BLOCK, &guard) == -1 && guard);
+    zip[pos] = (char)((literal + 1) & 0xFF);
+    zip[pos + 1] = (char)((literal + 1) >> 8);
+    CHECK(unpack(zip, size, out, BLOCK, &guard) == -1 && guard);
+    zip[pos] = saved[0];
+    zip[pos + 1] = saved[1];
+
+    // 모두 255인 내용 (끝나지 않는 길이)은 거부
+    static char broken[64];
+    memset(broken, 0xFF, sizeof(broken));
+    CHECK(unpack(broken, sizeof(broken), out, BLOCK, &guard) == -1 && guard);
+
+    // 임의의 바이트를 바꾼 내용은 풀리든 거부되든 출력 범위 밖에 쓰지 않음
+    static char damaged[2 * BLOCK];
+    unsigned seed = 3;
+    for (int i=0; i<FLIPS; i++) {
+        memcpy(damaged, zip, size);
+        for (int j=0; j<1 + i % 4; j++) {
+            seed = seed * 1103515245 + 12345;
+            damaged[(seed >> 8) % size] ^= (char)(1 + (seed >> 24) % 255);
+        }
+        int result = unpack(damaged, size, out, BLOCK, &guard);
+        CHECK((result == 0 || result == -1) && guard);
+    }
+    return 0;
+}
+
+// 압축 스레드가 want개 이상의 블록을 압축할 때까지 대기 (최대 WAIT_MS)
+static int wait_packed(unsigned long want) {
+    for (int ms=0; ms<WAIT_MS; ms+=100) {
+        if (get_zip_stats().blocks >= want) {
+            return 0;
+        }
+        usleep(100000);
+    }
+    return -1;
+}
+
+// pack 사이에서 블록이 옮겨질 때까지 대기 (최대 WAIT_MS)
+static int wait_moved() {
+    for (int ms=0; ms<WAIT_MS; ms+=100) {
+        if (get_zip_stats().moved > 0) {
+            return 0;
+        }
+        usleep(100000);
+    }
+    return -1;
+}
+
+// /z의 블록 BLOCKS개 확인: 구멍을 낸 블록 (step이 0이 아니면 step개 중 첫 블록이 아닌 블록)은 0, 나머지는 stamp_block
+static int check_file(struct fuse_file_info *fi, int step) {
+    static char expect[BLOCK], got[BLOCK];
+    for (int i=0; i<BLOCKS; i++) {
+        if (step && i % step != 0) {
+            memset(expect, 0, BLOCK);
+        }
+        else {
+            stamp_block(expect, i);
+        }
+        CHECK(asdfs_read("/z", got, BLOCK, (off_t)i * BLOCK, fi) == BLOCK);
+        CHECK(memcmp(got, expect, BLOCK) == 0);
+    }
+    return 0;
+}
+
+// 압축된 블록의 메모리를 반환하고 pack을 정리한 뒤 읽기 확인
+static int check_reclaim() {
+    CHECK(asdfs_mknod("/z", S_IFREG | 0644, 0) == 0);
+    struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
+    fi.flags = O_WRONLY;
+    CHECK(asdfs_open("/z", &fi) == 0);
+    static char block[BLOCK];
+    for (int i=0; i<BLOCKS; i++) {
+        stamp_block(block, i);
+        CHECK(asdfs_write("/z", block, BLOCK, (off_t)i * BLOCK, &fi) == BLOCK);
+    }
+
+    // 모두 압축된 뒤 블록 메모리가 반환되는 다음 주기까지 대기
+    CHECK(wait_packed(BLOCKS) == 0);
+    sleep(2);
+    CHECK(get_zip_stats().packs > 1);
+    CHECK(check_file(&fi, 0) == 0);
+
+    // STEP개 중 첫 블록만 남기고 구멍을 내면 pack이 대부분 비어 남은 블록이 다른 pack으로 옮겨짐
+    for (int i=0; i<BLOCKS; i++) {
+        if (i % STEP != 0) {
+            CHECK(asdfs_fallocate("/z", FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, (off_t)i * BLOCK, BLOCK, &fi) == 0);
+        }
+    }
+    CHECK(wait_moved() == 0);
+    sleep(2);
+    CHECK(check_file(&fi, STEP) == 0);
+    CHECK(asdfs_unlink("/z") == 0);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    stub_set_cred(getuid(), getgid(), 42);
+    CHECK(check_codec() == 0);
+
+    CHECK(asdfs_enable_compress(1) == 0);
+    static struct fuse_conn_info conn;
+    asdfs_init(&conn);
+    CHECK(check_reclaim() == 0);
+
+    printf("test_compress OK\n");
+    return 0;
+}
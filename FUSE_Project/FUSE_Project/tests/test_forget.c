@@ -0,0 +1,86 @@
+// 같은 inode의 lookup 횟수를 여러 스레드가 동시에 늘리고 줄이는 동안 파일을 지우는 테스트 (user-004)
+// 횟수가 0이 될 때 inode가 정확히 한 번 삭제되는지 (남거나 두 번 반환되지 않는지) 빈 inode 개수로 확인
+
+#include "../asdfs.h"
+#include "../asdfs_internal.h"
+#include "stub.h"
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define FILES   8    // 한 번에 만드는 파일 개수
+#define THREADS 4    // lookup 횟수를 바꾸는 스레드 개수
+#define REFS    2000 // 스레드마다 파일 하나에 남기는 lookup 횟수
+#define ROUNDS  100  // 반복 횟수
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); \
+        return 1; \
+    } \
+} while (0)
+
+static inode *nodes[FILES]; // 현재 반복에서 만든 파일
+static volatile int failed; // 스레드에서 확인이 실패한 횟수
+
+// 파일마다 lookup을 한 번 늘리고 두 번 줄이기를 반복 (스레드마다 REFS만큼 감소)
+static void *forgetter(void *arg) {
+    for (int i=0; i<REFS; i++) {
+        for (int j=0; j<FILES; j++) {
+            ref_inode(nodes[j]);
+            forget_inode(nodes[j], 1);
+            forget_inode(nodes[j], 1);
+        }
+    }
+    return NULL;
+}
+
+// 파일을 모두 지움 (커널이 참조 중이면 orphan 목록으로 이동)
+static void *remover(void *arg) {
+    char path[32];
+    for (int j=0; j<FILES; j++) {
+        sprintf(path, "/d/f%d", j);
+        if (asdfs_unlink(path) != 0) {
+            __sync_fetch_and_add(&failed, 1);
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    stub_set_cred(getuid(), getgid(), 42);
+    static struct fuse_conn_info conn;
+    asdfs_init(&conn);
+    CHECK(asdfs_mkdir("/d", 0755) == 0);
+    fsblkcnt_t files = get_superblock().f_ffree;
+
+    for (int r=0; r<ROUNDS; r++) {
+        // 파일을 만들고 모든 스레드가 줄일 만큼 lookup 횟수 증가
+        char path[32];
+        for (int j=0; j<FILES; j++) {
+            sprintf(path, "/d/f%d", j);
+            CHECK(asdfs_mknod(path, S_IFREG | 0644, 0) == 0);
+            struct fuse_file_info fi;
+            memset(&fi, 0, sizeof(fi));
+            CHECK(asdfs_open(path, &fi) == 0);
+            nodes[j] = (inode *)fi.fh;
+            for (int i=0; i<THREADS * REFS; i++) {
+                ref_inode(nodes[j]);
+            }
+        }
+
+        pthread_t threads[THREADS + 1];
+        for (int i=0; i<THREADS; i++) {
+            CHECK(pthread_create(&threads[i], NULL, forgetter, NULL) == 0);
+        }
+        CHECK(pthread_create(&threads[THREADS], NULL, remover, NULL) == 0);
+        for (int i=0; i<=THREADS; i++) {
+            pthread_join(threads[i], NULL);
+        }
+        CHECK(failed == 0);
+        CHECK(get_superblock().f_ffree == files);
+    }
+
+    printf("test_forget OK\n");
+    return 0;
+}
@@ -0,0 +1,152 @@
+// metadata journal 테스트 (user-018)
+// 이미지 파일 없이 journal만 사용하고 asdfs_destroy 없이 종료 (crash)한 뒤 다시 열어 변경이 모두 적용되는지 확인
+// journal 마지막 기록의 중간까지만 남기면 그 앞의 변경만 적용되고 journal이 기록 경계로 잘리는지 확인
+// 각 단계는 fork한 프로세스에서 실행 (프로세스마다 새로운 메모리 볼륨)
+
+#include "../asdfs.h"
+#include "../asdfs_internal.h"
+#include "stub.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define UID   1000  // 파일을 만드는 uid
+#define GID   1000  // 파일을 만드는 gid
+#define WRITE 5000  // 쓰기 크기
+#define SPOT  20000 // 파일 크기를 늘리는 쓰기 위치
+#define TORN  5     // 마지막 기록에서 잘라내는 바이트 수
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); \
+        return 1; \
+    } \
+} while (0)
+
+static char journal_path[64];
+
+// journal을 열고 다시 적용
+static int mount_journal() {
+    stub_set_cred(UID, GID, 42);
+    CHECK(asdfs_open_journal(journal_path) == 0);
+    static struct fuse_conn_info conn;
+    asdfs_init(&conn);
+    return 0;
+}
+
+// 이름 공간, 권한, 소유자, 시간, 크기를 바꾸는 변경
+static int change() {
+    CHECK(asdfs_mkdir("/a", 0755) == 0);
+    CHECK(asdfs_mknod("/a/f", S_IFREG | 0640, 0) == 0);
+    CHECK(asdfs_chmod("/a/f", S_IFREG | 0600) == 0);
+    CHECK(asdfs_truncate("/a/f", 12345) == 0);
+    CHECK(asdfs_rename("/a/f", "/a/g") == 0);
+    struct timespec times[2] = { { 111, 0 }, { 222, 0 } };
+    CHECK(asdfs_utimens("/a/g", times) == 0);
+    CHECK(asdfs_mknod("/a/h", S_IFREG | 0644, 0) == 0);
+    CHECK(asdfs_unlink("/a/h") == 0);
+    CHECK(asdfs_mkdir("/b", 0755) == 0);
+    CHECK(asdfs_rmdir("/b") == 0);
+    stub_set_cred(0, 0, 1);
+    CHECK(asdfs_chown("/a/g", 7, 8) == 0);
+    stub_set_cred(7, 8, 44);
+
+    // 쓰기로 늘어난 크기는 fsync에서 디스크에 기록
+    struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
+    fi.flags = O_WRONLY;
+    CHECK(asdfs_open("/a/g", &fi) == 0);
+    static char data[WRITE];
+    memset(data, 'x', WRITE);
+    CHECK(asdfs_write("/a/g", data, WRITE, SPOT, &fi) == WRITE);
+    CHECK(asdfs_fsync("/a/g", 0, &fi) == 0);
+    CHECK(asdfs_release("/a/g", &fi) == 0);
+    stub_set_cred(UID, GID, 42);
+    return 0;
+}
+
+// change의 변경이 모두 적용되었는지 확인
+static int check_change() {
+    struct stat st;
+    CHECK(asdfs_getattr("/a", &st) == 0);
+    CHECK(S_ISDIR(st.st_mode) && (st.st_mode & 0777) == 0755 && st.st_uid == UID);
+    CHECK(asdfs_getattr("/a/g", &st) == 0);
+    CHECK(S_ISREG(st.st_mode) && (st.st_mode & 0777) == 0600);
+    CHECK(st.st_size == SPOT + WRITE);
+    CHECK(st.st_uid == 7 && st.st_gid == 8);
+    CHECK(st.st_atime == 111 && st.st_mtime == 222);
+    CHECK(asdfs_getattr("/a/f", &st) == -ENOENT);
+    CHECK(asdfs_getattr("/a/h", &st) == -ENOENT);
+    CHECK(asdfs_getattr("/b", &st) == -ENOENT);
+    return 0;
+}
+
+// fork한 프로세스에서 step 실행 후 asdfs_destroy 없이 종료, 성공하면 0 반환
+static int run(int (*step)()) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        _exit(mount_journal() == 0 && step() == 0 ? 0 : 1);
+    }
+    int status;
+    CHECK(pid > 0 && waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    return 0;
+}
+
+// 다시 적용한 뒤 마지막 변경 추가
+static int check_and_append() {
+    CHECK(check_change() == 0);
+    struct stat st;
+    CHECK(asdfs_getattr("/last", &st) == -ENOENT);
+    CHECK(asdfs_mkdir("/last", 0700) == 0);
+    return 0;
+}
+
+// 마지막 변경이 있는지 확인
+static int check_appended() {
+    CHECK(check_change() == 0);
+    struct stat st;
+    CHECK(asdfs_getattr("/last", &st) == 0);
+    CHECK(S_ISDIR(st.st_mode) && (st.st_mode & 0777) == 0700);
+    return 0;
+}
+
+// 잘린 마지막 변경은 없고 그 앞의 변경은 모두 있는지 확인
+static int check_torn() {
+    CHECK(check_change() == 0);
+    struct stat st;
+    CHECK(asdfs_getattr("/last", &st) == -ENOENT);
+    return 0;
+}
+
+// path 파일 크기, 없으면 -1
+static off_t file_size(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? st.st_size : -1;
+}
+
+int main(int argc, char **argv) {
+    snprintf(journal_path, sizeof(journal_path), "/tmp/asdfs_test_journal.%d", (int)getpid());
+    unlink(journal_path);
+
+    // 변경 후 crash, 다시 적용하면 모두 있음
+    CHECK(run(change) == 0);
+    off_t boundary = file_size(journal_path);
+    CHECK(boundary > 0);
+    CHECK(run(check_and_append) == 0);
+    off_t full = file_size(journal_path);
+    CHECK(full > boundary + TORN);
+    CHECK(run(check_appended) == 0);
+
+    // 마지막 기록의 중간까지만 남기면 그 기록만 버리고 기록 경계로 자름
+    CHECK(truncate(journal_path, full - TORN) == 0);
+    CHECK(run(check_torn) == 0);
+    CHECK(file_size(journal_path) == boundary);
+    CHECK(run(check_torn) == 0);
+
+    unlink(journal_path);
+    printf("test_journal OK\n");
+    return 0;
+}
@@ -0,0 +1,137 @@
+// 같은 디렉터리에서 동시에 만들고 지우고 찾고 목록을 읽는 테스트 (user-001)
+// 스레드 WORKERS개가 /d 아래에 FILES개씩 만들며 하나 걸러 지우고, 다른 스레드가 계속 찾고 목록을 나누어 읽음
+// 끝나면 남아야 하는 이름만 있고 목록의 cookie가 순서대로 증가하는지 확인
+
+#include "../asdfs.h"
+#include "../asdfs_internal.h"
+#include "stub.h"
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define WORKERS 4    // 만들고 지우는 스레드 개수
+#define FILES   5000 // 스레드마다 만드는 파일 개수
+#define PAGE    64   // readdir 한 번에 받는 항목 개수
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); \
+        return 1; \
+    } \
+} while (0)
+
+static volatile int workers_done; // 끝난 만들고 지우는 스레드 개수
+static volatile int failed;       // 스레드에서 확인이 실패한 횟수
+
+// readdir 한 번의 결과: 받은 항목 개수, 마지막 cookie, cookie가 줄어든 횟수
+typedef struct page page;
+struct page {
+    int count;
+    off_t last;
+    int unordered;
+};
+
+// 한 번에 PAGE개까지 받고 cookie 순서 확인
+static int fill_page(void *buf, const char *name, const struct stat *st, off_t off) {
+    page *p = (page *)buf;
+    if (p->count == PAGE) {
+        return 1;
+    }
+    if (off <= p->last) {
+        p->unordered++;
+    }
+    p->last = off;
+    p->count++;
+    return 0;
+}
+
+// /d 목록을 PAGE개씩 끝까지 읽고 항목 개수 반환 ("."과 ".." 포함), cookie가 줄어들면 -1
+static int list_dir() {
+    struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
+    if (asdfs_opendir("/d", &fi) != 0) {
+        return -1;
+    }
+    int total = 0;
+    off_t off = 0;
+    for (;;) {
+        page p = { 0, off, 0 };
+        if (asdfs_readdir("/d", &p, fill_page, off, &fi) != 0 || p.unordered) {
+            return -1;
+        }
+        total += p.count;
+        if (p.count < PAGE) {
+            return total;
+        }
+        off = p.last;
+    }
+}
+
+// 만들고 하나 걸러 지우는 스레드
+static void *worker(void *arg) {
+    long w = (long)arg;
+    char path[64];
+    for (int i=0; i<FILES; i++) {
+        sprintf(path, "/d/w%ld_%d", w, i);
+        if (asdfs_mknod(path, S_IFREG | 0644, 0) != 0) {
+            __sync_fetch_and_add(&failed, 1);
+        }
+        if (i % 2 == 1) {
+            sprintf(path, "/d/w%ld_%d", w, i - 1);
+            if (asdfs_unlink(path) != 0) {
+                __sync_fetch_and_add(&failed, 1);
+            }
+        }
+    }
+    __sync_fetch_and_add(&workers_done, 1);
+    return NULL;
+}
+
+// 만들어진 이름을 찾고 목록을 읽는 스레드
+static void *reader(void *arg) {
+    char path[64];
+    struct stat st;
+    unsigned seed = 1;
+    while (workers_done < WORKERS) {
+        sprintf(path, "/d/w%d_%d", rand_r(&seed) % WORKERS, rand_r(&seed) % FILES);
+        int result = asdfs_getattr(path, &st);
+        if (result != 0 && result != -ENOENT) {
+            __sync_fetch_and_add(&failed, 1);
+        }
+        if (rand_r(&seed) % 64 == 0 && list_dir() < 0) {
+            __sync_fetch_and_add(&failed, 1);
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    stub_set_cred(getuid(), getgid(), 42);
+    static struct fuse_conn_info conn;
+    asdfs_init(&conn);
+    CHECK(asdfs_mkdir("/d", 0755) == 0);
+
+    pthread_t threads[WORKERS + 1];
+    for (long w=0; w<WORKERS; w++) {
+        CHECK(pthread_create(&threads[w], NULL, worker, (void *)w) == 0);
+    }
+    CHECK(pthread_create(&threads[WORKERS], NULL, reader, NULL) == 0);
+    for (int i=0; i<=WORKERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    CHECK(failed == 0);
+
+    // 홀수 번째 파일만 남음
+    char path[64];
+    struct stat st;
+    for (int w=0; w<WORKERS; w++) {
+        for (int i=0; i<FILES; i++) {
+            sprintf(path, "/d/w%d_%d", w, i);
+            CHECK(asdfs_getattr(path, &st) == (i % 2 == 1 ? 0 : -ENOENT));
+        }
+    }
+    CHECK(list_dir() == WORKERS * FILES / 2 + 2);
+
+    printf("test_namespace OK\n");
+    return 0;
+}
@@ -0,0 +1,247 @@
+// 목록을 나누어 읽는 사이에 항목을 지우고 만드는 테스트 (user-010)
+// 첫 부분을 읽은 뒤 마지막으로 받은 항목 (cookie 위치), 그 다음 항목들, 이미 받은 항목을 지우고 새 항목을 만듦
+// 이어서 읽은 목록에 남은 항목이 빠짐없이 한 번씩 순서대로 있고 지운 항목은 없는지 확인
+// high-level (asdfs_readdir)과 low-level (asdfs_ll_readdir) 모두 확인
+// 목록은 이름의 바이트 값 순서이고, 같은 이웃 사이에 계속 만들어 순서 번호를 다시 붙여도 순서가 유지되는지 확인 (user-008)
+
+#include "../asdfs.h"
+#include "../asdfs_internal.h"
+#include "../asdfs_lowlevel.h"
+#include "stub.h"
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define ENTRIES 300 // 처음 만드는 항목 개수
+#define ADDED   20  // 읽는 도중 만드는 항목 개수
+#define PAGE    64  // readdir 한 번에 받는 항목 개수
+#define NAME_LEN 4  // 항목 이름 길이 (low-level 응답 크기 계산)
+#define NESTED  100 // 같은 이웃 사이에 만드는 항목 개수 (순서 번호 다시 붙이기 확인)
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); \
+        return 1; \
+    } \
+} while (0)
+
+static int dummy;
+static fuse_req_t req = (fuse_req_t)&dummy; // 응답은 stub이 기록하므로 내용 없는 요청
+
+static struct fuse_file_info dir_fi; // high-level opendir 결과
+static fuse_ino_t dir_ino;           // low-level로 읽는 디렉터리 inode 번호
+
+// readdir 한 번의 결과
+typedef struct page page;
+struct page {
+    int count;                 // 받은 항목 개수 ("."과 ".." 제외)
+    char names[PAGE][16];      // 항목 이름 (앞 15 B)
+    off_t last;                // 마지막 항목의 cookie
+    int received;              // "."과 ".."을 포함하여 받은 항목 개수
+};
+
+// 한 번에 PAGE개까지 받음
+static int fill_page(void *buf, const char *name, const struct stat *st, off_t off) {
+    page *p = (page *)buf;
+    if (p->received == PAGE) {
+        return 1;
+    }
+    p->received++;
+    p->last = off;
+    if (strcmp(name, ".") != 0 && strcmp(name, "..") != 0) {
+        snprintf(p->names[p->count++], sizeof(p->names[0]), "%s", name); // 긴 이름은 앞부분만
+    }
+    return 0;
+}
+
+// high-level로 /d의 off 다음부터 한 번 읽음
+static void read_hl(off_t off, page *p) {
+    asdfs_readdir("/d", p, fill_page, off, &dir_fi);
+}
+
+// low-level로 dir_ino의 off 다음부터 한 번 읽음 (응답 크기는 PAGE개 항목)
+static void read_ll(off_t off, page *p) {
+    size_t entry = (24 + NAME_LEN + 7) & ~(size_t)7;
+    asdfs_ll_readdir(req, dir_ino, entry * PAGE, off, NULL);
+    for (size_t pos=0; stub_reply_errno == 0 && pos < stub_reply_size; ) {
+        uint64_t next;
+        uint32_t length;
+        char name[16];
+        memcpy(&next, stub_reply_data + pos + 8, 8);
+        memcpy(&length, stub_reply_data + pos + 16, 4);
+        memcpy(name, stub_reply_data + pos + 24, length);
+        name[length] = '\0';
+        fill_page(p, name, NULL, (off_t)next);
+        pos += (24 + length + 7) & ~(size_t)7;
+    }
+}
+
+// 항목 만들기, 지우기 (prefix 아래 이름)
+static int make(int lowlevel, const char *name) {
+    if (lowlevel) {
+        asdfs_ll_mknod(req, dir_ino, name, S_IFREG | 0644, 0);
+        return stub_reply_errno;
+    }
+    char path[32];
+    sprintf(path, "/d/%s", name);
+    return asdfs_mknod(path, S_IFREG | 0644, 0);
+}
+
+static int drop(int lowlevel, const char *name) {
+    if (lowlevel) {
+        asdfs_ll_unlink(req, dir_ino, name);
+        return stub_reply_errno;
+    }
+    char path[32];
+    sprintf(path, "/d/%s", name);
+    return asdfs_unlink(path);
+}
+
+// 목록 전체를 한 번에 PAGE개씩 읽어 names에 순서대로 기록, 항목 개수 반환
+static int read_all(void (*read)(off_t, page *), off_t off, char (*names)[16], int max) {
+    int total = 0;
+    for (;;) {
+        page p;
+        memset(&p, 0, sizeof(p));
+        read(off, &p);
+        for (int i=0; i<p.count && total < max; i++) {
+            strcpy(names[total++], p.names[i]);
+        }
+        if (p.received < PAGE) {
+            return total;
+        }
+        off = p.last;
+    }
+}
+
+// 한 frontend로 나누어 읽는 도중 지우고 만든 결과 확인
+static int check_frontend(int lowlevel) {
+    void (*read)(off_t, page *) = lowlevel ? read_ll : read_hl;
+    static char order[ENTRIES][16];
+    static char rest[ENTRIES + ADDED][16];
+    char name[16];
+
+    for (int i=0; i<ENTRIES; i++) {
+        sprintf(name, "f%03d", i);
+        CHECK(make(lowlevel, name) == 0);
+    }
+    CHECK(read_all(read, 0, order, ENTRIES) == ENTRIES);
+    for (int i=1; i<ENTRIES; i++) {
+        CHECK(strcmp(order[i - 1], order[i]) < 0);
+    }
+
+    // 첫 부분 읽기
+    page first;
+    memset(&first, 0, sizeof(first));
+    read(0, &first);
+    CHECK(first.received == PAGE);
+    int seen = first.count;
+    for (int i=0; i<seen; i++) {
+        CHECK(strcmp(first.names[i], order[i]) == 0);
+    }
+
+    // cookie 위치 항목, 그 다음 5개, 이미 받은 항목 하나를 지우고 새 항목 생성
+    CHECK(drop(lowlevel, order[seen - 1]) == 0);
+    for (int i=seen; i<seen + 5; i++) {
+        CHECK(drop(lowlevel, order[i]) == 0);
+    }
+    CHECK(drop(lowlevel, order[10]) == 0);
+    for (int i=0; i<ADDED; i++) {
+        sprintf(name, "g%03d", i);
+        CHECK(make(lowlevel, name) == 0);
+    }
+
+    // 이어서 읽으면 남은 기존 항목이 순서대로 한 번씩, 새 항목은 많아야 한 번씩
+    int count = read_all(read, first.last, rest, ENTRIES + ADDED);
+    int next = seen + 5;
+    int added = 0;
+    for (int i=0; i<count; i++) {
+        if (rest[i][0] == 'g') {
+            for (int j=0; j<i; j++) {
+                CHECK(strcmp(rest[j], rest[i]) != 0);
+            }
+            added++;
+            continue;
+        }
+        CHECK(next < ENTRIES && strcmp(rest[i], order[next]) == 0);
+        next++;
+    }
+    CHECK(next == ENTRIES);
+    CHECK(added <= ADDED);
+
+    // 정리
+    for (int i=0; i<ENTRIES; i++) {
+        if (i == 10 || (i >= seen - 1 && i < seen + 5)) {
+            continue;
+        }
+        CHECK(drop(lowlevel, order[i]) == 0);
+    }
+    for (int i=0; i<ADDED; i++) {
+        sprintf(name, "g%03d", i);
+        CHECK(drop(lowlevel, name) == 0);
+    }
+    return 0;
+}
+
+// "a"와 바로 전에 만든 항목 사이에 계속 만들어 (b, ab, aab, ...) 이웃 사이의 번호가 부족해지게 함
+// 목록이 이름 순서대로 빠짐없이 나오고 cookie가 증가하는지 확인
+static int check_nested() {
+    static char names[NESTED + 2][NESTED + 2];
+    static char listed[NESTED + 2][16];
+    char path[NESTED + 8];
+    CHECK(asdfs_mkdir("/n", 0755) == 0);
+    CHECK(asdfs_mknod("/n/a", S_IFREG | 0644, 0) == 0);
+    for (int i=0; i<NESTED; i++) {
+        memset(names[i], 'a', i);
+        names[i][i] = 'b';
+        names[i][i + 1] = '\0';
+        sprintf(path, "/n/%s", names[i]);
+        CHECK(asdfs_mknod(path, S_IFREG | 0644, 0) == 0);
+    }
+
+    struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
+    CHECK(asdfs_opendir("/n", &fi) == 0);
+    off_t off = 0;
+    off_t previous = 0;
+    int total = 0;
+    for (;;) {
+        page p;
+        memset(&p, 0, sizeof(p));
+        CHECK(asdfs_readdir("/n", &p, fill_page, off, &fi) == 0);
+        CHECK(p.received == 0 || p.last > previous);
+        for (int i=0; i<p.count; i++) {
+            // 이름이 길어 앞 15 B만 비교
+            CHECK(total < NESTED + 1);
+            memcpy(listed[total++], p.names[i], 16);
+        }
+        if (p.received < PAGE) {
+            break;
+        }
+        previous = off = p.last;
+    }
+    CHECK(total == NESTED + 1);
+    CHECK(strcmp(listed[0], "a") == 0);
+    for (int i=1; i<total; i++) {
+        CHECK(strncmp(listed[i], names[NESTED - i], 15) == 0);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    stub_set_cred(getuid(), getgid(), 42);
+    static struct fuse_conn_info conn;
+    asdfs_init(&conn);
+
+    CHECK(asdfs_mkdir("/d", 0755) == 0);
+    CHECK(asdfs_opendir("/d", &dir_fi) == 0);
+    CHECK(check_frontend(0) == 0);
+
+    asdfs_ll_mkdir(req, FUSE_ROOT_ID, "l", 0755);
+    CHECK(stub_reply_errno == 0);
+    dir_ino = stub_reply_ino;
+    CHECK(check_frontend(1) == 0);
+    CHECK(check_nested() == 0);
+
+    printf("test_readdir OK\n");
+    return 0;
+}